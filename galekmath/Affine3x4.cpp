@@ -0,0 +1,186 @@
+/* Copyright (C) 2009-2020, Nick Galko Ltd. All rights reserved.
+*
+* This file is part of the NGTech (https://galek.github.io/portfolio/).
+*
+* Your use and or redistribution of this software in source and / or
+* binary form, with or without modification, is subject to: (i) your
+* ongoing acceptance of and compliance with the terms and conditions of
+* the NGTech License Agreement; and (ii) your inclusion of this notice
+* in any version of this software that you use or redistribute.
+* A copy of the NGTech License Agreement is available by contacting
+* Nick Galko Ltd. at https://galek.github.io/portfolio/
+*/
+//***************************************************************************
+#include "Affine3x4.h"
+#include "SIMD.h"
+//***************************************************************************
+
+namespace NGTech
+{
+	/**/
+	const Affine3x4 Affine3x4::IDENTITY(
+		1, 0, 0, 0,
+		0, 1, 0, 0,
+		0, 0, 1, 0);
+
+	/*
+	*/
+	Affine3x4::Affine3x4(const Mat4& m)
+		: e{ m.e[0], m.e[4], m.e[8], m.e[12],
+		m.e[1], m.e[5], m.e[9], m.e[13],
+		m.e[2], m.e[6], m.e[10], m.e[14] }
+	{}
+
+	Mat4 Affine3x4::ToMat4() const {
+		return Mat4(e[0], e[1], e[2], e[3],
+			e[4], e[5], e[6], e[7],
+			e[8], e[9], e[10], e[11],
+			0, 0, 0, 1);
+	}
+
+	/*
+	Row r of A * B = A[r][0] * B.row0 + A[r][1] * B.row1 + A[r][2] * B.row2 + (0, 0, 0, A[r][3])
+	*/
+	static void _MulScalar(float* r, const float* a, const float* b) {
+		for (int row = 0; row < 12; row += 4) {
+			const float* ar = a + row;
+			r[row + 0] = ar[0] * b[0] + ar[1] * b[4] + ar[2] * b[8];
+			r[row + 1] = ar[0] * b[1] + ar[1] * b[5] + ar[2] * b[9];
+			r[row + 2] = ar[0] * b[2] + ar[1] * b[6] + ar[2] * b[10];
+			r[row + 3] = ar[0] * b[3] + ar[1] * b[7] + ar[2] * b[11] + ar[3];
+		}
+	}
+
+	/*
+	Columns of the inverse 3x3 are cross products of the rows, translation is -M^-1 * t
+	*/
+	static void _InverseScalar(float* r, const float* m) {
+		Vec3 r0(m[0], m[1], m[2]), r1(m[4], m[5], m[6]), r2(m[8], m[9], m[10]);
+		Vec3 t(m[3], m[7], m[11]);
+
+		Vec3 c0 = Vec3::cross(r1, r2);
+		Vec3 c1 = Vec3::cross(r2, r0);
+		Vec3 c2 = Vec3::cross(r0, r1);
+
+		float invDet = Math::ONEFLOAT / Vec3::dot(r0, c0);
+		c0 *= invDet;
+		c1 *= invDet;
+		c2 *= invDet;
+
+		Vec3 it = -(c0 * t.x + c1 * t.y + c2 * t.z);
+
+		r[0] = c0.x; r[1] = c1.x; r[2] = c2.x;  r[3] = it.x;
+		r[4] = c0.y; r[5] = c1.y; r[6] = c2.y;  r[7] = it.y;
+		r[8] = c0.z; r[9] = c1.z; r[10] = c2.z; r[11] = it.z;
+	}
+
+#if MATH_SIMD_X86
+	ENGINE_TARGET_SSE41 static void _MulSSE41(float* r, const float* a, const float* b) {
+		__m128 b0 = _mm_loadu_ps(b + 0);
+		__m128 b1 = _mm_loadu_ps(b + 4);
+		__m128 b2 = _mm_loadu_ps(b + 8);
+
+		for (int row = 0; row < 12; row += 4) {
+			__m128 ar = _mm_loadu_ps(a + row);
+			__m128 res = _mm_mul_ps(_mm_shuffle_ps(ar, ar, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+			res = _mm_add_ps(res, _mm_mul_ps(_mm_shuffle_ps(ar, ar, _MM_SHUFFLE(1, 1, 1, 1)), b1));
+			res = _mm_add_ps(res, _mm_mul_ps(_mm_shuffle_ps(ar, ar, _MM_SHUFFLE(2, 2, 2, 2)), b2));
+			// translation of A goes to the w lane only
+			res = _mm_add_ps(res, _mm_blend_ps(_mm_setzero_ps(), ar, 0x8));
+			_mm_storeu_ps(r + row, res);
+		}
+	}
+
+	ENGINE_TARGET_SSE41 static void _InverseSSE41(float* r, const float* m) {
+		__m128 r0 = _mm_loadu_ps(m + 0);
+		__m128 r1 = _mm_loadu_ps(m + 4);
+		__m128 r2 = _mm_loadu_ps(m + 8);
+
+		// translation is in the w lanes
+		__m128 tx = _mm_shuffle_ps(r0, r0, _MM_SHUFFLE(3, 3, 3, 3));
+		__m128 ty = _mm_shuffle_ps(r1, r1, _MM_SHUFFLE(3, 3, 3, 3));
+		__m128 tz = _mm_shuffle_ps(r2, r2, _MM_SHUFFLE(3, 3, 3, 3));
+
+		__m128 c0 = SIMD::Cross3(r1, r2);
+		__m128 c1 = SIMD::Cross3(r2, r0);
+		__m128 c2 = SIMD::Cross3(r0, r1);
+
+		__m128 invDet = _mm_div_ps(_mm_set1_ps(1.0f), _mm_dp_ps(r0, c0, 0x7F));
+		c0 = _mm_mul_ps(c0, invDet);
+		c1 = _mm_mul_ps(c1, invDet);
+		c2 = _mm_mul_ps(c2, invDet);
+
+		__m128 it = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, tx), _mm_mul_ps(c1, ty)), _mm_mul_ps(c2, tz));
+		it = _mm_sub_ps(_mm_setzero_ps(), it);
+
+		// c0, c1, c2, it are the columns of the result
+		_MM_TRANSPOSE4_PS(c0, c1, c2, it);
+		_mm_storeu_ps(r + 0, c0);
+		_mm_storeu_ps(r + 4, c1);
+		_mm_storeu_ps(r + 8, c2);
+	}
+#endif
+
+	Affine3x4 Affine3x4::operator*(const Affine3x4& m) const {
+		Affine3x4 result;
+
+		switch (SIMD::GetLevel())
+		{
+#if MATH_SIMD_X86
+		case SIMD::LEVEL_AVX2:
+		case SIMD::LEVEL_SSE41: _MulSSE41(result.e, e, m.e); break;
+#endif
+		default: _MulScalar(result.e, e, m.e); break;
+		}
+
+		return result;
+	}
+
+	Affine3x4& Affine3x4::operator*=(const Affine3x4& m) {
+		*this = *this * m;
+		return *this;
+	}
+
+	Vec3 Affine3x4::operator*(const Vec3& v) const {
+		return Vec3(e[0] * v.x + e[1] * v.y + e[2] * v.z + e[3],
+			e[4] * v.x + e[5] * v.y + e[6] * v.z + e[7],
+			e[8] * v.x + e[9] * v.y + e[10] * v.z + e[11]);
+	}
+
+	Vec3 Affine3x4::TransformVector(const Vec3& v) const {
+		return Vec3(e[0] * v.x + e[1] * v.y + e[2] * v.z,
+			e[4] * v.x + e[5] * v.y + e[6] * v.z,
+			e[8] * v.x + e[9] * v.y + e[10] * v.z);
+	}
+
+	Affine3x4 Affine3x4::inverse(const Affine3x4& m) {
+		Affine3x4 result;
+
+		switch (SIMD::GetLevel())
+		{
+#if MATH_SIMD_X86
+		case SIMD::LEVEL_AVX2:
+		case SIMD::LEVEL_SSE41: _InverseSSE41(result.e, m.e); break;
+#endif
+		default: _InverseScalar(result.e, m.e); break;
+		}
+
+		return result;
+	}
+
+	namespace Utils
+	{
+		/*
+		The Mat4 kernels never read the bottom row for points and vectors
+		*/
+		void TransformPoints(const Affine3x4& m, const Vec3* in, Vec3* out, size_t count)
+		{
+			TransformPoints(m.ToMat4(), in, out, count);
+		}
+
+		void TransformVectors(const Affine3x4& m, const Vec3* in, Vec3* out, size_t count)
+		{
+			TransformVectors(m.ToMat4(), in, out, count);
+		}
+	}
+}
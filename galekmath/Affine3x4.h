@@ -0,0 +1,77 @@
+/* Copyright (C) 2009-2020, Nick Galko Ltd. All rights reserved.
+*
+* This file is part of the NGTech (https://galek.github.io/portfolio/).
+*
+* Your use and or redistribution of this software in source and / or
+* binary form, with or without modification, is subject to: (i) your
+* ongoing acceptance of and compliance with the terms and conditions of
+* the NGTech License Agreement; and (ii) your inclusion of this notice
+* in any version of this software that you use or redistribute.
+* A copy of the NGTech License Agreement is available by contacting
+* Nick Galko Ltd. at https://galek.github.io/portfolio/
+*/
+#pragma once
+
+//***************************************************************************
+#include "MathLib.h"
+//***************************************************************************
+
+namespace NGTech
+{
+	/**
+	Affine transform stored as the top 3 rows of a 4x4 matrix (bottom row is always 0, 0, 0, 1).
+	Rows are stored one after another: e[row * 4 + column], so a row is
+	(rotation/scale | translation) and the array can be uploaded as float4x3.
+	Same meaning as Mat4: A * B applies B first.
+	*/
+	class Affine3x4
+	{
+	public:
+		float e[12];
+
+		constexpr Affine3x4() : e{ 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0 } {}
+		constexpr Affine3x4(float e0, float e1, float e2, float e3,
+			float e4, float e5, float e6, float e7,
+			float e8, float e9, float e10, float e11)
+			: e{ e0, e1, e2, e3, e4, e5, e6, e7, e8, e9, e10, e11 } {}
+
+		/**
+		Bottom row of the matrix is ignored
+		*/
+		explicit Affine3x4(const Mat4& m);
+		Mat4 ToMat4() const;
+
+		ENGINE_INLINE float& operator[](intptr_t index) { return e[index]; }
+		ENGINE_INLINE float operator[](intptr_t index) const { return e[index]; }
+		ENGINE_INLINE operator float* () { return e; }
+		ENGINE_INLINE operator const float* () const { return e; }
+
+		ENGINE_INLINE Vec3 GetPosition() const { return Vec3(e[3], e[7], e[11]); }
+		ENGINE_INLINE void SetPosition(const Vec3& _vec) { e[3] = _vec.x; e[7] = _vec.y; e[11] = _vec.z; }
+
+		Affine3x4 operator*(const Affine3x4& m) const;
+		Affine3x4& operator*=(const Affine3x4& m);
+
+		/**
+		Point (w = 1) and vector (w = 0) transform
+		*/
+		Vec3 operator*(const Vec3& v) const;
+		Vec3 TransformVector(const Vec3& v) const;
+
+		static Affine3x4 inverse(const Affine3x4& m);
+
+		static const Affine3x4 IDENTITY;
+	};
+
+	static_assert(sizeof(Affine3x4) == 12 * sizeof(float), "Invalid Affine3x4 padding!");
+	static_assert(std::is_trivially_copyable<Affine3x4>::value, "Affine3x4 must be trivially copyable!");
+
+	namespace Utils
+	{
+		/**
+		Same as the Mat4 versions
+		*/
+		void TransformPoints(const Affine3x4& m, const Vec3* in, Vec3* out, size_t count);
+		void TransformVectors(const Affine3x4& m, const Vec3* in, Vec3* out, size_t count);
+	}
+}
@@ -11,18 +11,44 @@
 * Nick Galko Ltd. at https://galek.github.io/portfolio/
 */
 
+#include <stdint.h>
+
 #include "MathLib.h"
 #include "BBox.h"
+#include "Parallel.h"
+#include "SIMD.h"
 
 namespace NGTech
 {
 	BBox operator*(const Mat4& a, const BBox& b) {
-		BBox result;
-		result.mins = (*a) * b.mins;
-		result.maxes = (*a) * b.maxes;
+		BBox result(b);
+		result.TransformAffine(a);
 		return result;
 	}
 
+	/*
+	Center and half size come from mins/maxes, Inflate does not update the cached ones
+	*/
+	static ENGINE_INLINE BBox _TransformAffine(const float* m, const BBox& box)
+	{
+		Vec3 c = (box.mins + box.maxes) * 0.5f;
+		Vec3 h = (box.maxes - box.mins) * 0.5f;
+
+		Vec3 center(m[0] * c.x + m[4] * c.y + m[8] * c.z + m[12],
+			m[1] * c.x + m[5] * c.y + m[9] * c.z + m[13],
+			m[2] * c.x + m[6] * c.y + m[10] * c.z + m[14]);
+		Vec3 half(fabsf(m[0]) * h.x + fabsf(m[4]) * h.y + fabsf(m[8]) * h.z,
+			fabsf(m[1]) * h.x + fabsf(m[5]) * h.y + fabsf(m[9]) * h.z,
+			fabsf(m[2]) * h.x + fabsf(m[6]) * h.y + fabsf(m[10]) * h.z);
+
+		return BBox(center - half, center + half);
+	}
+
+	void BBox::TransformAffine(const Mat4& traf)
+	{
+		*this = _TransformAffine(traf, *this);
+	}
+
 	void BBox::Inflate(const Vec3& point)
 	{
 		if (point.x < mins.x)
@@ -44,4 +70,285 @@ namespace NGTech
 		m_vCenter = (mins + maxes) * 0.5f;
 		m_vCenterHalf = (maxes - mins) * 0.5f;
 	}
+
+	static const size_t MIN_POINTS_PER_THREAD = 65536;
+	static const size_t MIN_BOXES_PER_THREAD = 16384;
+
+	/*
+	Math::Min(v, m) keeps m when v is NaN, same as minps with the new value first
+	*/
+	static void _MinMaxScalar(const uint8_t* points, size_t stride, size_t begin, size_t end, Vec3& mins, Vec3& maxes)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			const float* p = (const float*)(points + i * stride);
+			mins.x = Math::Min(p[0], mins.x); maxes.x = Math::Max(p[0], maxes.x);
+			mins.y = Math::Min(p[1], mins.y); maxes.y = Math::Max(p[1], maxes.y);
+			mins.z = Math::Min(p[2], mins.z); maxes.z = Math::Max(p[2], maxes.z);
+		}
+	}
+
+	static void _TransformBoxesScalar(const float* m, const BBox* in, BBox* out, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+			out[i] = _TransformAffine(m, in[i]);
+	}
+
+#if MATH_SIMD_X86
+	static_assert(sizeof(BBox) == 4 * sizeof(Vec3), "BBox kernels expect mins, maxes, center and half size packed!");
+
+	/*
+	A box is 4 packed Vec3 (mins, maxes, center, half). One box per register row, the results
+	are transposed back to x, y, z rows and stored as 4 Vec3. Same operation order as _TransformAffine.
+	*/
+	ENGINE_TARGET_SSE41 static size_t _TransformBoxesSSE41(const float* m, const BBox* in, BBox* out, size_t begin, size_t end)
+	{
+		__m128 sign = _mm_set1_ps(-0.0f), half = _mm_set1_ps(0.5f);
+		__m128 c0 = _mm_loadu_ps(m + 0), c1 = _mm_loadu_ps(m + 4), c2 = _mm_loadu_ps(m + 8), c3 = _mm_loadu_ps(m + 12);
+		__m128 a0 = _mm_andnot_ps(sign, c0), a1 = _mm_andnot_ps(sign, c1), a2 = _mm_andnot_ps(sign, c2);
+
+		size_t i = begin;
+		for (; i < end; i++)
+		{
+			const float* p = &in[i].mins.x;
+			__m128 mn = _mm_loadu_ps(p + 0), mx = _mm_loadu_ps(p + 3);
+			__m128 c = _mm_mul_ps(_mm_add_ps(mn, mx), half);
+			__m128 h = _mm_mul_ps(_mm_sub_ps(mx, mn), half);
+
+			__m128 center = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(c0, _mm_shuffle_ps(c, c, _MM_SHUFFLE(0, 0, 0, 0))),
+				_mm_mul_ps(c1, _mm_shuffle_ps(c, c, _MM_SHUFFLE(1, 1, 1, 1)))),
+				_mm_mul_ps(c2, _mm_shuffle_ps(c, c, _MM_SHUFFLE(2, 2, 2, 2)))), c3);
+			__m128 extent = _mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(a0, _mm_shuffle_ps(h, h, _MM_SHUFFLE(0, 0, 0, 0))),
+				_mm_mul_ps(a1, _mm_shuffle_ps(h, h, _MM_SHUFFLE(1, 1, 1, 1)))),
+				_mm_mul_ps(a2, _mm_shuffle_ps(h, h, _MM_SHUFFLE(2, 2, 2, 2))));
+
+			mn = _mm_sub_ps(center, extent);
+			mx = _mm_add_ps(center, extent);
+			c = _mm_mul_ps(_mm_add_ps(mn, mx), half);
+			h = _mm_mul_ps(_mm_sub_ps(mx, mn), half);
+
+			_MM_TRANSPOSE4_PS(mn, mx, c, h);
+			SIMD::StoreVec3x4(&out[i].mins.x, mn, mx, c);
+		}
+
+		return i;
+	}
+
+	/*
+	Boxes i and i + 1 share a register
+	*/
+	ENGINE_TARGET_AVX2 static size_t _TransformBoxesAVX2(const float* m, const BBox* in, BBox* out, size_t begin, size_t end)
+	{
+		__m256 sign = _mm256_set1_ps(-0.0f), half = _mm256_set1_ps(0.5f);
+		__m256 c0 = _mm256_broadcast_ps((const __m128*)(m + 0));
+		__m256 c1 = _mm256_broadcast_ps((const __m128*)(m + 4));
+		__m256 c2 = _mm256_broadcast_ps((const __m128*)(m + 8));
+		__m256 c3 = _mm256_broadcast_ps((const __m128*)(m + 12));
+		__m256 a0 = _mm256_andnot_ps(sign, c0), a1 = _mm256_andnot_ps(sign, c1), a2 = _mm256_andnot_ps(sign, c2);
+
+		size_t i = begin;
+		for (; i + 2 <= end; i += 2)
+		{
+			const float* p = &in[i].mins.x;
+			__m256 mn = SIMD::Load2(p + 0, p + 12);
+			__m256 mx = SIMD::Load2(p + 3, p + 15);
+			__m256 c = _mm256_mul_ps(_mm256_add_ps(mn, mx), half);
+			__m256 h = _mm256_mul_ps(_mm256_sub_ps(mx, mn), half);
+
+			__m256 center = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+				_mm256_mul_ps(c0, _mm256_shuffle_ps(c, c, _MM_SHUFFLE(0, 0, 0, 0))),
+				_mm256_mul_ps(c1, _mm256_shuffle_ps(c, c, _MM_SHUFFLE(1, 1, 1, 1)))),
+				_mm256_mul_ps(c2, _mm256_shuffle_ps(c, c, _MM_SHUFFLE(2, 2, 2, 2)))), c3);
+			__m256 extent = _mm256_add_ps(_mm256_add_ps(
+				_mm256_mul_ps(a0, _mm256_shuffle_ps(h, h, _MM_SHUFFLE(0, 0, 0, 0))),
+				_mm256_mul_ps(a1, _mm256_shuffle_ps(h, h, _MM_SHUFFLE(1, 1, 1, 1)))),
+				_mm256_mul_ps(a2, _mm256_shuffle_ps(h, h, _MM_SHUFFLE(2, 2, 2, 2))));
+
+			mn = _mm256_sub_ps(center, extent);
+			mx = _mm256_add_ps(center, extent);
+			c = _mm256_mul_ps(_mm256_add_ps(mn, mx), half);
+			h = _mm256_mul_ps(_mm256_sub_ps(mx, mn), half);
+
+			SIMD::Transpose4x4(mn, mx, c, h);
+			SIMD::StoreVec3x4(&out[i].mins.x, _mm256_castps256_ps128(mn), _mm256_castps256_ps128(mx), _mm256_castps256_ps128(c));
+			SIMD::StoreVec3x4(&out[i + 1].mins.x, _mm256_extractf128_ps(mn, 1), _mm256_extractf128_ps(mx, 1), _mm256_extractf128_ps(c, 1));
+		}
+
+		return _TransformBoxesSSE41(m, in, out, i, end);
+	}
+
+	/*
+	Packed Vec3 repeat every 3 floats, so register k of a block always holds the same
+	components in the same lanes: no shuffles in the loop, components are sorted out once
+	*/
+	static void _MergeComponents(const float* lo, const float* hi, int floats, Vec3& mins, Vec3& maxes)
+	{
+		for (int k = 0; k < floats; k++) {
+			mins[k % 3] = Math::Min(lo[k], mins[k % 3]);
+			maxes[k % 3] = Math::Max(hi[k], maxes[k % 3]);
+		}
+	}
+
+	ENGINE_TARGET_SSE41 static size_t _MinMaxPackedSSE41(const Vec3* points, size_t begin, size_t end, Vec3& mins, Vec3& maxes)
+	{
+		__m128 lo0 = _mm_set1_ps(FLT_MAX), lo1 = lo0, lo2 = lo0;
+		__m128 hi0 = _mm_set1_ps(-FLT_MAX), hi1 = hi0, hi2 = hi0;
+
+		size_t i = begin;
+		for (; i + 4 <= end; i += 4)
+		{
+			const float* p = &points[i].x;
+			__m128 a = _mm_loadu_ps(p + 0), b = _mm_loadu_ps(p + 4), c = _mm_loadu_ps(p + 8);
+			lo0 = _mm_min_ps(a, lo0); hi0 = _mm_max_ps(a, hi0);
+			lo1 = _mm_min_ps(b, lo1); hi1 = _mm_max_ps(b, hi1);
+			lo2 = _mm_min_ps(c, lo2); hi2 = _mm_max_ps(c, hi2);
+		}
+
+		float lo[12], hi[12];
+		_mm_storeu_ps(lo + 0, lo0); _mm_storeu_ps(lo + 4, lo1); _mm_storeu_ps(lo + 8, lo2);
+		_mm_storeu_ps(hi + 0, hi0); _mm_storeu_ps(hi + 4, hi1); _mm_storeu_ps(hi + 8, hi2);
+		_MergeComponents(lo, hi, 12, mins, maxes);
+
+		return i;
+	}
+
+	ENGINE_TARGET_AVX2 static size_t _MinMaxPackedAVX2(const Vec3* points, size_t begin, size_t end, Vec3& mins, Vec3& maxes)
+	{
+		__m256 lo0 = _mm256_set1_ps(FLT_MAX), lo1 = lo0, lo2 = lo0;
+		__m256 hi0 = _mm256_set1_ps(-FLT_MAX), hi1 = hi0, hi2 = hi0;
+
+		size_t i = begin;
+		for (; i + 8 <= end; i += 8)
+		{
+			const float* p = &points[i].x;
+			__m256 a = _mm256_loadu_ps(p + 0), b = _mm256_loadu_ps(p + 8), c = _mm256_loadu_ps(p + 16);
+			lo0 = _mm256_min_ps(a, lo0); hi0 = _mm256_max_ps(a, hi0);
+			lo1 = _mm256_min_ps(b, lo1); hi1 = _mm256_max_ps(b, hi1);
+			lo2 = _mm256_min_ps(c, lo2); hi2 = _mm256_max_ps(c, hi2);
+		}
+
+		float lo[24], hi[24];
+		_mm256_storeu_ps(lo + 0, lo0); _mm256_storeu_ps(lo + 8, lo1); _mm256_storeu_ps(lo + 16, lo2);
+		_mm256_storeu_ps(hi + 0, hi0); _mm256_storeu_ps(hi + 8, hi1); _mm256_storeu_ps(hi + 16, hi2);
+		_MergeComponents(lo, hi, 24, mins, maxes);
+
+		return _MinMaxPackedSSE41(points, i, end, mins, maxes);
+	}
+
+	/*
+	One point per 16-byte load, the w lane reads the next attribute and is ignored.
+	Callers keep end below the last point, its load would cross the end of the array.
+	*/
+	ENGINE_TARGET_SSE41 static size_t _MinMaxStridedSSE41(const uint8_t* points, size_t stride, size_t begin, size_t end, Vec3& mins, Vec3& maxes)
+	{
+		__m128 lo0 = _mm_set1_ps(FLT_MAX), lo1 = lo0;
+		__m128 hi0 = _mm_set1_ps(-FLT_MAX), hi1 = hi0;
+
+		size_t i = begin;
+		for (; i + 2 <= end; i += 2)
+		{
+			__m128 a = _mm_loadu_ps((const float*)(points + i * stride));
+			__m128 b = _mm_loadu_ps((const float*)(points + (i + 1) * stride));
+			lo0 = _mm_min_ps(a, lo0); hi0 = _mm_max_ps(a, hi0);
+			lo1 = _mm_min_ps(b, lo1); hi1 = _mm_max_ps(b, hi1);
+		}
+
+		float lo[4], hi[4];
+		_mm_storeu_ps(lo, _mm_min_ps(lo1, lo0));
+		_mm_storeu_ps(hi, _mm_max_ps(hi1, hi0));
+		_MergeComponents(lo, hi, 3, mins, maxes);
+
+		return i;
+	}
+
+	ENGINE_TARGET_AVX2 static size_t _MinMaxStridedAVX2(const uint8_t* points, size_t stride, size_t begin, size_t end, Vec3& mins, Vec3& maxes)
+	{
+		__m256 lo0 = _mm256_set1_ps(FLT_MAX), lo1 = lo0;
+		__m256 hi0 = _mm256_set1_ps(-FLT_MAX), hi1 = hi0;
+
+		size_t i = begin;
+		for (; i + 4 <= end; i += 4)
+		{
+			const uint8_t* p = points + i * stride;
+			__m256 a = SIMD::Load2((const float*)p, (const float*)(p + stride));
+			__m256 b = SIMD::Load2((const float*)(p + 2 * stride), (const float*)(p + 3 * stride));
+			lo0 = _mm256_min_ps(a, lo0); hi0 = _mm256_max_ps(a, hi0);
+			lo1 = _mm256_min_ps(b, lo1); hi1 = _mm256_max_ps(b, hi1);
+		}
+
+		__m256 lo8 = _mm256_min_ps(lo1, lo0), hi8 = _mm256_max_ps(hi1, hi0);
+		float lo[4], hi[4];
+		_mm_storeu_ps(lo, _mm_min_ps(_mm256_extractf128_ps(lo8, 1), _mm256_castps256_ps128(lo8)));
+		_mm_storeu_ps(hi, _mm_max_ps(_mm256_extractf128_ps(hi8, 1), _mm256_castps256_ps128(hi8)));
+		_MergeComponents(lo, hi, 3, mins, maxes);
+
+		return _MinMaxStridedSSE41(points, stride, i, end, mins, maxes);
+	}
+
+#endif
+
+	/*
+	Bounds of one Parallel range
+	*/
+	struct _MinMax
+	{
+		Vec3 mins, maxes;
+
+		_MinMax() {
+			mins.SetMax();
+			maxes.SetMin();
+		}
+
+		static void Merge(_MinMax& result, const _MinMax& other) {
+			for (int k = 0; k < 3; k++) {
+				result.mins[k] = Math::Min(other.mins[k], result.mins[k]);
+				result.maxes[k] = Math::Max(other.maxes[k], result.maxes[k]);
+			}
+		}
+	};
+
+	BBox BBox::FromPoints(const Vec3* points, size_t count)
+	{
+		_MinMax r = Parallel::Reduce(count, MIN_POINTS_PER_THREAD, _MinMax(), [&](size_t begin, size_t end, _MinMax& state)
+		{
+			size_t i = begin;
+			SIMD_DISPATCH(i, _MinMaxPacked, points, begin, end, state.mins, state.maxes);
+			_MinMaxScalar((const uint8_t*)points, sizeof(Vec3), i, end, state.mins, state.maxes);
+		}, _MinMax::Merge);
+
+		return BBox(r.mins, r.maxes);
+	}
+
+	BBox BBox::FromPointsStrided(const void* points, size_t stride, size_t count)
+	{
+		if (stride == sizeof(Vec3))
+			return FromPoints((const Vec3*)points, count);
+
+		const uint8_t* bytes = (const uint8_t*)points;
+		_MinMax r = Parallel::Reduce(count, MIN_POINTS_PER_THREAD, _MinMax(), [&](size_t begin, size_t end, _MinMax& state)
+		{
+			size_t i = begin;
+			if (stride >= 4 * sizeof(float)) {
+				SIMD_DISPATCH(i, _MinMaxStrided, bytes, stride, begin, Math::Min(end, count - 1), state.mins, state.maxes);
+			}
+			_MinMaxScalar(bytes, stride, i, end, state.mins, state.maxes);
+		}, _MinMax::Merge);
+
+		return BBox(r.mins, r.maxes);
+	}
+
+	namespace Utils
+	{
+		void TransformBoxes(const Mat4& m, const BBox* in, BBox* out, size_t count)
+		{
+			Parallel::For(count, MIN_BOXES_PER_THREAD, [&](size_t begin, size_t end)
+			{
+				size_t i = begin;
+				SIMD_DISPATCH(i, _TransformBoxes, m, in, out, begin, end);
+				_TransformBoxesScalar(m, in, out, i, end);
+			});
+		}
+	}
 }
\ No newline at end of file
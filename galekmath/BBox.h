@@ -179,6 +179,8 @@ namespace NGTech
 		}
 
 		/**
+		Bounds of the 8 transformed corners, also works for projections. For affine matrices
+		TransformAffine gives the same box without the corners.
 		*/
 		ENGINE_INLINE void TransformAxisAligned(const Mat4& traf)
 		{
@@ -280,11 +282,59 @@ namespace NGTech
 			outnear = std::max<float>(outnear, 0.1f);
 			outfar = std::max<float>(outfar, 0.2f);
 		}
+
+		/**
+		Slab test of the segment src + dir * t, t in [0, tMax], against the box mins-maxes.
+		tEnter is 0 when src is inside. Math::Min/Max pick the second argument for NaN like
+		minps/maxps, so 0 * inf on a slab plane gives the same answer as the SIMD versions.
+		*/
+		static ENGINE_INLINE bool IntersectsSlabs(const Vec3& mins, const Vec3& maxes, const Vec3& src, const Vec3& invDir, float tMax, float& tEnter)
+		{
+			float tx0 = (mins.x - src.x) * invDir.x, tx1 = (maxes.x - src.x) * invDir.x;
+			float ty0 = (mins.y - src.y) * invDir.y, ty1 = (maxes.y - src.y) * invDir.y;
+			float tz0 = (mins.z - src.z) * invDir.z, tz1 = (maxes.z - src.z) * invDir.z;
+
+			float tNear = Math::Max(Math::Max(Math::Min(tx0, tx1), Math::Min(ty0, ty1)), Math::Max(Math::Min(tz0, tz1), 0.0f));
+			float tFar = Math::Min(Math::Min(Math::Max(tx0, tx1), Math::Max(ty0, ty1)), Math::Min(Math::Max(tz0, tz1), tMax));
+
+			tEnter = tNear;
+			return tNear <= tFar;
+		}
+
+		/**
+		Box around count points with a branch-free SIMD min/max pass, the center is computed once.
+		Big arrays are split over the Parallel threads. NaN coordinates are skipped like in AddPoint,
+		no points give a cleared box.
+		*/
+		static BBox FromPoints(const Vec3* points, size_t count);
+		/**
+		Same for positions inside interleaved vertices: point i is the 3 floats at
+		(const uint8_t*)points + i * stride
+		*/
+		static BBox FromPointsStrided(const void* points, size_t stride, size_t count);
+
+		/**
+		Arvo's method: the center is transformed by traf, the half size by the absolute values of
+		the 3x3 part. The bottom row of traf is ignored.
+		*/
+		void TransformAffine(const Mat4& traf);
 	private:
 		void	_ComputeCenter();
 	private:
 		Vec3	m_vCenter;
 		Vec3	m_vCenterHalf;
 	};
+	/**
+	Same as BBox::TransformAffine
+	*/
 	extern BBox operator*(const Mat4& a, const BBox& b);
+
+	namespace Utils
+	{
+		/**
+		BBox::TransformAffine over count boxes, one (SSE4.1) or two (AVX2) boxes per register.
+		Big arrays are split over the Parallel threads, out may be in.
+		*/
+		void TransformBoxes(const Mat4& m, const BBox* in, BBox* out, size_t count);
+	}
 }
@@ -10,8 +10,15 @@
 * A copy of the NGTech License Agreement is available by contacting
 * Nick Galko Ltd. at https://galek.github.io/portfolio/
 */
+//***************************************************************************
+#include <vector>
+#include <algorithm>
+//***************************************************************************
 #include "MathLib.h"
 #include "BSphere.h"
+#include "Parallel.h"
+#include "SIMD.h"
+//***************************************************************************
 
 namespace NGTech
 {
@@ -22,4 +29,456 @@ namespace NGTech
 		result.radius = s.radius;
 		return result;
 	}
-}
\ No newline at end of file
+
+	static const size_t MIN_POINTS_PER_THREAD = 65536;
+	/*
+	Relative slack of the inside test in Welzl's algorithm, without it rounding
+	makes boundary points restart the inner loops
+	*/
+	static const float WELZL_EPSILON = 1e-5f;
+
+	/*
+	Indices of the smallest and largest x, y, z (in that order), the first one wins on ties
+	*/
+	struct _Extremes
+	{
+		float value[6];
+		size_t index[6];
+
+		_Extremes() {
+			for (int k = 0; k < 6; k += 2) {
+				value[k] = FLT_MAX;
+				value[k + 1] = -FLT_MAX;
+				index[k] = index[k + 1] = SIZE_MAX;
+			}
+		}
+
+		ENGINE_INLINE void Set(int k, float v, size_t i) {
+			if ((k & 1) ? v > value[k] : v < value[k]) {
+				value[k] = v;
+				index[k] = i;
+			}
+		}
+
+		/*
+		other covers points after this one
+		*/
+		ENGINE_INLINE void Merge(const _Extremes& other) {
+			for (int k = 0; k < 6; k++)
+				if (other.index[k] != SIZE_MAX)
+					Set(k, other.value[k], other.index[k]);
+		}
+	};
+
+	static void _ExtremesScalar(const Vec3* points, size_t begin, size_t end, _Extremes& e)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			const Vec3& p = points[i];
+			e.Set(0, p.x, i); e.Set(1, p.x, i);
+			e.Set(2, p.y, i); e.Set(3, p.y, i);
+			e.Set(4, p.z, i); e.Set(5, p.z, i);
+		}
+	}
+
+	static ENGINE_INLINE void _Grow(BSphere& sphere, float& radius2, const Vec3& p)
+	{
+		Vec3 d = p - sphere.center;
+		float dist2 = Vec3::dot(d, d);
+		if (dist2 > radius2) {
+			float dist = sqrtf(dist2);
+			float radius = (sphere.radius + dist) * 0.5f;
+			sphere.center += d * ((radius - sphere.radius) / dist);
+			sphere.radius = radius;
+			radius2 = radius * radius;
+		}
+	}
+
+	static void _GrowScalar(const Vec3* points, size_t begin, size_t end, BSphere& sphere, float& radius2)
+	{
+		for (size_t i = begin; i < end; i++)
+			_Grow(sphere, radius2, points[i]);
+	}
+
+	static void _MaxDistanceScalar(const Vec3* points, size_t begin, size_t end, const Vec3& center, float& dist2)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			Vec3 d = points[i] - center;
+			dist2 = Math::Max(dist2, Vec3::dot(d, d));
+		}
+	}
+
+#if MATH_SIMD_X86
+	/*
+	Lanes keep their own extremes (index relative to begin, -1 for none)
+	*/
+	static void _MergeExtremeLanes(const float* value, const int* index, int lanes, int k, size_t begin, _Extremes& e)
+	{
+		int best = SIMD::BestLane(value, index, lanes, (k & 1) != 0);
+		if (best >= 0)
+			e.Set(k, value[best], begin + index[best]);
+	}
+
+	ENGINE_TARGET_SSE41 static ENGINE_INLINE void _SelectSSE41(__m128 mask, __m128 v, __m128i index, __m128& best, __m128i& bestIndex)
+	{
+		best = _mm_blendv_ps(best, v, mask);
+		bestIndex = _mm_castps_si128(_mm_blendv_ps(_mm_castsi128_ps(bestIndex), _mm_castsi128_ps(index), mask));
+	}
+
+	ENGINE_TARGET_SSE41 static size_t _ExtremesSSE41(const Vec3* points, size_t begin, size_t end, _Extremes& e)
+	{
+		__m128 best[6];
+		__m128i bestIndex[6];
+		for (int k = 0; k < 6; k++) {
+			best[k] = _mm_set1_ps((k & 1) ? -FLT_MAX : FLT_MAX);
+			bestIndex[k] = _mm_set1_epi32(-1);
+		}
+
+		__m128i index = _mm_setr_epi32(0, 1, 2, 3);
+		size_t i = begin;
+		for (; i + 4 <= end; i += 4, index = _mm_add_epi32(index, _mm_set1_epi32(4)))
+		{
+			__m128 v[3];
+			SIMD::LoadVec3x4(&points[i].x, v[0], v[1], v[2]);
+			for (int axis = 0; axis < 3; axis++) {
+				_SelectSSE41(_mm_cmplt_ps(v[axis], best[axis * 2]), v[axis], index, best[axis * 2], bestIndex[axis * 2]);
+				_SelectSSE41(_mm_cmpgt_ps(v[axis], best[axis * 2 + 1]), v[axis], index, best[axis * 2 + 1], bestIndex[axis * 2 + 1]);
+			}
+		}
+
+		for (int k = 0; k < 6; k++) {
+			float value[4];
+			int lanes[4];
+			_mm_storeu_ps(value, best[k]);
+			_mm_storeu_si128((__m128i*)lanes, bestIndex[k]);
+			_MergeExtremeLanes(value, lanes, 4, k, begin, e);
+		}
+
+		return i;
+	}
+
+	ENGINE_TARGET_AVX2 static ENGINE_INLINE void _SelectAVX2(__m256 mask, __m256 v, __m256i index, __m256& best, __m256i& bestIndex)
+	{
+		best = _mm256_blendv_ps(best, v, mask);
+		bestIndex = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(bestIndex), _mm256_castsi256_ps(index), mask));
+	}
+
+	/*
+	LoadVec3x8 puts points 0-3 to the low lane, so the indices are in order
+	*/
+	ENGINE_TARGET_AVX2 static size_t _ExtremesAVX2(const Vec3* points, size_t begin, size_t end, _Extremes& e)
+	{
+		__m256 best[6];
+		__m256i bestIndex[6];
+		for (int k = 0; k < 6; k++) {
+			best[k] = _mm256_set1_ps((k & 1) ? -FLT_MAX : FLT_MAX);
+			bestIndex[k] = _mm256_set1_epi32(-1);
+		}
+
+		__m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+		size_t i = begin;
+		for (; i + 8 <= end; i += 8, index = _mm256_add_epi32(index, _mm256_set1_epi32(8)))
+		{
+			__m256 v[3];
+			SIMD::LoadVec3x8(&points[i].x, v[0], v[1], v[2]);
+			for (int axis = 0; axis < 3; axis++) {
+				_SelectAVX2(_mm256_cmp_ps(v[axis], best[axis * 2], _CMP_LT_OQ), v[axis], index, best[axis * 2], bestIndex[axis * 2]);
+				_SelectAVX2(_mm256_cmp_ps(v[axis], best[axis * 2 + 1], _CMP_GT_OQ), v[axis], index, best[axis * 2 + 1], bestIndex[axis * 2 + 1]);
+			}
+		}
+
+		for (int k = 0; k < 6; k++) {
+			float value[8];
+			int lanes[8];
+			_mm256_storeu_ps(value, best[k]);
+			_mm256_storeu_si256((__m256i*)lanes, bestIndex[k]);
+			_MergeExtremeLanes(value, lanes, 8, k, begin, e);
+		}
+
+		return _ExtremesSSE41(points, i, end, e);
+	}
+
+	/*
+	Blocks with all points inside are skipped, the others grow point by point
+	*/
+	ENGINE_TARGET_SSE41 static size_t _GrowSSE41(const Vec3* points, size_t begin, size_t end, BSphere& sphere, float& radius2)
+	{
+		size_t i = begin;
+		for (; i + 4 <= end; i += 4)
+		{
+			__m128 x, y, z;
+			SIMD::LoadVec3x4(&points[i].x, x, y, z);
+			x = _mm_sub_ps(x, _mm_set1_ps(sphere.center.x));
+			y = _mm_sub_ps(y, _mm_set1_ps(sphere.center.y));
+			z = _mm_sub_ps(z, _mm_set1_ps(sphere.center.z));
+
+			__m128 dist2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+			if (_mm_movemask_ps(_mm_cmpgt_ps(dist2, _mm_set1_ps(radius2))))
+				_GrowScalar(points, i, i + 4, sphere, radius2);
+		}
+
+		return i;
+	}
+
+	ENGINE_TARGET_AVX2 static size_t _GrowAVX2(const Vec3* points, size_t begin, size_t end, BSphere& sphere, float& radius2)
+	{
+		size_t i = begin;
+		for (; i + 8 <= end; i += 8)
+		{
+			__m256 x, y, z;
+			SIMD::LoadVec3x8(&points[i].x, x, y, z);
+			x = _mm256_sub_ps(x, _mm256_set1_ps(sphere.center.x));
+			y = _mm256_sub_ps(y, _mm256_set1_ps(sphere.center.y));
+			z = _mm256_sub_ps(z, _mm256_set1_ps(sphere.center.z));
+
+			__m256 dist2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z));
+			if (_mm256_movemask_ps(_mm256_cmp_ps(dist2, _mm256_set1_ps(radius2), _CMP_GT_OQ)))
+				_GrowScalar(points, i, i + 8, sphere, radius2);
+		}
+
+		return _GrowSSE41(points, i, end, sphere, radius2);
+	}
+
+	ENGINE_TARGET_SSE41 static size_t _MaxDistanceSSE41(const Vec3* points, size_t begin, size_t end, const Vec3& center, float& dist2)
+	{
+		__m128 cx = _mm_set1_ps(center.x), cy = _mm_set1_ps(center.y), cz = _mm_set1_ps(center.z);
+		__m128 best = _mm_set1_ps(dist2);
+
+		size_t i = begin;
+		for (; i + 4 <= end; i += 4)
+		{
+			__m128 x, y, z;
+			SIMD::LoadVec3x4(&points[i].x, x, y, z);
+			x = _mm_sub_ps(x, cx);
+			y = _mm_sub_ps(y, cy);
+			z = _mm_sub_ps(z, cz);
+			best = _mm_max_ps(best, _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+		}
+
+		best = _mm_max_ps(best, _mm_shuffle_ps(best, best, _MM_SHUFFLE(1, 0, 3, 2)));
+		best = _mm_max_ps(best, _mm_shuffle_ps(best, best, _MM_SHUFFLE(2, 3, 0, 1)));
+		dist2 = _mm_cvtss_f32(best);
+		return i;
+	}
+
+	ENGINE_TARGET_AVX2 static size_t _MaxDistanceAVX2(const Vec3* points, size_t begin, size_t end, const Vec3& center, float& dist2)
+	{
+		__m256 cx = _mm256_set1_ps(center.x), cy = _mm256_set1_ps(center.y), cz = _mm256_set1_ps(center.z);
+		__m256 best = _mm256_set1_ps(dist2);
+
+		size_t i = begin;
+		for (; i + 8 <= end; i += 8)
+		{
+			__m256 x, y, z;
+			SIMD::LoadVec3x8(&points[i].x, x, y, z);
+			x = _mm256_sub_ps(x, cx);
+			y = _mm256_sub_ps(y, cy);
+			z = _mm256_sub_ps(z, cz);
+			best = _mm256_max_ps(best, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z)));
+		}
+
+		__m128 half = _mm_max_ps(_mm256_castps256_ps128(best), _mm256_extractf128_ps(best, 1));
+		half = _mm_max_ps(half, _mm_shuffle_ps(half, half, _MM_SHUFFLE(1, 0, 3, 2)));
+		half = _mm_max_ps(half, _mm_shuffle_ps(half, half, _MM_SHUFFLE(2, 3, 0, 1)));
+		dist2 = _mm_cvtss_f32(half);
+
+		return _MaxDistanceSSE41(points, i, end, center, dist2);
+	}
+
+#endif
+
+	/*
+	Smallest radius around center that covers all points. The float sqrt can round down,
+	so the radius is bumped until its square covers the farthest point.
+	*/
+	static float _CoveringRadius(const Vec3* points, size_t count, const Vec3& center)
+	{
+		float maxDist2 = Parallel::Reduce(count, MIN_POINTS_PER_THREAD, 0.0f, [&](size_t begin, size_t end, float& dist2)
+		{
+			size_t i = begin;
+			SIMD_DISPATCH(i, _MaxDistance, points, begin, end, center, dist2);
+			_MaxDistanceScalar(points, i, end, center, dist2);
+		}, [](float& result, float dist2) { result = Math::Max(result, dist2); });
+
+		float radius = sqrtf(maxDist2);
+		while (radius * radius < maxDist2)
+			radius = nextafterf(radius, FLT_MAX);
+		return radius;
+	}
+
+	/*
+	Circumscribed spheres, false for collinear/coplanar points
+	*/
+	static ENGINE_INLINE BSphere _Sphere2(const Vec3& a, const Vec3& b)
+	{
+		return BSphere((a + b) * 0.5f, (b - a).length() * 0.5f);
+	}
+
+	static bool _Sphere3(const Vec3& a, const Vec3& b, const Vec3& c, BSphere& sphere)
+	{
+		Vec3 ab = b - a, ac = c - a;
+		Vec3 n = Vec3::cross(ab, ac);
+		float n2 = Vec3::dot(n, n);
+		if (n2 <= WELZL_EPSILON * WELZL_EPSILON * Vec3::dot(ab, ab) * Vec3::dot(ac, ac))
+			return false;
+
+		Vec3 offset = (Vec3::cross(n, ab) * Vec3::dot(ac, ac) + Vec3::cross(ac, n) * Vec3::dot(ab, ab)) * (0.5f / n2);
+		sphere = BSphere(a + offset, offset.length());
+		return true;
+	}
+
+	static bool _Sphere4(const Vec3& a, const Vec3& b, const Vec3& c, const Vec3& d, BSphere& sphere)
+	{
+		Vec3 u = b - a, v = c - a, w = d - a;
+		Vec3 vw = Vec3::cross(v, w);
+		float det = 2.0f * Vec3::dot(u, vw);
+		if (fabsf(det) <= WELZL_EPSILON * u.length() * v.length() * w.length())
+			return false;
+
+		Vec3 offset = (vw * Vec3::dot(u, u) + Vec3::cross(w, u) * Vec3::dot(v, v) + Vec3::cross(u, v) * Vec3::dot(w, w)) * (Math::ONEFLOAT / det);
+		sphere = BSphere(a + offset, offset.length());
+		return true;
+	}
+
+	static ENGINE_INLINE bool _IsOutside(const BSphere& sphere, const Vec3& p)
+	{
+		Vec3 d = p - sphere.center;
+		return Vec3::dot(d, d) > sphere.radius * sphere.radius * (Math::ONEFLOAT + WELZL_EPSILON);
+	}
+
+	/*
+	Smallest sphere with a, b, c on the boundary that covers d. Coplanar points fall back
+	to the smallest sphere over 2 or 3 of them that covers all four.
+	*/
+	static BSphere _SphereWith3(const Vec3& a, const Vec3& b, const Vec3& c, const Vec3& d)
+	{
+		BSphere sphere;
+		if (_Sphere4(a, b, c, d, sphere))
+			return sphere;
+
+		const Vec3* p[4] = { &a, &b, &c, &d };
+		BSphere best(a, FLT_MAX);
+		auto consider = [&](const BSphere& s) {
+			if (s.radius < best.radius && !_IsOutside(s, a) && !_IsOutside(s, b) && !_IsOutside(s, c) && !_IsOutside(s, d))
+				best = s;
+		};
+
+		for (int i = 0; i < 4; i++)
+			for (int j = i + 1; j < 4; j++) {
+				consider(_Sphere2(*p[i], *p[j]));
+				for (int k = j + 1; k < 4; k++)
+					if (_Sphere3(*p[i], *p[j], *p[k], sphere))
+						consider(sphere);
+			}
+
+		return best;
+	}
+
+	/*
+	Smallest sphere with a, b on the boundary that covers c, the farthest pair for collinear points
+	*/
+	static BSphere _SphereWith2(const Vec3& a, const Vec3& b, const Vec3& c)
+	{
+		BSphere sphere;
+		if (_Sphere3(a, b, c, sphere))
+			return sphere;
+
+		float ab = (b - a).length(), ac = (c - a).length(), bc = (c - b).length();
+		if (ab >= ac && ab >= bc)
+			return _Sphere2(a, b);
+		return (ac >= bc) ? _Sphere2(a, c) : _Sphere2(b, c);
+	}
+
+	/*
+	Welzl's algorithm with move-to-front unrolled to loops, expected linear time on shuffled input
+	*/
+	static BSphere _Welzl(std::vector<Vec3>& p)
+	{
+		// fixed seed, the result does not change between runs
+		uint32_t seed = 0x9E3779B9u;
+		for (size_t i = p.size() - 1; i > 0; i--) {
+			seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5;
+			std::swap(p[i], p[seed % (i + 1)]);
+		}
+
+		BSphere sphere(p[0], 0);
+		for (size_t i = 1; i < p.size(); i++)
+		{
+			if (!_IsOutside(sphere, p[i]))
+				continue;
+
+			sphere = BSphere(p[i], 0);
+			for (size_t j = 0; j < i; j++)
+			{
+				if (!_IsOutside(sphere, p[j]))
+					continue;
+
+				sphere = _Sphere2(p[i], p[j]);
+				for (size_t k = 0; k < j; k++)
+				{
+					if (!_IsOutside(sphere, p[k]))
+						continue;
+
+					sphere = _SphereWith2(p[i], p[j], p[k]);
+					for (size_t l = 0; l < k; l++)
+					{
+						if (_IsOutside(sphere, p[l]))
+							sphere = _SphereWith3(p[i], p[j], p[k], p[l]);
+					}
+				}
+			}
+		}
+
+		return sphere;
+	}
+
+	BSphere BSphere::FromPoints(const Vec3* points, size_t count, bool exact)
+	{
+		if (count == 0)
+			return BSphere(Vec3(0, 0, 0), 0);
+
+		BSphere sphere;
+		if (exact) {
+			std::vector<Vec3> copy(points, points + count);
+			sphere = _Welzl(copy);
+		}
+		else {
+			_Extremes e = Parallel::Reduce(count, MIN_POINTS_PER_THREAD, _Extremes(), [&](size_t begin, size_t end, _Extremes& extremes)
+			{
+				size_t i = begin;
+				SIMD_DISPATCH(i, _Extremes, points, begin, end, extremes);
+				_ExtremesScalar(points, i, end, extremes);
+			}, [](_Extremes& result, const _Extremes& extremes) { result.Merge(extremes); });
+
+			// farthest pair of the extremes, NaN only input keeps point 0
+			size_t first = 0, second = 0;
+			float best = -1;
+			for (int k = 0; k < 6; k++)
+				for (int l = k + 1; l < 6; l++) {
+					if (e.index[k] == SIZE_MAX || e.index[l] == SIZE_MAX)
+						continue;
+					Vec3 d = points[e.index[l]] - points[e.index[k]];
+					float dist2 = Vec3::dot(d, d);
+					if (dist2 > best) {
+						best = dist2;
+						first = e.index[k];
+						second = e.index[l];
+					}
+				}
+
+			// every range grows its own copy, the copies are merged
+			BSphere initial = _Sphere2(points[first], points[second]);
+			sphere = Parallel::Reduce(count, MIN_POINTS_PER_THREAD, initial, [&](size_t begin, size_t end, BSphere& grown)
+			{
+				float radius2 = grown.radius * grown.radius;
+				size_t i = begin;
+				SIMD_DISPATCH(i, _Grow, points, begin, end, grown, radius2);
+				_GrowScalar(points, i, end, grown, radius2);
+			}, [](BSphere& result, const BSphere& grown) { result.AddSphere(grown); });
+		}
+
+		sphere.radius = _CoveringRadius(points, count, sphere.center);
+		return sphere;
+	}
+}
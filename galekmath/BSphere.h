@@ -86,6 +86,14 @@ namespace NGTech
 			float lc = dc.length();
 			float dr = sphere.radius - radius;
 
+			// one sphere inside the other, also covers equal centers
+			if (lc <= -dr)
+				return;
+			if (lc <= dr) {
+				*this = sphere;
+				return;
+			}
+
 			radius = 0.5f * (radius + sphere.radius + lc);
 			center = (center + dc * (0.5f * (lc + dr) / lc));
 		}
@@ -103,6 +111,41 @@ namespace NGTech
 		{
 			return (center - sphere.center).length() <= (radius + sphere.radius);
 		}
+
+		/**
+		Segment src-dst against the sphere, hit point is src + (dst - src) * t, t in [0, 1].
+		t is 0 when src is inside. Misses are found without a square root.
+		*/
+		ENGINE_INLINE bool IntersectsRay(const Vec3& src, const Vec3& dst, float& t) const
+		{
+			Vec3 oc = src - center;
+			float c = Vec3::dot(oc, oc) - radius * radius;
+			if (c <= 0) {
+				t = 0;
+				return true;
+			}
+
+			// roots of a * t^2 + 2 * b * t + c, the first one is in [0, 1] when the sphere
+			// is ahead, the line touches it and either dst is inside or the closest point is before dst
+			Vec3 d = dst - src;
+			float a = Vec3::dot(d, d);
+			float b = Vec3::dot(d, oc);
+			float disc = b * b - a * c;
+			if (!(b < 0 && disc >= 0 && (a + (b + b) + c <= 0 || -b <= a)))
+				return false;
+
+			t = Math::Min((-b - sqrtf(disc)) / a, Math::ONEFLOAT);
+			return true;
+		}
+
+		/**
+		Sphere around count points. By default Ritter's method: the sphere through the farthest pair
+		of the 6 axis extremes grows over the points (4 or 8 at a time), then the radius shrinks to
+		the farthest point. exact finds the minimal sphere with Welzl's algorithm, this pass is
+		sequential and works on a shuffled copy of the points.
+		Big arrays are split over the Parallel threads, so the Ritter sphere may depend on the thread count.
+		*/
+		static BSphere FromPoints(const Vec3* points, size_t count, bool exact = false);
 	};
 
 	extern BSphere operator*(const Mat4& a, const BSphere& s);
@@ -0,0 +1,698 @@
+/* Copyright (C) 2009-2020, Nick Galko Ltd. All rights reserved.
+*
+* This file is part of the NGTech (https://galek.github.io/portfolio/).
+*
+* Your use and or redistribution of this software in source and / or
+* binary form, with or without modification, is subject to: (i) your
+* ongoing acceptance of and compliance with the terms and conditions of
+* the NGTech License Agreement; and (ii) your inclusion of this notice
+* in any version of this software that you use or redistribute.
+* A copy of the NGTech License Agreement is available by contacting
+* Nick Galko Ltd. at https://galek.github.io/portfolio/
+*/
+//***************************************************************************
+#include <algorithm>
+#include <stdint.h>
+//***************************************************************************
+#include "BVH.h"
+#include "BBox.h"
+#include "SIMD.h"
+#include "Parallel.h"
+//***************************************************************************
+
+namespace NGTech
+{
+	/*
+	Build parameters. Cost of a node is TRAVERSAL_COST * area + sum of child area * primitive count
+	*/
+	static const int SAH_BINS = 16;
+	static const float TRAVERSAL_COST = 1.0f;
+	static const size_t MAX_LEAF_SIZE = 8;
+	/*
+	Deeper nodes are split in the middle, which bounds the depth (and the traversal stack)
+	*/
+	static const int MAX_SAH_DEPTH = 48;
+	static const int STACK_SIZE = 128;
+
+	static const size_t MIN_PRIMITIVES_PER_THREAD = 16384;
+	static const size_t MIN_PRIMITIVES_PER_TASK = 4096;
+
+	static ENGINE_INLINE Vec3 _Min(const Vec3& a, const Vec3& b) {
+		return Vec3(Math::Min(a.x, b.x), Math::Min(a.y, b.y), Math::Min(a.z, b.z));
+	}
+
+	static ENGINE_INLINE Vec3 _Max(const Vec3& a, const Vec3& b) {
+		return Vec3(Math::Max(a.x, b.x), Math::Max(a.y, b.y), Math::Max(a.z, b.z));
+	}
+
+	struct _Bounds
+	{
+		Vec3 mins, maxes;
+
+		_Bounds() : mins(FLT_MAX, FLT_MAX, FLT_MAX), maxes(-FLT_MAX, -FLT_MAX, -FLT_MAX) {}
+
+		ENGINE_INLINE void Add(const Vec3& lo, const Vec3& hi) {
+			mins = _Min(mins, lo);
+			maxes = _Max(maxes, hi);
+		}
+
+		ENGINE_INLINE void Add(const _Bounds& b) {
+			Add(b.mins, b.maxes);
+		}
+
+		/*
+		Half of the surface area
+		*/
+		ENGINE_INLINE float Area() const {
+			Vec3 d = maxes - mins;
+			return (d.x < 0) ? 0 : d.x * d.y + d.y * d.z + d.z * d.x;
+		}
+	};
+
+	/*
+	Primitives are partitioned in place, so the passes over a node read memory in order
+	*/
+	struct _PrimRef
+	{
+		Vec3 mins;
+		uint32_t index;
+		Vec3 maxes;
+		float pad;
+
+		ENGINE_INLINE Vec3 Center() const {
+			return (mins + maxes) * 0.5f;
+		}
+	};
+
+	struct _Bin
+	{
+		_Bounds bounds;
+		size_t count = 0;
+	};
+
+	struct _BoundsState
+	{
+		_Bounds bounds, centers;
+	};
+
+	struct _BinState
+	{
+		_Bin bins[3][SAH_BINS];
+	};
+
+	/*
+	Bins of the center along every axis
+	*/
+	struct _Binning
+	{
+		Vec3 origin;
+		float scale[3];
+		int count;
+
+		ENGINE_INLINE int Index(const _PrimRef& r, int axis) const {
+			int bin = (int)((r.Center()[axis] - origin[axis]) * scale[axis]);
+			return Math::Clamp(bin, 0, count - 1);
+		}
+	};
+
+	/*
+	Passes over the primitives of a node, accumulated to state. The SSE4.1 versions
+	keep the bins in registers and give the same results.
+	*/
+	static void _BoundsScalar(const _PrimRef* refs, size_t begin, size_t end, _BoundsState& state)
+	{
+		for (size_t i = begin; i < end; i++) {
+			const _PrimRef& r = refs[i];
+			Vec3 c = r.Center();
+			state.bounds.Add(r.mins, r.maxes);
+			state.centers.Add(c, c);
+		}
+	}
+
+	static void _BinScalar(const _PrimRef* refs, size_t begin, size_t end, const _Binning& binning, _BinState& state)
+	{
+		for (size_t i = begin; i < end; i++) {
+			const _PrimRef& r = refs[i];
+			for (int a = 0; a < 3; a++) {
+				_Bin& bin = state.bins[a][binning.Index(r, a)];
+				bin.bounds.Add(r.mins, r.maxes);
+				bin.count++;
+			}
+		}
+	}
+
+#if MATH_SIMD_X86
+	ENGINE_TARGET_SSE41 static ENGINE_INLINE __m128 _LoadVec3(const Vec3& v) {
+		return _mm_setr_ps(v.x, v.y, v.z, 0);
+	}
+
+	ENGINE_TARGET_SSE41 static ENGINE_INLINE void _StoreVec3(Vec3& v, __m128 r) {
+		float f[4];
+		_mm_storeu_ps(f, r);
+		v = Vec3(f[0], f[1], f[2]);
+	}
+
+	/*
+	w is the index or padding, it is cleared so it can not be a denormal
+	*/
+	ENGINE_TARGET_SSE41 static ENGINE_INLINE __m128 _LoadRef(const Vec3* v) {
+		return _mm_blend_ps(_mm_loadu_ps(&v->x), _mm_setzero_ps(), 0x8);
+	}
+
+	ENGINE_TARGET_SSE41 static void _BoundsSSE41(const _PrimRef* refs, size_t begin, size_t end, _BoundsState& state)
+	{
+		__m128 half = _mm_set1_ps(0.5f);
+		__m128 lo = _LoadVec3(state.bounds.mins), hi = _LoadVec3(state.bounds.maxes);
+		__m128 cLo = _LoadVec3(state.centers.mins), cHi = _LoadVec3(state.centers.maxes);
+
+		for (size_t i = begin; i < end; i++) {
+			__m128 mins = _LoadRef(&refs[i].mins), maxes = _LoadRef(&refs[i].maxes);
+			__m128 c = _mm_mul_ps(_mm_add_ps(mins, maxes), half);
+			lo = _mm_min_ps(lo, mins);
+			hi = _mm_max_ps(hi, maxes);
+			cLo = _mm_min_ps(cLo, c);
+			cHi = _mm_max_ps(cHi, c);
+		}
+
+		_StoreVec3(state.bounds.mins, lo);
+		_StoreVec3(state.bounds.maxes, hi);
+		_StoreVec3(state.centers.mins, cLo);
+		_StoreVec3(state.centers.maxes, cHi);
+	}
+
+	ENGINE_TARGET_SSE41 static void _BinSSE41(const _PrimRef* refs, size_t begin, size_t end, const _Binning& binning, _BinState& state)
+	{
+		__m128 lo[3][SAH_BINS], hi[3][SAH_BINS];
+		for (int a = 0; a < 3; a++)
+			for (int b = 0; b < binning.count; b++) {
+				lo[a][b] = _LoadVec3(state.bins[a][b].bounds.mins);
+				hi[a][b] = _LoadVec3(state.bins[a][b].bounds.maxes);
+			}
+
+		__m128 half = _mm_set1_ps(0.5f);
+		__m128 origin = _LoadVec3(binning.origin);
+		__m128 scale = _mm_setr_ps(binning.scale[0], binning.scale[1], binning.scale[2], 0);
+		__m128i last = _mm_set1_epi32(binning.count - 1);
+
+		for (size_t i = begin; i < end; i++) {
+			__m128 mins = _LoadRef(&refs[i].mins), maxes = _LoadRef(&refs[i].maxes);
+			__m128 c = _mm_mul_ps(_mm_add_ps(mins, maxes), half);
+			__m128i bin = _mm_cvttps_epi32(_mm_mul_ps(_mm_sub_ps(c, origin), scale));
+			bin = _mm_min_epi32(_mm_max_epi32(bin, _mm_setzero_si128()), last);
+
+			int bx = _mm_cvtsi128_si32(bin), by = _mm_extract_epi32(bin, 1), bz = _mm_extract_epi32(bin, 2);
+			lo[0][bx] = _mm_min_ps(lo[0][bx], mins); hi[0][bx] = _mm_max_ps(hi[0][bx], maxes);
+			lo[1][by] = _mm_min_ps(lo[1][by], mins); hi[1][by] = _mm_max_ps(hi[1][by], maxes);
+			lo[2][bz] = _mm_min_ps(lo[2][bz], mins); hi[2][bz] = _mm_max_ps(hi[2][bz], maxes);
+			state.bins[0][bx].count++;
+			state.bins[1][by].count++;
+			state.bins[2][bz].count++;
+		}
+
+		for (int a = 0; a < 3; a++)
+			for (int b = 0; b < binning.count; b++) {
+				_StoreVec3(state.bins[a][b].bounds.mins, lo[a][b]);
+				_StoreVec3(state.bins[a][b].bounds.maxes, hi[a][b]);
+			}
+	}
+#endif
+
+	struct _BuildNode
+	{
+		_Bounds bounds;
+		size_t first = 0, count = 0;
+		int left = -1, right = -1;
+		int task = -1;
+	};
+
+	struct _BuildTask
+	{
+		size_t begin, end;
+		int depth;
+		std::vector<_BuildNode> nodes;
+	};
+
+	/*
+	Top-level builder: nodes of big ranges use all threads for their passes over the primitives,
+	ranges below taskSize become tasks built one per thread.
+	*/
+	struct _Builder
+	{
+		_PrimRef* refs;
+		size_t taskSize;
+		std::vector<_BuildTask> tasks;
+
+		/*
+		Big top ranges are split over the threads, tasks below the top already run one per thread
+		*/
+		static ENGINE_INLINE size_t _MinRange(bool top) {
+			return top ? MIN_PRIMITIVES_PER_THREAD : SIZE_MAX;
+		}
+
+		void ComputeBounds(size_t begin, size_t end, bool top, _Bounds& bounds, _Bounds& centers) const
+		{
+			_BoundsState result = Parallel::Reduce(end - begin, _MinRange(top), _BoundsState(), [this, begin](size_t first, size_t last, _BoundsState& state)
+			{
+				switch (SIMD::GetLevel())
+				{
+#if MATH_SIMD_X86
+				case SIMD::LEVEL_AVX2:
+				case SIMD::LEVEL_SSE41: _BoundsSSE41(refs, begin + first, begin + last, state); break;
+#endif
+				default: _BoundsScalar(refs, begin + first, begin + last, state); break;
+				}
+			}, [](_BoundsState& result, const _BoundsState& state)
+			{
+				result.bounds.Add(state.bounds);
+				result.centers.Add(state.centers);
+			});
+
+			bounds = result.bounds;
+			centers = result.centers;
+		}
+
+		/*
+		Returns the end of the left child, or begin when the range should be a leaf
+		*/
+		size_t Split(size_t begin, size_t end, bool top, const _Bounds& bounds, const _Bounds& centers, int depth) const
+		{
+			size_t count = end - begin;
+			if (count <= 1)
+				return begin;
+
+			Vec3 extent = centers.maxes - centers.mins;
+			int axis = (extent.x >= extent.y && extent.x >= extent.z) ? 0 : (extent.y >= extent.z ? 1 : 2);
+
+			if (depth < MAX_SAH_DEPTH && extent[axis] > 0)
+			{
+				// small nodes do not need more bins than primitives
+				_Binning binning;
+				binning.origin = centers.mins;
+				binning.count = (int)Math::Min<size_t>(count, SAH_BINS);
+				for (int a = 0; a < 3; a++)
+					binning.scale[a] = (extent[a] > 0) ? binning.count * (1.0f - 1e-5f) / extent[a] : 0;
+
+				_BinState result = Parallel::Reduce(count, _MinRange(top), _BinState(), [&](size_t first, size_t last, _BinState& state)
+				{
+					switch (SIMD::GetLevel())
+					{
+#if MATH_SIMD_X86
+					case SIMD::LEVEL_AVX2:
+					case SIMD::LEVEL_SSE41: _BinSSE41(refs, begin + first, begin + last, binning, state); break;
+#endif
+					default: _BinScalar(refs, begin + first, begin + last, binning, state); break;
+					}
+				}, [&binning](_BinState& result, const _BinState& state)
+				{
+					for (int a = 0; a < 3; a++)
+						for (int b = 0; b < binning.count; b++) {
+							result.bins[a][b].bounds.Add(state.bins[a][b].bounds);
+							result.bins[a][b].count += state.bins[a][b].count;
+						}
+				});
+
+				// sweep from both sides, split k puts bins [0, k] to the left
+				float bestCost = FLT_MAX;
+				int bestAxis = -1, bestSplit = -1;
+				for (int a = 0; a < 3; a++)
+				{
+					if (binning.scale[a] == 0)
+						continue;
+
+					const _Bin* bins = result.bins[a];
+					float rightCost[SAH_BINS];
+					_Bounds right;
+					size_t rightCount = 0;
+					for (int b = binning.count - 1; b > 0; b--) {
+						right.Add(bins[b].bounds);
+						rightCount += bins[b].count;
+						rightCost[b - 1] = right.Area() * rightCount;
+					}
+
+					_Bounds left;
+					size_t leftCount = 0;
+					for (int b = 0; b < binning.count - 1; b++) {
+						left.Add(bins[b].bounds);
+						leftCount += bins[b].count;
+						if (leftCount == 0 || leftCount == count)
+							continue;
+
+						float cost = left.Area() * leftCount + rightCost[b];
+						if (cost < bestCost) {
+							bestCost = cost;
+							bestAxis = a;
+							bestSplit = b;
+						}
+					}
+				}
+
+				if (bestAxis >= 0)
+				{
+					float area = bounds.Area();
+					if (count <= MAX_LEAF_SIZE && TRAVERSAL_COST * area + bestCost >= area * count)
+						return begin;
+
+					_PrimRef* mid = std::partition(refs + begin, refs + end, [&](const _PrimRef& r) {
+						return binning.Index(r, bestAxis) <= bestSplit;
+					});
+					return mid - refs;
+				}
+			}
+
+			if (count <= MAX_LEAF_SIZE)
+				return begin;
+
+			// all centers equal or too deep: median along the longest axis
+			size_t mid = begin + count / 2;
+			std::nth_element(refs + begin, refs + mid, refs + end, [&](const _PrimRef& a, const _PrimRef& b) {
+				return a.Center()[axis] < b.Center()[axis];
+			});
+			return mid;
+		}
+
+		int BuildRange(std::vector<_BuildNode>& nodes, size_t begin, size_t end, int depth, bool top)
+		{
+			int index = (int)nodes.size();
+			nodes.push_back(_BuildNode());
+
+			if (top && end - begin <= taskSize) {
+				nodes[index].task = (int)tasks.size();
+				tasks.push_back(_BuildTask{ begin, end, depth, std::vector<_BuildNode>() });
+				return index;
+			}
+
+			_Bounds bounds, centers;
+			ComputeBounds(begin, end, top, bounds, centers);
+			nodes[index].bounds = bounds;
+
+			size_t mid = Split(begin, end, top, bounds, centers, depth);
+			if (mid == begin) {
+				nodes[index].first = begin;
+				nodes[index].count = end - begin;
+				return index;
+			}
+
+			int left = BuildRange(nodes, begin, mid, depth + 1, top);
+			int right = BuildRange(nodes, mid, end, depth + 1, top);
+			nodes[index].left = left;
+			nodes[index].right = right;
+			return index;
+		}
+
+		void Flatten(const std::vector<_BuildNode>& nodes, int index, std::vector<BVH::Node>& out) const
+		{
+			const _BuildNode& node = nodes[index];
+			if (node.task >= 0) {
+				Flatten(tasks[node.task].nodes, 0, out);
+				return;
+			}
+
+			size_t at = out.size();
+			BVH::Node flat;
+			flat.mins = node.bounds.mins;
+			flat.maxes = node.bounds.maxes;
+			flat.offset = (uint32_t)node.first;
+			flat.count = (uint32_t)node.count;
+			out.push_back(flat);
+
+			if (node.left >= 0) {
+				Flatten(nodes, node.left, out);
+				out[at].offset = (uint32_t)out.size();
+				Flatten(nodes, node.right, out);
+			}
+		}
+	};
+
+	template<typename BOUNDS>
+	void BVH::_Build(const BOUNDS& primitiveBounds, size_t count)
+	{
+		Clear();
+		if (count == 0)
+			return;
+
+		std::vector<_PrimRef> refs(count);
+		Parallel::For(count, MIN_PRIMITIVES_PER_THREAD, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++) {
+				primitiveBounds(i, refs[i].mins, refs[i].maxes);
+				refs[i].index = (uint32_t)i;
+			}
+		});
+
+		_Builder builder;
+		builder.refs = refs.data();
+
+		unsigned int threads = Parallel::GetThreadCount();
+		builder.taskSize = (threads > 1) ? Math::Max(count / (threads * 4), MIN_PRIMITIVES_PER_TASK) : count;
+
+		std::vector<_BuildNode> top;
+		builder.BuildRange(top, 0, count, 0, true);
+
+		Parallel::For(builder.tasks.size(), 1, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++) {
+				_BuildTask& task = builder.tasks[i];
+				builder.BuildRange(task.nodes, task.begin, task.end, task.depth, false);
+			}
+		});
+
+		m_Nodes.reserve(count * 2);
+		builder.Flatten(top, 0, m_Nodes);
+		m_Nodes.shrink_to_fit();
+
+		m_Indices.resize(count);
+		for (size_t i = 0; i < count; i++)
+			m_Indices[i] = refs[i].index;
+	}
+
+	void BVH::Build(const BBox* boxes, size_t count)
+	{
+		_Build([boxes](size_t i, Vec3& mins, Vec3& maxes)
+		{
+			mins = boxes[i].mins;
+			maxes = boxes[i].maxes;
+		}, count);
+
+		m_bTriangles = false;
+		m_Primitives.resize(count * 2);
+		Parallel::For(count, MIN_PRIMITIVES_PER_THREAD, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++) {
+				const BBox& box = boxes[m_Indices[i]];
+				m_Primitives[i * 2 + 0] = box.mins;
+				m_Primitives[i * 2 + 1] = box.maxes;
+			}
+		});
+	}
+
+	void BVH::Build(const Vec3* vertices, const uint32_t* indices, size_t triangleCount)
+	{
+		auto vertex = [vertices, indices](size_t triangle, int corner) -> const Vec3& {
+			return vertices[indices ? indices[triangle * 3 + corner] : triangle * 3 + corner];
+		};
+
+		_Build([&vertex](size_t i, Vec3& mins, Vec3& maxes)
+		{
+			const Vec3& v0 = vertex(i, 0);
+			const Vec3& v1 = vertex(i, 1);
+			const Vec3& v2 = vertex(i, 2);
+			mins = _Min(v0, _Min(v1, v2));
+			maxes = _Max(v0, _Max(v1, v2));
+		}, triangleCount);
+
+		m_bTriangles = true;
+		m_Primitives.resize(triangleCount * 3);
+		Parallel::For(triangleCount, MIN_PRIMITIVES_PER_THREAD, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+				for (int corner = 0; corner < 3; corner++)
+					m_Primitives[i * 3 + corner] = vertex(m_Indices[i], corner);
+		});
+	}
+
+	void BVH::Clear()
+	{
+		m_Nodes.clear();
+		m_Indices.clear();
+		m_Primitives.clear();
+		m_bTriangles = false;
+	}
+
+	/*
+	Segment src + dir * t, t in [0, tMax]
+	*/
+	struct _Segment
+	{
+		Vec3 src, dir, invDir;
+
+		_Segment(const Vec3& _src, const Vec3& _dst) : src(_src), dir(_dst - _src) {
+			invDir = Vec3(Math::ONEFLOAT / dir.x, Math::ONEFLOAT / dir.y, Math::ONEFLOAT / dir.z);
+		}
+
+		ENGINE_INLINE bool IntersectBox(const Vec3& mins, const Vec3& maxes, float tMax, float& tEnter) const {
+			return BBox::IntersectsSlabs(mins, maxes, src, invDir, tMax, tEnter);
+		}
+	};
+
+	/*
+	Primitive tests for the traversal, hit is updated when closer than hit.t
+	*/
+	struct _BoxPrimitive
+	{
+		static ENGINE_INLINE bool Intersect(const _Segment& s, const Vec3* p, BVH::Hit& hit) {
+			float t;
+			if (!s.IntersectBox(p[0], p[1], hit.t, t))
+				return false;
+
+			hit.t = t;
+			hit.u = hit.v = 0;
+			return true;
+		}
+
+		static const int STRIDE = 2;
+	};
+
+	struct _TrianglePrimitive
+	{
+		static ENGINE_INLINE bool Intersect(const _Segment& s, const Vec3* p, BVH::Hit& hit) {
+			float t, u, v;
+			if (!Math::intersectTriangleBySegment(p[0], p[1], p[2], s.src, s.dir, hit.t, t, u, v))
+				return false;
+
+			hit.t = t;
+			hit.u = u;
+			hit.v = v;
+			return true;
+		}
+
+		static const int STRIDE = 3;
+	};
+
+	/*
+	Nearer child is visited first, nodes farther than the closest hit are skipped.
+	Without hit the first hit found is returned.
+	*/
+	template<typename PRIMITIVE>
+	bool BVH::_RayCast(const Vec3& src, const Vec3& dst, Hit* hit) const
+	{
+		if (m_Nodes.empty())
+			return false;
+
+		_Segment s(src, dst);
+		Hit best;
+		best.index = 0;
+		best.t = Math::ONEFLOAT;
+		best.u = best.v = 0;
+		bool found = false;
+
+		float tRoot;
+		if (!s.IntersectBox(m_Nodes[0].mins, m_Nodes[0].maxes, best.t, tRoot))
+			return false;
+
+		struct Entry { uint32_t node; float t; };
+		Entry stack[STACK_SIZE];
+		int top = 0;
+		stack[top++] = Entry{ 0, tRoot };
+
+		while (top > 0)
+		{
+			Entry entry = stack[--top];
+			if (entry.t > best.t)
+				continue;
+
+			const Node& node = m_Nodes[entry.node];
+			if (node.IsLeaf())
+			{
+				for (uint32_t i = node.offset; i < node.offset + node.count; i++)
+				{
+					if (!PRIMITIVE::Intersect(s, &m_Primitives[i * PRIMITIVE::STRIDE], best))
+						continue;
+
+					best.index = m_Indices[i];
+					found = true;
+					if (!hit)
+						return true;
+				}
+				continue;
+			}
+
+			uint32_t first = entry.node + 1, second = node.offset;
+			float tFirst, tSecond;
+			bool hitFirst = s.IntersectBox(m_Nodes[first].mins, m_Nodes[first].maxes, best.t, tFirst);
+			bool hitSecond = s.IntersectBox(m_Nodes[second].mins, m_Nodes[second].maxes, best.t, tSecond);
+
+			if (hitFirst && hitSecond && tSecond < tFirst) {
+				std::swap(first, second);
+				std::swap(tFirst, tSecond);
+			}
+
+			ASSERT(top + 2 <= STACK_SIZE, "[BVH] STACK OVERFLOW");
+			if (hitSecond)
+				stack[top++] = Entry{ second, tSecond };
+			if (hitFirst)
+				stack[top++] = Entry{ first, tFirst };
+		}
+
+		if (found && hit)
+			*hit = best;
+		return found;
+	}
+
+	bool BVH::RayCast(const Vec3& src, const Vec3& dst, Hit& hit) const
+	{
+		return m_bTriangles ? _RayCast<_TrianglePrimitive>(src, dst, &hit) : _RayCast<_BoxPrimitive>(src, dst, &hit);
+	}
+
+	bool BVH::RayCastAny(const Vec3& src, const Vec3& dst) const
+	{
+		return m_bTriangles ? _RayCast<_TrianglePrimitive>(src, dst, nullptr) : _RayCast<_BoxPrimitive>(src, dst, nullptr);
+	}
+
+	static ENGINE_INLINE bool _Overlaps(const Vec3& mins, const Vec3& maxes, const BBox& box)
+	{
+		return mins.x <= box.maxes.x && maxes.x >= box.mins.x
+			&& mins.y <= box.maxes.y && maxes.y >= box.mins.y
+			&& mins.z <= box.maxes.z && maxes.z >= box.mins.z;
+	}
+
+	size_t BVH::Overlap(const BBox& box, std::vector<uint32_t>& result) const
+	{
+		if (m_Nodes.empty())
+			return 0;
+
+		size_t before = result.size();
+		int stride = m_bTriangles ? 3 : 2;
+
+		uint32_t stack[STACK_SIZE];
+		int top = 0;
+		stack[top++] = 0;
+
+		while (top > 0)
+		{
+			uint32_t index = stack[--top];
+			const Node& node = m_Nodes[index];
+			if (!_Overlaps(node.mins, node.maxes, box))
+				continue;
+
+			if (!node.IsLeaf()) {
+				ASSERT(top + 2 <= STACK_SIZE, "[BVH] STACK OVERFLOW");
+				stack[top++] = node.offset;
+				stack[top++] = index + 1;
+				continue;
+			}
+
+			for (uint32_t i = node.offset; i < node.offset + node.count; i++)
+			{
+				const Vec3* p = &m_Primitives[i * stride];
+				bool overlaps = m_bTriangles
+					? _Overlaps(_Min(p[0], _Min(p[1], p[2])), _Max(p[0], _Max(p[1], p[2])), box)
+					: _Overlaps(p[0], p[1], box);
+
+				if (overlaps)
+					result.push_back(m_Indices[i]);
+			}
+		}
+
+		return result.size() - before;
+	}
+}
@@ -0,0 +1,117 @@
+/* Copyright (C) 2009-2020, Nick Galko Ltd. All rights reserved.
+*
+* This file is part of the NGTech (https://galek.github.io/portfolio/).
+*
+* Your use and or redistribution of this software in source and / or
+* binary form, with or without modification, is subject to: (i) your
+* ongoing acceptance of and compliance with the terms and conditions of
+* the NGTech License Agreement; and (ii) your inclusion of this notice
+* in any version of this software that you use or redistribute.
+* A copy of the NGTech License Agreement is available by contacting
+* Nick Galko Ltd. at https://galek.github.io/portfolio/
+*/
+#pragma once
+
+//***************************************************************************
+#include <vector>
+//***************************************************************************
+#include "MathLib.h"
+//***************************************************************************
+
+namespace NGTech
+{
+	class BBox;
+
+	/**
+	Bounding volume hierarchy over boxes or triangles, built with binned SAH.
+	Nodes are stored depth first: the left child follows its parent, so a node only keeps the
+	index of its right child or its range of primitives.
+	Rays are segments from src to dst, hit distances are fractions of dst - src.
+	*/
+	class BVH
+	{
+	public:
+		/**
+		Internal node: offset is the right child, count is 0.
+		Leaf: primitives [offset, offset + count) in the BVH order, GetPrimitiveIndex maps them back
+		*/
+		struct Node
+		{
+			Vec3 mins;
+			uint32_t offset;
+			Vec3 maxes;
+			uint32_t count;
+
+			ENGINE_INLINE bool IsLeaf() const { return count != 0; }
+		};
+
+		struct Hit
+		{
+			/**
+			Index of the box or triangle as passed to Build
+			*/
+			uint32_t index;
+			/**
+			Hit point is src + (dst - src) * t
+			*/
+			float t;
+			/**
+			Barycentrics of the hit point, v1 * u + v2 * v + v0 * (1 - u - v). 0 for boxes
+			*/
+			float u, v;
+		};
+
+		BVH() {}
+
+		/**
+		Rebuilds the hierarchy. Big inputs are split over the Parallel threads.
+		Triangles are 3 indices into vertices each, or 3 consecutive vertices when indices is nullptr.
+		*/
+		void Build(const BBox* boxes, size_t count);
+		void Build(const Vec3* vertices, const uint32_t* indices, size_t triangleCount);
+
+		void Clear();
+
+		/**
+		Closest hit along the segment. Boxes are hit where the segment enters them (t = 0 when src is inside),
+		triangles are tested with Math::intersectTriangleByRay
+		*/
+		bool RayCast(const Vec3& src, const Vec3& dst, Hit& hit) const;
+		/**
+		Any hit along the segment, for line of sight checks
+		*/
+		bool RayCastAny(const Vec3& src, const Vec3& dst) const;
+
+		/**
+		Appends indices of the primitives whose bounds overlap box (touching counts),
+		returns the number of indices added
+		*/
+		size_t Overlap(const BBox& box, std::vector<uint32_t>& result) const;
+
+		ENGINE_INLINE bool IsEmpty() const { return m_Nodes.empty(); }
+		ENGINE_INLINE size_t GetNodeCount() const { return m_Nodes.size(); }
+		ENGINE_INLINE const Node* GetNodes() const { return m_Nodes.data(); }
+		ENGINE_INLINE uint32_t GetPrimitiveIndex(size_t i) const { return m_Indices[i]; }
+
+	private:
+		template<typename PRIMITIVE>
+		bool _RayCast(const Vec3& src, const Vec3& dst, Hit* hit) const;
+
+		template<typename BOUNDS>
+		void _Build(const BOUNDS& bounds, size_t count);
+
+	private:
+		std::vector<Node> m_Nodes;
+		/**
+		Original index of every primitive in the BVH order
+		*/
+		std::vector<uint32_t> m_Indices;
+		/**
+		Primitives in the BVH order: mins and maxes per box, or 3 vertices per triangle
+		*/
+		std::vector<Vec3> m_Primitives;
+		bool m_bTriangles = false;
+	};
+
+	static_assert(sizeof(BVH::Node) == 8 * sizeof(float), "Invalid BVH::Node padding!");
+}
@@ -0,0 +1,602 @@
+/* Copyright (C) 2009-2020, Nick Galko Ltd. All rights reserved.
+*
+* This file is part of the NGTech (https://galek.github.io/portfolio/).
+*
+* Your use and or redistribution of this software in source and / or
+* binary form, with or without modification, is subject to: (i) your
+* ongoing acceptance of and compliance with the terms and conditions of
+* the NGTech License Agreement; and (ii) your inclusion of this notice
+* in any version of this software that you use or redistribute.
+* A copy of the NGTech License Agreement is available by contacting
+* Nick Galko Ltd. at https://galek.github.io/portfolio/
+*/
+//***************************************************************************
+#include <math.h>
+#include <string.h>
+//***************************************************************************
+#include "ColorBatch.h"
+#include "SIMD.h"
+#include "Parallel.h"
+//***************************************************************************
+
+namespace NGTech
+{
+	/*
+	Encoding: codes[i] is the sRGB code of i / SRGB_BUCKETS. The curve rises by less than one code
+	per bucket (max slope is 12.92 * 255 / 4096 = 0.8), so the exact code of x in bucket i is
+	codes[i] or codes[i] + 1, decided by thresholds[codes[i] + 1], the smallest float encoded to that code.
+	*/
+	static const int SRGB_BUCKETS = 4096;
+
+	struct _SRGBTables
+	{
+		float toLinear[256];
+		float unorm[256];
+		uint8_t codes[SRGB_BUCKETS + 1 + 3];		// padded for 32-bit gathers
+		float thresholds[257];
+
+		_SRGBTables();
+	};
+
+	static double _EncodeSRGB(double x) {
+		return (x <= 0.0031308) ? x * 12.92 : 1.055 * pow(x, 1.0 / 2.4) - 0.055;
+	}
+
+	static int _EncodeSRGBReference(float x) {
+		return (int)floor(_EncodeSRGB(x) * 255.0 + 0.5);
+	}
+
+	_SRGBTables::_SRGBTables()
+	{
+		for (int c = 0; c < 256; c++) {
+			double v = c / 255.0;
+			toLinear[c] = (float)((v <= 0.04045) ? v / 12.92 : pow((v + 0.055) / 1.055, 2.4));
+			unorm[c] = c / 255.0f;
+		}
+
+		for (int i = 0; i < SRGB_BUCKETS + 4; i++)
+			codes[i] = (i <= SRGB_BUCKETS) ? (uint8_t)_EncodeSRGBReference((float)i / SRGB_BUCKETS) : 0;
+
+		// positive floats are ordered like their bit patterns
+		const uint32_t oneBits = 0x3f800000u;
+		thresholds[0] = 0;
+		for (int k = 1; k < 256; k++) {
+			uint32_t lo = 0, hi = oneBits;
+			while (lo < hi) {
+				uint32_t mid = lo + (hi - lo) / 2;
+				float f;
+				memcpy(&f, &mid, sizeof(f));
+				if (_EncodeSRGBReference(f) >= k)
+					hi = mid;
+				else
+					lo = mid + 1;
+			}
+			memcpy(&thresholds[k], &lo, sizeof(float));
+		}
+		thresholds[256] = std::numeric_limits<float>::infinity();
+	}
+
+	static ENGINE_INLINE const _SRGBTables& _Tables()
+	{
+		static const _SRGBTables tables;
+		return tables;
+	}
+
+	/*
+	NaN goes to 0 like _mm_max_ps(x, 0)
+	*/
+	static ENGINE_INLINE float _Saturate(float x) {
+		x = (x > 0) ? x : 0;
+		return (x < 1) ? x : 1;
+	}
+
+	static ENGINE_INLINE uint32_t _Encode(const _SRGBTables& t, float x) {
+		x = _Saturate(x);
+		uint32_t c = t.codes[(int)(x * SRGB_BUCKETS)];
+		return c + (x >= t.thresholds[c + 1] ? 1 : 0);
+	}
+
+	static ENGINE_INLINE uint32_t _EncodeUnorm(float x) {
+		return (uint32_t)(int)(_Saturate(x) * 255.0f + 0.5f);
+	}
+
+	/*
+	Pixels are handled as 32-bit little endian values, shifts of the red and blue channels
+	are 16 and 0 for ARGB32, 0 and 16 for RGBA8
+	*/
+	static void _ToLinearScalar(const _SRGBTables& t, const uint8_t* in, Color* out, size_t begin, size_t count, int rShift, int bShift)
+	{
+		for (size_t i = begin; i < count; i++) {
+			uint32_t p;
+			memcpy(&p, in + i * 4, sizeof(p));
+			out[i] = Color(t.toLinear[(p >> rShift) & 0xff], t.toLinear[(p >> 8) & 0xff], t.toLinear[(p >> bShift) & 0xff], t.unorm[p >> 24]);
+		}
+	}
+
+	static void _FromLinearScalar(const _SRGBTables& t, const Color* in, uint8_t* out, size_t begin, size_t count, int rShift, int bShift)
+	{
+		for (size_t i = begin; i < count; i++) {
+			const Color& c = in[i];
+			uint32_t p = _Encode(t, c.x) << rShift | _Encode(t, c.y) << 8 | _Encode(t, c.z) << bShift | _EncodeUnorm(c.w) << 24;
+			memcpy(out + i * 4, &p, sizeof(p));
+		}
+	}
+
+#if MATH_SIMD_X86
+	ENGINE_TARGET_AVX2 static size_t _ToLinearAVX2(const _SRGBTables& t, const uint8_t* in, Color* out, size_t count, int rShift, int bShift)
+	{
+		__m256i mask = _mm256_set1_epi32(0xff);
+		__m128i rs = _mm_cvtsi32_si128(rShift), bs = _mm_cvtsi32_si128(bShift);
+
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256i p = _mm256_loadu_si256((const __m256i*)(in + i * 4));
+			__m256 r = _mm256_i32gather_ps(t.toLinear, _mm256_and_si256(_mm256_srl_epi32(p, rs), mask), 4);
+			__m256 g = _mm256_i32gather_ps(t.toLinear, _mm256_and_si256(_mm256_srli_epi32(p, 8), mask), 4);
+			__m256 b = _mm256_i32gather_ps(t.toLinear, _mm256_and_si256(_mm256_srl_epi32(p, bs), mask), 4);
+			__m256 a = _mm256_i32gather_ps(t.unorm, _mm256_srli_epi32(p, 24), 4);
+
+			// pixels 0-3 in the low lanes, 4-7 in the high lanes
+			SIMD::Transpose4x4(r, g, b, a);
+			float* o = out[i].f;
+			_mm256_storeu_ps(o + 0, _mm256_permute2f128_ps(r, g, 0x20));
+			_mm256_storeu_ps(o + 8, _mm256_permute2f128_ps(b, a, 0x20));
+			_mm256_storeu_ps(o + 16, _mm256_permute2f128_ps(r, g, 0x31));
+			_mm256_storeu_ps(o + 24, _mm256_permute2f128_ps(b, a, 0x31));
+		}
+		return i;
+	}
+
+	ENGINE_TARGET_AVX2 static ENGINE_INLINE __m256 _SaturateAVX2(__m256 x)
+	{
+		return _mm256_min_ps(_mm256_max_ps(x, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+	}
+
+	ENGINE_TARGET_AVX2 static ENGINE_INLINE __m256i _EncodeAVX2(const _SRGBTables& t, __m256 x)
+	{
+		x = _SaturateAVX2(x);
+		__m256i idx = _mm256_cvttps_epi32(_mm256_mul_ps(x, _mm256_set1_ps((float)SRGB_BUCKETS)));
+		__m256i c = _mm256_and_si256(_mm256_i32gather_epi32((const int*)t.codes, idx, 1), _mm256_set1_epi32(0xff));
+		__m256 thr = _mm256_i32gather_ps(t.thresholds + 1, c, 4);
+		// the compare mask is -1 where the next code is reached
+		return _mm256_sub_epi32(c, _mm256_castps_si256(_mm256_cmp_ps(x, thr, _CMP_GE_OQ)));
+	}
+
+	ENGINE_TARGET_AVX2 static size_t _FromLinearAVX2(const _SRGBTables& t, const Color* in, uint8_t* out, size_t count, int rShift, int bShift)
+	{
+		__m128i rs = _mm_cvtsi32_si128(rShift), bs = _mm_cvtsi32_si128(bShift);
+
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			const float* p = in[i].f;
+			__m256 c01 = _mm256_loadu_ps(p + 0), c23 = _mm256_loadu_ps(p + 8), c45 = _mm256_loadu_ps(p + 16), c67 = _mm256_loadu_ps(p + 24);
+			__m256 r = _mm256_permute2f128_ps(c01, c45, 0x20);
+			__m256 g = _mm256_permute2f128_ps(c01, c45, 0x31);
+			__m256 b = _mm256_permute2f128_ps(c23, c67, 0x20);
+			__m256 a = _mm256_permute2f128_ps(c23, c67, 0x31);
+			SIMD::Transpose4x4(r, g, b, a);
+
+			__m256i ia = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(_SaturateAVX2(a), _mm256_set1_ps(255.0f)), _mm256_set1_ps(0.5f)));
+			__m256i px = _mm256_or_si256(_mm256_sll_epi32(_EncodeAVX2(t, r), rs), _mm256_slli_epi32(_EncodeAVX2(t, g), 8));
+			px = _mm256_or_si256(px, _mm256_or_si256(_mm256_sll_epi32(_EncodeAVX2(t, b), bs), _mm256_slli_epi32(ia, 24)));
+			_mm256_storeu_si256((__m256i*)(out + i * 4), px);
+		}
+		return i;
+	}
+#endif
+
+	static void _ToLinear(const uint8_t* in, Color* out, size_t count, int rShift, int bShift)
+	{
+		const _SRGBTables& t = _Tables();
+
+		size_t i = 0;
+#if MATH_SIMD_X86
+		if (SIMD::GetLevel() == SIMD::LEVEL_AVX2)
+			i = _ToLinearAVX2(t, in, out, count, rShift, bShift);
+#endif
+		_ToLinearScalar(t, in, out, i, count, rShift, bShift);
+	}
+
+	static void _FromLinear(const Color* in, uint8_t* out, size_t count, int rShift, int bShift)
+	{
+		const _SRGBTables& t = _Tables();
+
+		size_t i = 0;
+#if MATH_SIMD_X86
+		if (SIMD::GetLevel() == SIMD::LEVEL_AVX2)
+			i = _FromLinearAVX2(t, in, out, count, rShift, bShift);
+#endif
+		_FromLinearScalar(t, in, out, i, count, rShift, bShift);
+	}
+
+	/*
+	Colour kernels. An operation has Scalar, SSE41 (one colour) and AVX2 (two colours) versions,
+	_Map runs it over an array.
+	*/
+	static const size_t MIN_PIXELS_PER_THREAD = 65536;
+
+#if MATH_SIMD_X86
+	template<typename OP>
+	ENGINE_TARGET_SSE41 static size_t _MapSSE41(const OP& op, const Color* in, Color* out, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+			_mm_storeu_ps(out[i].f, op.SSE41(_mm_loadu_ps(in[i].f)));
+		return end;
+	}
+
+	template<typename OP>
+	ENGINE_TARGET_AVX2 static size_t _MapAVX2(const OP& op, const Color* in, Color* out, size_t begin, size_t end)
+	{
+		size_t i = begin;
+		for (; i + 2 <= end; i += 2)
+			_mm256_storeu_ps(out[i].f, op.AVX2(_mm256_loadu_ps(in[i].f)));
+		return _MapSSE41(op, in, out, i, end);
+	}
+#endif
+
+	template<typename OP>
+	static void _Map(const OP& op, const Color* in, Color* out, size_t count)
+	{
+		Parallel::For(count, MIN_PIXELS_PER_THREAD, [&](size_t begin, size_t end)
+		{
+			size_t i = begin;
+
+			SIMD_DISPATCH(i, _Map, op, in, out, begin, end);
+
+			for (; i < end; i++)
+				out[i] = op.Scalar(in[i]);
+		});
+	}
+
+	struct _Premultiply
+	{
+		ENGINE_INLINE Color Scalar(const Color& c) const {
+			return Color(c.x * c.w, c.y * c.w, c.z * c.w, c.w);
+		}
+
+#if MATH_SIMD_X86
+		ENGINE_TARGET_SSE41 ENGINE_INLINE __m128 SSE41(__m128 c) const {
+			__m128 a = _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 3, 3));
+			return _mm_blend_ps(_mm_mul_ps(c, a), c, 0x8);
+		}
+
+		ENGINE_TARGET_AVX2 ENGINE_INLINE __m256 AVX2(__m256 c) const {
+			__m256 a = _mm256_permute_ps(c, _MM_SHUFFLE(3, 3, 3, 3));
+			return _mm256_blend_ps(_mm256_mul_ps(c, a), c, 0x88);
+		}
+#endif
+	};
+
+	struct _Unpremultiply
+	{
+		ENGINE_INLINE Color Scalar(const Color& c) const {
+			float inv = (c.w > 0) ? Math::ONEFLOAT / c.w : 0;
+			return Color(c.x * inv, c.y * inv, c.z * inv, c.w);
+		}
+
+#if MATH_SIMD_X86
+		ENGINE_TARGET_SSE41 ENGINE_INLINE __m128 SSE41(__m128 c) const {
+			__m128 a = _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 3, 3));
+			__m128 inv = _mm_and_ps(_mm_div_ps(_mm_set1_ps(1.0f), a), _mm_cmpgt_ps(a, _mm_setzero_ps()));
+			return _mm_blend_ps(_mm_mul_ps(c, inv), c, 0x8);
+		}
+
+		ENGINE_TARGET_AVX2 ENGINE_INLINE __m256 AVX2(__m256 c) const {
+			__m256 a = _mm256_permute_ps(c, _MM_SHUFFLE(3, 3, 3, 3));
+			__m256 inv = _mm256_and_ps(_mm256_div_ps(_mm256_set1_ps(1.0f), a), _mm256_cmp_ps(a, _mm256_setzero_ps(), _CMP_GT_OQ));
+			return _mm256_blend_ps(_mm256_mul_ps(c, inv), c, 0x88);
+		}
+#endif
+	};
+
+	struct _Exposure
+	{
+		float scale;
+
+		ENGINE_INLINE Color Scalar(const Color& c) const {
+			return Color(c.x * scale, c.y * scale, c.z * scale, c.w);
+		}
+
+#if MATH_SIMD_X86
+		ENGINE_TARGET_SSE41 ENGINE_INLINE __m128 SSE41(__m128 c) const {
+			return _mm_blend_ps(_mm_mul_ps(c, _mm_set1_ps(scale)), c, 0x8);
+		}
+
+		ENGINE_TARGET_AVX2 ENGINE_INLINE __m256 AVX2(__m256 c) const {
+			return _mm256_blend_ps(_mm256_mul_ps(c, _mm256_set1_ps(scale)), c, 0x88);
+		}
+#endif
+	};
+
+	struct _Reinhard
+	{
+		static ENGINE_INLINE float Channel(float x) {
+			return x / (Math::ONEFLOAT + x);
+		}
+
+		ENGINE_INLINE Color Scalar(const Color& c) const {
+			return Color(Channel(c.x), Channel(c.y), Channel(c.z), c.w);
+		}
+
+#if MATH_SIMD_X86
+		ENGINE_TARGET_SSE41 ENGINE_INLINE __m128 SSE41(__m128 c) const {
+			return _mm_blend_ps(_mm_div_ps(c, _mm_add_ps(_mm_set1_ps(1.0f), c)), c, 0x8);
+		}
+
+		ENGINE_TARGET_AVX2 ENGINE_INLINE __m256 AVX2(__m256 c) const {
+			return _mm256_blend_ps(_mm256_div_ps(c, _mm256_add_ps(_mm256_set1_ps(1.0f), c)), c, 0x88);
+		}
+#endif
+	};
+
+	/*
+	(x * (a * x + b)) / (x * (c * x + d) + e)
+	*/
+	static const float ACES_A = 2.51f;
+	static const float ACES_B = 0.03f;
+	static const float ACES_C = 2.43f;
+	static const float ACES_D = 0.59f;
+	static const float ACES_E = 0.14f;
+
+	struct _ACES
+	{
+		static ENGINE_INLINE float Channel(float x) {
+			return _Saturate((x * (ACES_A * x + ACES_B)) / (x * (ACES_C * x + ACES_D) + ACES_E));
+		}
+
+		ENGINE_INLINE Color Scalar(const Color& c) const {
+			return Color(Channel(c.x), Channel(c.y), Channel(c.z), c.w);
+		}
+
+#if MATH_SIMD_X86
+		ENGINE_TARGET_SSE41 ENGINE_INLINE __m128 SSE41(__m128 c) const {
+			__m128 num = _mm_mul_ps(c, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(ACES_A), c), _mm_set1_ps(ACES_B)));
+			__m128 den = _mm_add_ps(_mm_mul_ps(c, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(ACES_C), c), _mm_set1_ps(ACES_D))), _mm_set1_ps(ACES_E));
+			__m128 r = _mm_min_ps(_mm_max_ps(_mm_div_ps(num, den), _mm_setzero_ps()), _mm_set1_ps(1.0f));
+			return _mm_blend_ps(r, c, 0x8);
+		}
+
+		ENGINE_TARGET_AVX2 ENGINE_INLINE __m256 AVX2(__m256 c) const {
+			__m256 num = _mm256_mul_ps(c, _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(ACES_A), c), _mm256_set1_ps(ACES_B)));
+			__m256 den = _mm256_add_ps(_mm256_mul_ps(c, _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(ACES_C), c), _mm256_set1_ps(ACES_D))), _mm256_set1_ps(ACES_E));
+			__m256 r = _mm256_min_ps(_mm256_max_ps(_mm256_div_ps(num, den), _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+			return _mm256_blend_ps(r, c, 0x88);
+		}
+#endif
+	};
+
+	/*
+	from * (1 - frac) + to * frac, like Color::Lerp
+	*/
+	static void _LerpScalar(const Color* from, const Color* to, float frac, Color* out, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+			out[i] = Color::Lerp(from[i], to[i], frac);
+	}
+
+#if MATH_SIMD_X86
+	ENGINE_TARGET_SSE41 static size_t _LerpSSE41(const Color* from, const Color* to, float frac, Color* out, size_t begin, size_t end)
+	{
+		__m128 t = _mm_set1_ps(frac), s = _mm_set1_ps(1 - frac);
+		for (size_t i = begin; i < end; i++)
+			_mm_storeu_ps(out[i].f, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(from[i].f), s), _mm_mul_ps(_mm_loadu_ps(to[i].f), t)));
+		return end;
+	}
+
+	ENGINE_TARGET_AVX2 static size_t _LerpAVX2(const Color* from, const Color* to, float frac, Color* out, size_t begin, size_t end)
+	{
+		__m256 t = _mm256_set1_ps(frac), s = _mm256_set1_ps(1 - frac);
+
+		size_t i = begin;
+		for (; i + 2 <= end; i += 2)
+			_mm256_storeu_ps(out[i].f, _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(from[i].f), s), _mm256_mul_ps(_mm256_loadu_ps(to[i].f), t)));
+		return _LerpSSE41(from, to, frac, out, i, end);
+	}
+#endif
+
+	/*
+	ARGB32 without gamma, 4 (SSE4.1) or 8 (AVX2) pixels are converted as channel registers
+	and transposed
+	*/
+	static void _UnpackScalar(const uint32_t* in, Color* out, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++) {
+			uint32_t p = in[i];
+			out[i] = Color(((p >> 16) & 0xff) / 255.0f, ((p >> 8) & 0xff) / 255.0f, (p & 0xff) / 255.0f, (p >> 24) / 255.0f);
+		}
+	}
+
+	static void _PackScalar(const Color* in, uint32_t* out, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++) {
+			const Color& c = in[i];
+			out[i] = _EncodeUnorm(c.x) << 16 | _EncodeUnorm(c.y) << 8 | _EncodeUnorm(c.z) | _EncodeUnorm(c.w) << 24;
+		}
+	}
+
+#if MATH_SIMD_X86
+	ENGINE_TARGET_SSE41 static size_t _UnpackSSE41(const uint32_t* in, Color* out, size_t begin, size_t end)
+	{
+		__m128i mask = _mm_set1_epi32(0xff);
+		__m128 d = _mm_set1_ps(255.0f);
+
+		size_t i = begin;
+		for (; i + 4 <= end; i += 4)
+		{
+			__m128i p = _mm_loadu_si128((const __m128i*)(in + i));
+			__m128 r = _mm_div_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(p, 16), mask)), d);
+			__m128 g = _mm_div_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(p, 8), mask)), d);
+			__m128 b = _mm_div_ps(_mm_cvtepi32_ps(_mm_and_si128(p, mask)), d);
+			__m128 a = _mm_div_ps(_mm_cvtepi32_ps(_mm_srli_epi32(p, 24)), d);
+
+			_MM_TRANSPOSE4_PS(r, g, b, a);
+			_mm_storeu_ps(out[i + 0].f, r);
+			_mm_storeu_ps(out[i + 1].f, g);
+			_mm_storeu_ps(out[i + 2].f, b);
+			_mm_storeu_ps(out[i + 3].f, a);
+		}
+		return i;
+	}
+
+	ENGINE_TARGET_SSE41 static ENGINE_INLINE __m128i _EncodeUnormSSE41(__m128 x)
+	{
+		x = _mm_min_ps(_mm_max_ps(x, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+		return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+	}
+
+	ENGINE_TARGET_SSE41 static size_t _PackSSE41(const Color* in, uint32_t* out, size_t begin, size_t end)
+	{
+		size_t i = begin;
+		for (; i + 4 <= end; i += 4)
+		{
+			__m128 r = _mm_loadu_ps(in[i + 0].f), g = _mm_loadu_ps(in[i + 1].f), b = _mm_loadu_ps(in[i + 2].f), a = _mm_loadu_ps(in[i + 3].f);
+			_MM_TRANSPOSE4_PS(r, g, b, a);
+
+			__m128i px = _mm_or_si128(_mm_slli_epi32(_EncodeUnormSSE41(r), 16), _mm_slli_epi32(_EncodeUnormSSE41(g), 8));
+			px = _mm_or_si128(px, _mm_or_si128(_EncodeUnormSSE41(b), _mm_slli_epi32(_EncodeUnormSSE41(a), 24)));
+			_mm_storeu_si128((__m128i*)(out + i), px);
+		}
+		return i;
+	}
+
+	ENGINE_TARGET_AVX2 static size_t _UnpackAVX2(const uint32_t* in, Color* out, size_t begin, size_t end)
+	{
+		__m256i mask = _mm256_set1_epi32(0xff);
+		__m256 d = _mm256_set1_ps(255.0f);
+
+		size_t i = begin;
+		for (; i + 8 <= end; i += 8)
+		{
+			__m256i p = _mm256_loadu_si256((const __m256i*)(in + i));
+			__m256 r = _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(p, 16), mask)), d);
+			__m256 g = _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(p, 8), mask)), d);
+			__m256 b = _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_and_si256(p, mask)), d);
+			__m256 a = _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(p, 24)), d);
+
+			SIMD::Transpose4x4(r, g, b, a);
+			float* o = out[i].f;
+			_mm256_storeu_ps(o + 0, _mm256_permute2f128_ps(r, g, 0x20));
+			_mm256_storeu_ps(o + 8, _mm256_permute2f128_ps(b, a, 0x20));
+			_mm256_storeu_ps(o + 16, _mm256_permute2f128_ps(r, g, 0x31));
+			_mm256_storeu_ps(o + 24, _mm256_permute2f128_ps(b, a, 0x31));
+		}
+		return _UnpackSSE41(in, out, i, end);
+	}
+
+	ENGINE_TARGET_AVX2 static ENGINE_INLINE __m256i _EncodeUnormAVX2(__m256 x)
+	{
+		return _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(_SaturateAVX2(x), _mm256_set1_ps(255.0f)), _mm256_set1_ps(0.5f)));
+	}
+
+	ENGINE_TARGET_AVX2 static size_t _PackAVX2(const Color* in, uint32_t* out, size_t begin, size_t end)
+	{
+		size_t i = begin;
+		for (; i + 8 <= end; i += 8)
+		{
+			const float* p = in[i].f;
+			__m256 c01 = _mm256_loadu_ps(p + 0), c23 = _mm256_loadu_ps(p + 8), c45 = _mm256_loadu_ps(p + 16), c67 = _mm256_loadu_ps(p + 24);
+			__m256 r = _mm256_permute2f128_ps(c01, c45, 0x20);
+			__m256 g = _mm256_permute2f128_ps(c01, c45, 0x31);
+			__m256 b = _mm256_permute2f128_ps(c23, c67, 0x20);
+			__m256 a = _mm256_permute2f128_ps(c23, c67, 0x31);
+			SIMD::Transpose4x4(r, g, b, a);
+
+			__m256i px = _mm256_or_si256(_mm256_slli_epi32(_EncodeUnormAVX2(r), 16), _mm256_slli_epi32(_EncodeUnormAVX2(g), 8));
+			px = _mm256_or_si256(px, _mm256_or_si256(_EncodeUnormAVX2(b), _mm256_slli_epi32(_EncodeUnormAVX2(a), 24)));
+			_mm256_storeu_si256((__m256i*)(out + i), px);
+		}
+		return _PackSSE41(in, out, i, end);
+	}
+#endif
+
+	namespace Utils
+	{
+		void ARGB32ToLinear(const uint32_t* in, Color* out, size_t count)
+		{
+			_ToLinear((const uint8_t*)in, out, count, 16, 0);
+		}
+
+		void RGBA8ToLinear(const uint8_t* in, Color* out, size_t count)
+		{
+			_ToLinear(in, out, count, 0, 16);
+		}
+
+		void LinearToARGB32(const Color* in, uint32_t* out, size_t count)
+		{
+			_FromLinear(in, (uint8_t*)out, count, 16, 0);
+		}
+
+		void LinearToRGBA8(const Color* in, uint8_t* out, size_t count)
+		{
+			_FromLinear(in, out, count, 0, 16);
+		}
+
+		float SRGB8ToLinear(uint8_t c)
+		{
+			return _Tables().toLinear[c];
+		}
+
+		uint8_t LinearToSRGB8(float c)
+		{
+			return (uint8_t)_Encode(_Tables(), c);
+		}
+
+		void UnpackARGB32(const uint32_t* in, Color* out, size_t count)
+		{
+			Parallel::For(count, MIN_PIXELS_PER_THREAD, [&](size_t begin, size_t end)
+			{
+				size_t i = begin;
+				SIMD_DISPATCH(i, _Unpack, in, out, begin, end);
+				_UnpackScalar(in, out, i, end);
+			});
+		}
+
+		void PackARGB32(const Color* in, uint32_t* out, size_t count)
+		{
+			Parallel::For(count, MIN_PIXELS_PER_THREAD, [&](size_t begin, size_t end)
+			{
+				size_t i = begin;
+				SIMD_DISPATCH(i, _Pack, in, out, begin, end);
+				_PackScalar(in, out, i, end);
+			});
+		}
+
+		void Premultiply(const Color* in, Color* out, size_t count)
+		{
+			_Map(_Premultiply(), in, out, count);
+		}
+
+		void Unpremultiply(const Color* in, Color* out, size_t count)
+		{
+			_Map(_Unpremultiply(), in, out, count);
+		}
+
+		void Lerp(const Color* from, const Color* to, float frac, Color* out, size_t count)
+		{
+			Parallel::For(count, MIN_PIXELS_PER_THREAD, [&](size_t begin, size_t end)
+			{
+				size_t i = begin;
+				SIMD_DISPATCH(i, _Lerp, from, to, frac, out, begin, end);
+				_LerpScalar(from, to, frac, out, i, end);
+			});
+		}
+
+		void ApplyExposure(const Color* in, float ev, Color* out, size_t count)
+		{
+			_Exposure op = { exp2f(ev) };
+			_Map(op, in, out, count);
+		}
+
+		void ToneMapReinhard(const Color* in, Color* out, size_t count)
+		{
+			_Map(_Reinhard(), in, out, count);
+		}
+
+		void ToneMapACES(const Color* in, Color* out, size_t count)
+		{
+			_Map(_ACES(), in, out, count);
+		}
+	}
+}
@@ -0,0 +1,80 @@
+/* Copyright (C) 2009-2020, Nick Galko Ltd. All rights reserved.
+*
+* This file is part of the NGTech (https://galek.github.io/portfolio/).
+*
+* Your use and or redistribution of this software in source and / or
+* binary form, with or without modification, is subject to: (i) your
+* ongoing acceptance of and compliance with the terms and conditions of
+* the NGTech License Agreement; and (ii) your inclusion of this notice
+* in any version of this software that you use or redistribute.
+* A copy of the NGTech License Agreement is available by contacting
+* Nick Galko Ltd. at https://galek.github.io/portfolio/
+*/
+#pragma once
+
+//***************************************************************************
+#include <stdint.h>
+//***************************************************************************
+#include "MathLib.h"
+//***************************************************************************
+
+namespace NGTech
+{
+	static_assert(sizeof(Color) == 4 * sizeof(float), "Invalid Color padding!");
+
+	namespace Utils
+	{
+		/**
+		sRGB <-> linear conversion of 8-bit channels. Colors are r, g, b, a in x, y, z, w
+		like Color(r, g, b, a), alpha is not gamma encoded.
+		ARGB32 pixels are 0xAARRGGBB values, RGBA8 pixels are the bytes r, g, b, a.
+		Decoding uses a 256-entry table, encoding clamps to [0, 1] and rounds exactly
+		(same as rounding the sRGB curve evaluated in double precision).
+		AVX2 processes 8 pixels per iteration with gathers.
+		*/
+		void ARGB32ToLinear(const uint32_t* in, Color* out, size_t count);
+		void RGBA8ToLinear(const uint8_t* in, Color* out, size_t count);
+		void LinearToARGB32(const Color* in, uint32_t* out, size_t count);
+		void LinearToRGBA8(const Color* in, uint8_t* out, size_t count);
+
+		/**
+		Single channel versions
+		*/
+		float SRGB8ToLinear(uint8_t c);
+		uint8_t LinearToSRGB8(float c);
+
+		/**
+		Colour kernels over whole rows or images, in and out may be the same array.
+		Large arrays are split over the Parallel threads.
+		Unpack/Pack convert 0xAARRGGBB without gamma, channels in the same order as above,
+		packing clamps to [0, 1] and rounds to nearest.
+		Note that Color(unsigned int argb32) stores a, r, g, b in x, y, z, w instead, so code moving
+		from the constructor to UnpackARGB32 gets r, g, b, a.
+		*/
+		void UnpackARGB32(const uint32_t* in, Color* out, size_t count);
+		void PackARGB32(const Color* in, uint32_t* out, size_t count);
+
+		/**
+		rgb *= a, and back (rgb of fully transparent colours becomes 0)
+		*/
+		void Premultiply(const Color* in, Color* out, size_t count);
+		void Unpremultiply(const Color* in, Color* out, size_t count);
+
+		/**
+		Same as Color::Lerp for every element
+		*/
+		void Lerp(const Color* from, const Color* to, float frac, Color* out, size_t count);
+
+		/**
+		rgb *= 2^ev, alpha is kept
+		*/
+		void ApplyExposure(const Color* in, float ev, Color* out, size_t count);
+
+		/**
+		Tone mapping of linear HDR rgb, alpha is kept.
+		Reinhard: c / (1 + c). ACES: K. Narkowicz's fit of the ACES filmic curve, clamped to [0, 1]
+		*/
+		void ToneMapReinhard(const Color* in, Color* out, size_t count);
+		void ToneMapACES(const Color* in, Color* out, size_t count);
+	}
+}
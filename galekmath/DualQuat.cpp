@@ -0,0 +1,92 @@
+/* Copyright (C) 2009-2020, Nick Galko Ltd. All rights reserved.
+*
+* This file is part of the NGTech (https://galek.github.io/portfolio/).
+*
+* Your use and or redistribution of this software in source and / or
+* binary form, with or without modification, is subject to: (i) your
+* ongoing acceptance of and compliance with the terms and conditions of
+* the NGTech License Agreement; and (ii) your inclusion of this notice
+* in any version of this software that you use or redistribute.
+* A copy of the NGTech License Agreement is available by contacting
+* Nick Galko Ltd. at https://galek.github.io/portfolio/
+*/
+//***************************************************************************
+#include "DualQuat.h"
+//***************************************************************************
+
+namespace NGTech
+{
+	/**/
+	const DualQuat DualQuat::IDENTITY(Quat(0, 0, 0, 1), Quat(0, 0, 0, 0));
+
+	/*
+	Hamilton product, same convention as Quat::toMatrix
+	*/
+	static ENGINE_INLINE Quat _Mul(const Quat& a, const Quat& b)
+	{
+		return Quat(a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+			a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+			a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+			a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z);
+	}
+
+	/*
+	*/
+	DualQuat::DualQuat(const Quat& rotation, const Vec3& translation)
+		: real(rotation)
+	{
+		Quat t = _Mul(Quat(translation.x, translation.y, translation.z, 0), rotation);
+		dual = Quat(0.5f * t.x, 0.5f * t.y, 0.5f * t.z, 0.5f * t.w);
+	}
+
+	DualQuat::DualQuat(const Mat4& m)
+		: DualQuat(Quat(Mat3(m)), Vec3(m.e[12], m.e[13], m.e[14]))
+	{}
+
+	DualQuat DualQuat::operator*(const DualQuat& dq) const
+	{
+		Quat rd = _Mul(real, dq.dual);
+		Quat dr = _Mul(dual, dq.real);
+		return DualQuat(_Mul(real, dq.real), Quat(rd.x + dr.x, rd.y + dr.y, rd.z + dr.z, rd.w + dr.w));
+	}
+
+	void DualQuat::Normalize()
+	{
+		float len = sqrt(real.x * real.x + real.y * real.y + real.z * real.z + real.w * real.w);
+		if (len == 0)
+			return;
+
+		float inv = Math::ONEFLOAT / len;
+		real = Quat(real.x * inv, real.y * inv, real.z * inv, real.w * inv);
+		dual = Quat(dual.x * inv, dual.y * inv, dual.z * inv, dual.w * inv);
+	}
+
+	/*
+	2 * dual * conjugate(real)
+	*/
+	Vec3 DualQuat::GetTranslation() const
+	{
+		Vec3 r(real.x, real.y, real.z), d(dual.x, dual.y, dual.z);
+		return (d * real.w - r * dual.w + Vec3::cross(r, d)) * 2.0f;
+	}
+
+	Vec3 DualQuat::TransformVector(const Vec3& v) const
+	{
+		Vec3 r(real.x, real.y, real.z);
+		Vec3 t = Vec3::cross(r, v) * 2.0f;
+		return v + t * real.w + Vec3::cross(r, t);
+	}
+
+	Vec3 DualQuat::TransformPoint(const Vec3& p) const
+	{
+		return TransformVector(p) + GetTranslation();
+	}
+
+	Mat4 DualQuat::ToMat4() const
+	{
+		Mat4 m;
+		Vec3 t = GetTranslation();
+		Utils::QuatTRSToMat4(&t, &real, nullptr, &m, 1);
+		return m;
+	}
+}
@@ -0,0 +1,59 @@
+/* Copyright (C) 2009-2020, Nick Galko Ltd. All rights reserved.
+*
+* This file is part of the NGTech (https://galek.github.io/portfolio/).
+*
+* Your use and or redistribution of this software in source and / or
+* binary form, with or without modification, is subject to: (i) your
+* ongoing acceptance of and compliance with the terms and conditions of
+* the NGTech License Agreement; and (ii) your inclusion of this notice
+* in any version of this software that you use or redistribute.
+* A copy of the NGTech License Agreement is available by contacting
+* Nick Galko Ltd. at https://galek.github.io/portfolio/
+*/
+#pragma once
+
+//***************************************************************************
+#include "MathLib.h"
+//***************************************************************************
+
+namespace NGTech
+{
+	/**
+	Rigid transform (rotation + translation) as a unit dual quaternion: real is the rotation,
+	dual = 0.5 * translation * real. Same meaning as Mat4: A * B applies B first.
+	*/
+	class DualQuat
+	{
+	public:
+		Quat real;
+		Quat dual;
+
+		constexpr DualQuat() : real(0, 0, 0, 1), dual(0, 0, 0, 0) {}
+		constexpr DualQuat(const Quat& _real, const Quat& _dual) : real(_real), dual(_dual) {}
+		/**
+		rotation must be normalized
+		*/
+		DualQuat(const Quat& rotation, const Vec3& translation);
+		/**
+		m must be rotation + translation only, scale is not supported
+		*/
+		explicit DualQuat(const Mat4& m);
+
+		DualQuat operator*(const DualQuat& dq) const;
+
+		void Normalize();
+
+		Vec3 GetTranslation() const;
+		ENGINE_INLINE const Quat& GetRotation() const { return real; }
+
+		Vec3 TransformPoint(const Vec3& p) const;
+		Vec3 TransformVector(const Vec3& v) const;
+
+		Mat4 ToMat4() const;
+
+		static const DualQuat IDENTITY;
+	};
+
+	static_assert(sizeof(DualQuat) == 8 * sizeof(float), "Invalid DualQuat padding!");
+	static_assert(std::is_trivially_copyable<DualQuat>::value, "DualQuat must be trivially copyable!");
+}
@@ -0,0 +1,264 @@
+/* Copyright (C) 2009-2020, Nick Galko Ltd. All rights reserved.
+*
+* This file is part of the NGTech (https://galek.github.io/portfolio/).
+*
+* Your use and or redistribution of this software in source and / or
+* binary form, with or without modification, is subject to: (i) your
+* ongoing acceptance of and compliance with the terms and conditions of
+* the NGTech License Agreement; and (ii) your inclusion of this notice
+* in any version of this software that you use or redistribute.
+* A copy of the NGTech License Agreement is available by contacting
+* Nick Galko Ltd. at https://galek.github.io/portfolio/
+*/
+//***************************************************************************
+#include <string.h>
+#include <stdint.h>
+//***************************************************************************
+#include "FastMath.h"
+//***************************************************************************
+
+namespace NGTech
+{
+	using namespace FastMathConst;
+
+	static ENGINE_INLINE float _AsFloat(int32_t i) {
+		float f;
+		memcpy(&f, &i, sizeof(f));
+		return f;
+	}
+
+	static ENGINE_INLINE int32_t _AsInt(float f) {
+		int32_t i;
+		memcpy(&i, &f, sizeof(i));
+		return i;
+	}
+
+	/*
+	Scalar versions do the same operations as FastSIMD, so the array tails match the kernels
+	*/
+	void Math::Fast::sincos(float x, float& s, float& c)
+	{
+		float j = nearbyintf(x * TWO_OVER_PI);
+		int32_t q = (int32_t)j;
+
+		float r = ((x - j * PIO2_1) - j * PIO2_2) - j * PIO2_3;
+		float z = r * r;
+
+		float ps = r + r * z * (SIN_1 + z * (SIN_2 + z * SIN_3));
+		float pc = (1.0f - 0.5f * z) + z * z * (COS_1 + z * (COS_2 + z * COS_3));
+
+		s = (q & 1) ? pc : ps;
+		c = (q & 1) ? ps : pc;
+		if (q & 2) s = -s;
+		if ((q + 1) & 2) c = -c;
+	}
+
+	float Math::Fast::sin(float x)
+	{
+		float s, c;
+		sincos(x, s, c);
+		return s;
+	}
+
+	float Math::Fast::cos(float x)
+	{
+		float s, c;
+		sincos(x, s, c);
+		return c;
+	}
+
+	float Math::Fast::acos(float x)
+	{
+		float a = Math::Min(fabsf(x), 1.0f);
+
+		bool big = a > 0.5f;
+		float z = big ? 0.5f * (1.0f - a) : a * a;
+		float t = big ? sqrtf(z) : a;
+
+		float p = t + t * z * (ASIN_1 + z * (ASIN_2 + z * (ASIN_3 + z * (ASIN_4 + z * ASIN_5))));
+		float r = big ? p + p : PIO2 - p;
+		return signbit(x) ? PI - r : r;
+	}
+
+	float Math::Fast::atan2(float y, float x)
+	{
+		float ax = fabsf(x), ay = fabsf(y);
+		float mx = Math::Max(ax, ay);
+		float a = (mx > 0) ? Math::Min(ax, ay) / mx : 0.0f;
+
+		bool big = a > TAN_PIO8;
+		float t = big ? (a - 1.0f) / (a + 1.0f) : a;
+		float z = t * t;
+
+		float r = t + t * z * (ATAN_1 + z * (ATAN_2 + z * (ATAN_3 + z * ATAN_4)));
+		if (big) r += PIO4;
+		if (ay > ax) r = PIO2 - r;
+		if (signbit(x)) r = PI - r;
+		return signbit(y) ? -r : r;
+	}
+
+	float Math::Fast::rsqrt(float x)
+	{
+#if MATH_SIMD_X86 && (defined(__SSE__) || defined(_M_X64))
+		// SSE1 scalar forms of the FastSIMD::rsqrt operations
+		__m128 v = _mm_set_ss(x);
+		__m128 r = _mm_rsqrt_ss(v);
+		if (fabsf(x) < FLT_MIN || x == INFINITY)
+			return _mm_cvtss_f32(r);
+
+		__m128 hxr = _mm_mul_ss(_mm_mul_ss(_mm_set_ss(0.5f), v), r);
+		return _mm_cvtss_f32(_mm_mul_ss(r, _mm_sub_ss(_mm_set_ss(1.5f), _mm_mul_ss(hxr, r))));
+#else
+		return 1.0f / sqrtf(x);
+#endif
+	}
+
+	float Math::Fast::exp2(float x)
+	{
+		x = Math::Clamp(x, EXP2_MIN, EXP2_MAX);
+		float j = nearbyintf(x);
+		float f = x - j;
+
+		float p = 1.0f + f * (EXP2_1 + f * (EXP2_2 + f * (EXP2_3 + f * (EXP2_4 + f * (EXP2_5 + f * EXP2_6)))));
+
+		int32_t e = (int32_t)j;
+		int32_t e1 = e >> 1;
+		int32_t e2 = e - e1;
+		return p * _AsFloat((e1 + 127) << 23) * _AsFloat((e2 + 127) << 23);
+	}
+
+	float Math::Fast::log2(float x)
+	{
+		int32_t bits = _AsInt(x);
+		float e = (float)((bits >> 23) - 126);
+		float m = _AsFloat((bits & 0x007fffff) | 0x3f000000);
+
+		float t;
+		if (m < SQRTHF) {
+			e -= 1.0f;
+			t = m + m - 1.0f;
+		}
+		else
+			t = m - 1.0f;
+
+		float z = t * t;
+		float p = LOG_1 + t * (LOG_2 + t * (LOG_3 + t * (LOG_4 + t * (LOG_5 + t * (LOG_6 + t * (LOG_7 + t * (LOG_8 + t * LOG_9)))))));
+		float y = t * z * p - 0.5f * z;
+
+		float r = y * LOG2EA;
+		r += t * LOG2EA;
+		r += y;
+		r += t;
+		return r + e;
+	}
+
+	/*
+	Array kernels return how many elements they processed, the rest is done by the scalar loop
+	*/
+#if MATH_SIMD_X86
+#define FAST_ARRAY_OP(_name, _func) \
+	ENGINE_TARGET_SSE41 static size_t _name##SSE41(const float* in, float* out, size_t n) { \
+		size_t i = 0; \
+		for (; i + 4 <= n; i += 4) \
+			_mm_storeu_ps(out + i, FastSIMD::_func(_mm_loadu_ps(in + i))); \
+		return i; \
+	} \
+	ENGINE_TARGET_AVX2 static size_t _name##AVX2(const float* in, float* out, size_t n) { \
+		size_t i = 0; \
+		for (; i + 8 <= n; i += 8) \
+			_mm256_storeu_ps(out + i, FastSIMD::_func(_mm256_loadu_ps(in + i))); \
+		return i; \
+	}
+
+	FAST_ARRAY_OP(_Acos, acos)
+	FAST_ARRAY_OP(_Rsqrt, rsqrt)
+	FAST_ARRAY_OP(_Exp2, exp2)
+	FAST_ARRAY_OP(_Log2, log2)
+#undef FAST_ARRAY_OP
+
+	ENGINE_TARGET_SSE41 static size_t _SinCosSSE41(const float* in, float* s, float* c, size_t n) {
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4) {
+			__m128 vs, vc;
+			FastSIMD::sincos(_mm_loadu_ps(in + i), vs, vc);
+			_mm_storeu_ps(s + i, vs);
+			_mm_storeu_ps(c + i, vc);
+		}
+		return i;
+	}
+
+	ENGINE_TARGET_AVX2 static size_t _SinCosAVX2(const float* in, float* s, float* c, size_t n) {
+		size_t i = 0;
+		for (; i + 8 <= n; i += 8) {
+			__m256 vs, vc;
+			FastSIMD::sincos(_mm256_loadu_ps(in + i), vs, vc);
+			_mm256_storeu_ps(s + i, vs);
+			_mm256_storeu_ps(c + i, vc);
+		}
+		return i;
+	}
+
+	ENGINE_TARGET_SSE41 static size_t _Atan2SSE41(const float* y, const float* x, float* out, size_t n) {
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4)
+			_mm_storeu_ps(out + i, FastSIMD::atan2(_mm_loadu_ps(y + i), _mm_loadu_ps(x + i)));
+		return i;
+	}
+
+	ENGINE_TARGET_AVX2 static size_t _Atan2AVX2(const float* y, const float* x, float* out, size_t n) {
+		size_t i = 0;
+		for (; i + 8 <= n; i += 8)
+			_mm256_storeu_ps(out + i, FastSIMD::atan2(_mm256_loadu_ps(y + i), _mm256_loadu_ps(x + i)));
+		return i;
+	}
+
+#endif
+
+	void Math::Fast::sincos(const float* in, float* s, float* c, size_t count)
+	{
+		size_t i = 0;
+		SIMD_DISPATCH(i, _SinCos, in, s, c, count);
+		for (; i < count; i++)
+			sincos(in[i], s[i], c[i]);
+	}
+
+	void Math::Fast::acos(const float* in, float* out, size_t count)
+	{
+		size_t i = 0;
+		SIMD_DISPATCH(i, _Acos, in, out, count);
+		for (; i < count; i++)
+			out[i] = acos(in[i]);
+	}
+
+	void Math::Fast::atan2(const float* y, const float* x, float* out, size_t count)
+	{
+		size_t i = 0;
+		SIMD_DISPATCH(i, _Atan2, y, x, out, count);
+		for (; i < count; i++)
+			out[i] = atan2(y[i], x[i]);
+	}
+
+	void Math::Fast::rsqrt(const float* in, float* out, size_t count)
+	{
+		size_t i = 0;
+		SIMD_DISPATCH(i, _Rsqrt, in, out, count);
+		for (; i < count; i++)
+			out[i] = rsqrt(in[i]);
+	}
+
+	void Math::Fast::exp2(const float* in, float* out, size_t count)
+	{
+		size_t i = 0;
+		SIMD_DISPATCH(i, _Exp2, in, out, count);
+		for (; i < count; i++)
+			out[i] = exp2(in[i]);
+	}
+
+	void Math::Fast::log2(const float* in, float* out, size_t count)
+	{
+		size_t i = 0;
+		SIMD_DISPATCH(i, _Log2, in, out, count);
+		for (; i < count; i++)
+			out[i] = log2(in[i]);
+	}
+}
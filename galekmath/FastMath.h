@@ -0,0 +1,382 @@
+/* Copyright (C) 2009-2020, Nick Galko Ltd. All rights reserved.
+*
+* This file is part of the NGTech (https://galek.github.io/portfolio/).
+*
+* Your use and or redistribution of this software in source and / or
+* binary form, with or without modification, is subject to: (i) your
+* ongoing acceptance of and compliance with the terms and conditions of
+* the NGTech License Agreement; and (ii) your inclusion of this notice
+* in any version of this software that you use or redistribute.
+* A copy of the NGTech License Agreement is available by contacting
+* Nick Galko Ltd. at https://galek.github.io/portfolio/
+*/
+#pragma once
+
+//***************************************************************************
+#include "MathLib.h"
+#include "SIMD.h"
+//***************************************************************************
+
+namespace NGTech
+{
+	/*
+	Coefficients shared by Math::Fast and FastSIMD (Cephes single precision)
+	*/
+	namespace FastMathConst
+	{
+		// pi/2 split in 3 parts for the Cody-Waite reduction
+		static const float PIO2_1 = 1.5703125f;
+		static const float PIO2_2 = 4.837512969970703125e-4f;
+		static const float PIO2_3 = 7.54978995489188216e-8f;
+		static const float TWO_OVER_PI = 0.636619772367581343f;
+		static const float PIO2 = 1.57079632679489662f;
+		static const float PIO4 = 0.785398163397448310f;
+		static const float PI = 3.14159265358979324f;
+
+		// sin and cos on [-pi/4, pi/4]
+		static const float SIN_1 = -1.6666654611e-1f;
+		static const float SIN_2 = 8.3321608736e-3f;
+		static const float SIN_3 = -1.9515295891e-4f;
+		static const float COS_1 = 4.166664568298827e-2f;
+		static const float COS_2 = -1.388731625493765e-3f;
+		static const float COS_3 = 2.443315711809948e-5f;
+
+		// asin on [0, 0.5]
+		static const float ASIN_1 = 1.6666752422e-1f;
+		static const float ASIN_2 = 7.4953002686e-2f;
+		static const float ASIN_3 = 4.5470025998e-2f;
+		static const float ASIN_4 = 2.4181311049e-2f;
+		static const float ASIN_5 = 4.2163199048e-2f;
+
+		// atan on [0, tan(pi/8)]
+		static const float TAN_PIO8 = 0.414213562373095049f;
+		static const float ATAN_1 = -3.33329491539e-1f;
+		static const float ATAN_2 = 1.99777106478e-1f;
+		static const float ATAN_3 = -1.38776856032e-1f;
+		static const float ATAN_4 = 8.05374449538e-2f;
+
+		// 2^x on [-0.5, 0.5]
+		static const float EXP2_1 = 6.931472028550421e-1f;
+		static const float EXP2_2 = 2.402264791363012e-1f;
+		static const float EXP2_3 = 5.550332471162809e-2f;
+		static const float EXP2_4 = 9.618437357674640e-3f;
+		static const float EXP2_5 = 1.339887440266574e-3f;
+		static const float EXP2_6 = 1.535336188319500e-4f;
+		static const float EXP2_MIN = -150.0f;
+		static const float EXP2_MAX = 128.0f;
+
+		// log(1 + x) on [sqrt(0.5) - 1, sqrt(2) - 1]
+		static const float SQRTHF = 0.707106781186547524f;
+		static const float LOG2EA = 0.44269504088896340736f;	// log2(e) - 1
+		static const float LOG_1 = 3.3333331174e-1f;
+		static const float LOG_2 = -2.4999993993e-1f;
+		static const float LOG_3 = 2.0000714765e-1f;
+		static const float LOG_4 = -1.6668057665e-1f;
+		static const float LOG_5 = 1.4249322787e-1f;
+		static const float LOG_6 = -1.2420140846e-1f;
+		static const float LOG_7 = 1.1676998740e-1f;
+		static const float LOG_8 = -1.1514610310e-1f;
+		static const float LOG_9 = 7.0376836292e-2f;
+	}
+
+#if MATH_SIMD_X86
+	/**
+	Register versions of Math::Fast for the SIMD kernels, 4 (SSE4.1) or 8 (AVX2) values at once.
+	Same algorithms and error bounds as the scalar functions.
+	*/
+	struct FastSIMD
+	{
+		ENGINE_TARGET_SSE41 static ENGINE_INLINE void sincos(__m128 x, __m128& s, __m128& c)
+		{
+			using namespace FastMathConst;
+			__m128 j = _mm_round_ps(_mm_mul_ps(x, _mm_set1_ps(TWO_OVER_PI)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+			__m128i q = _mm_cvtps_epi32(j);
+
+			__m128 r = _mm_sub_ps(x, _mm_mul_ps(j, _mm_set1_ps(PIO2_1)));
+			r = _mm_sub_ps(r, _mm_mul_ps(j, _mm_set1_ps(PIO2_2)));
+			r = _mm_sub_ps(r, _mm_mul_ps(j, _mm_set1_ps(PIO2_3)));
+			__m128 z = _mm_mul_ps(r, r);
+
+			__m128 ps = _mm_add_ps(_mm_set1_ps(SIN_2), _mm_mul_ps(z, _mm_set1_ps(SIN_3)));
+			ps = _mm_add_ps(_mm_set1_ps(SIN_1), _mm_mul_ps(z, ps));
+			ps = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(r, z), ps));
+
+			__m128 pc = _mm_add_ps(_mm_set1_ps(COS_2), _mm_mul_ps(z, _mm_set1_ps(COS_3)));
+			pc = _mm_add_ps(_mm_set1_ps(COS_1), _mm_mul_ps(z, pc));
+			pc = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_set1_ps(0.5f), z)), _mm_mul_ps(_mm_mul_ps(z, z), pc));
+
+			// odd quadrants swap sin and cos, the sign comes from bit 1 of q (q + 1 for cos)
+			__m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+			__m128 signS = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(q, _mm_set1_epi32(2)), 30));
+			__m128 signC = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(q, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30));
+
+			s = _mm_xor_ps(_mm_blendv_ps(ps, pc, swap), signS);
+			c = _mm_xor_ps(_mm_blendv_ps(pc, ps, swap), signC);
+		}
+
+		ENGINE_TARGET_AVX2 static ENGINE_INLINE void sincos(__m256 x, __m256& s, __m256& c)
+		{
+			using namespace FastMathConst;
+			__m256 j = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(TWO_OVER_PI)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+			__m256i q = _mm256_cvtps_epi32(j);
+
+			__m256 r = _mm256_fnmadd_ps(j, _mm256_set1_ps(PIO2_1), x);
+			r = _mm256_fnmadd_ps(j, _mm256_set1_ps(PIO2_2), r);
+			r = _mm256_fnmadd_ps(j, _mm256_set1_ps(PIO2_3), r);
+			__m256 z = _mm256_mul_ps(r, r);
+
+			__m256 ps = _mm256_fmadd_ps(z, _mm256_set1_ps(SIN_3), _mm256_set1_ps(SIN_2));
+			ps = _mm256_fmadd_ps(z, ps, _mm256_set1_ps(SIN_1));
+			ps = _mm256_fmadd_ps(_mm256_mul_ps(r, z), ps, r);
+
+			__m256 pc = _mm256_fmadd_ps(z, _mm256_set1_ps(COS_3), _mm256_set1_ps(COS_2));
+			pc = _mm256_fmadd_ps(z, pc, _mm256_set1_ps(COS_1));
+			pc = _mm256_fmadd_ps(_mm256_mul_ps(z, z), pc, _mm256_fnmadd_ps(_mm256_set1_ps(0.5f), z, _mm256_set1_ps(1.0f)));
+
+			__m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(q, _mm256_set1_epi32(1)), _mm256_set1_epi32(1)));
+			__m256 signS = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(q, _mm256_set1_epi32(2)), 30));
+			__m256 signC = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(q, _mm256_set1_epi32(1)), _mm256_set1_epi32(2)), 30));
+
+			s = _mm256_xor_ps(_mm256_blendv_ps(ps, pc, swap), signS);
+			c = _mm256_xor_ps(_mm256_blendv_ps(pc, ps, swap), signC);
+		}
+
+		/**
+		|x| > 1 is clamped
+		*/
+		ENGINE_TARGET_SSE41 static ENGINE_INLINE __m128 acos(__m128 x)
+		{
+			using namespace FastMathConst;
+			const __m128 signMask = _mm_set1_ps(-0.0f);
+			__m128 sign = _mm_and_ps(x, signMask);
+			__m128 a = _mm_min_ps(_mm_andnot_ps(signMask, x), _mm_set1_ps(1.0f));
+
+			// acos(a) = 2 * asin(sqrt((1 - a) / 2)) for a > 0.5, pi/2 - asin(a) otherwise
+			__m128 big = _mm_cmpgt_ps(a, _mm_set1_ps(0.5f));
+			__m128 zb = _mm_mul_ps(_mm_set1_ps(0.5f), _mm_sub_ps(_mm_set1_ps(1.0f), a));
+			__m128 z = _mm_blendv_ps(_mm_mul_ps(a, a), zb, big);
+			__m128 t = _mm_blendv_ps(a, _mm_sqrt_ps(zb), big);
+
+			__m128 p = _mm_add_ps(_mm_set1_ps(ASIN_4), _mm_mul_ps(z, _mm_set1_ps(ASIN_5)));
+			p = _mm_add_ps(_mm_set1_ps(ASIN_3), _mm_mul_ps(z, p));
+			p = _mm_add_ps(_mm_set1_ps(ASIN_2), _mm_mul_ps(z, p));
+			p = _mm_add_ps(_mm_set1_ps(ASIN_1), _mm_mul_ps(z, p));
+			p = _mm_add_ps(t, _mm_mul_ps(_mm_mul_ps(t, z), p));
+
+			__m128 r = _mm_blendv_ps(_mm_sub_ps(_mm_set1_ps(PIO2), p), _mm_add_ps(p, p), big);
+			return _mm_blendv_ps(r, _mm_sub_ps(_mm_set1_ps(PI), r), sign);
+		}
+
+		ENGINE_TARGET_AVX2 static ENGINE_INLINE __m256 acos(__m256 x)
+		{
+			using namespace FastMathConst;
+			const __m256 signMask = _mm256_set1_ps(-0.0f);
+			__m256 sign = _mm256_and_ps(x, signMask);
+			__m256 a = _mm256_min_ps(_mm256_andnot_ps(signMask, x), _mm256_set1_ps(1.0f));
+
+			__m256 big = _mm256_cmp_ps(a, _mm256_set1_ps(0.5f), _CMP_GT_OQ);
+			__m256 zb = _mm256_mul_ps(_mm256_set1_ps(0.5f), _mm256_sub_ps(_mm256_set1_ps(1.0f), a));
+			__m256 z = _mm256_blendv_ps(_mm256_mul_ps(a, a), zb, big);
+			__m256 t = _mm256_blendv_ps(a, _mm256_sqrt_ps(zb), big);
+
+			__m256 p = _mm256_fmadd_ps(z, _mm256_set1_ps(ASIN_5), _mm256_set1_ps(ASIN_4));
+			p = _mm256_fmadd_ps(z, p, _mm256_set1_ps(ASIN_3));
+			p = _mm256_fmadd_ps(z, p, _mm256_set1_ps(ASIN_2));
+			p = _mm256_fmadd_ps(z, p, _mm256_set1_ps(ASIN_1));
+			p = _mm256_fmadd_ps(_mm256_mul_ps(t, z), p, t);
+
+			__m256 r = _mm256_blendv_ps(_mm256_sub_ps(_mm256_set1_ps(PIO2), p), _mm256_add_ps(p, p), big);
+			return _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(PI), r), sign);
+		}
+
+		/**
+		atan2(0, 0) = 0
+		*/
+		ENGINE_TARGET_SSE41 static ENGINE_INLINE __m128 atan2(__m128 y, __m128 x)
+		{
+			using namespace FastMathConst;
+			const __m128 signMask = _mm_set1_ps(-0.0f);
+			const __m128 one = _mm_set1_ps(1.0f);
+			__m128 ax = _mm_andnot_ps(signMask, x);
+			__m128 ay = _mm_andnot_ps(signMask, y);
+
+			// atan of min / max in [0, 1], then mirrored to the octant
+			__m128 mx = _mm_max_ps(ax, ay);
+			__m128 a = _mm_and_ps(_mm_div_ps(_mm_min_ps(ax, ay), mx), _mm_cmpgt_ps(mx, _mm_setzero_ps()));
+
+			__m128 big = _mm_cmpgt_ps(a, _mm_set1_ps(TAN_PIO8));
+			__m128 t = _mm_blendv_ps(a, _mm_div_ps(_mm_sub_ps(a, one), _mm_add_ps(a, one)), big);
+			__m128 z = _mm_mul_ps(t, t);
+
+			__m128 p = _mm_add_ps(_mm_set1_ps(ATAN_3), _mm_mul_ps(z, _mm_set1_ps(ATAN_4)));
+			p = _mm_add_ps(_mm_set1_ps(ATAN_2), _mm_mul_ps(z, p));
+			p = _mm_add_ps(_mm_set1_ps(ATAN_1), _mm_mul_ps(z, p));
+			p = _mm_add_ps(t, _mm_mul_ps(_mm_mul_ps(t, z), p));
+
+			__m128 r = _mm_add_ps(p, _mm_and_ps(big, _mm_set1_ps(PIO4)));
+			r = _mm_blendv_ps(r, _mm_sub_ps(_mm_set1_ps(PIO2), r), _mm_cmpgt_ps(ay, ax));
+			r = _mm_blendv_ps(r, _mm_sub_ps(_mm_set1_ps(PI), r), x);
+			return _mm_xor_ps(r, _mm_and_ps(y, signMask));
+		}
+
+		ENGINE_TARGET_AVX2 static ENGINE_INLINE __m256 atan2(__m256 y, __m256 x)
+		{
+			using namespace FastMathConst;
+			const __m256 signMask = _mm256_set1_ps(-0.0f);
+			const __m256 one = _mm256_set1_ps(1.0f);
+			__m256 ax = _mm256_andnot_ps(signMask, x);
+			__m256 ay = _mm256_andnot_ps(signMask, y);
+
+			__m256 mx = _mm256_max_ps(ax, ay);
+			__m256 a = _mm256_and_ps(_mm256_div_ps(_mm256_min_ps(ax, ay), mx), _mm256_cmp_ps(mx, _mm256_setzero_ps(), _CMP_GT_OQ));
+
+			__m256 big = _mm256_cmp_ps(a, _mm256_set1_ps(TAN_PIO8), _CMP_GT_OQ);
+			__m256 t = _mm256_blendv_ps(a, _mm256_div_ps(_mm256_sub_ps(a, one), _mm256_add_ps(a, one)), big);
+			__m256 z = _mm256_mul_ps(t, t);
+
+			__m256 p = _mm256_fmadd_ps(z, _mm256_set1_ps(ATAN_4), _mm256_set1_ps(ATAN_3));
+			p = _mm256_fmadd_ps(z, p, _mm256_set1_ps(ATAN_2));
+			p = _mm256_fmadd_ps(z, p, _mm256_set1_ps(ATAN_1));
+			p = _mm256_fmadd_ps(_mm256_mul_ps(t, z), p, t);
+
+			__m256 r = _mm256_add_ps(p, _mm256_and_ps(big, _mm256_set1_ps(PIO4)));
+			r = _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(PIO2), r), _mm256_cmp_ps(ay, ax, _CMP_GT_OQ));
+			r = _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(PI), r), x);
+			return _mm256_xor_ps(r, _mm256_and_ps(y, signMask));
+		}
+
+		/**
+		Hardware estimate refined by one Newton-Raphson step, same operations as Math::Fast::rsqrt
+		on every level (no fma). Zero and denormal x give the estimate inf, inf gives 0.
+		*/
+		ENGINE_TARGET_SSE41 static ENGINE_INLINE __m128 rsqrt(__m128 x)
+		{
+			__m128 r = _mm_rsqrt_ps(x);
+			__m128 hxr = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), x), r);
+			__m128 nr = _mm_mul_ps(r, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(hxr, r)));
+			__m128 special = _mm_or_ps(_mm_cmplt_ps(_mm_andnot_ps(_mm_set1_ps(-0.0f), x), _mm_set1_ps(FLT_MIN)), _mm_cmpeq_ps(x, _mm_set1_ps(INFINITY)));
+			return _mm_blendv_ps(nr, r, special);
+		}
+
+		ENGINE_TARGET_AVX2 static ENGINE_INLINE __m256 rsqrt(__m256 x)
+		{
+			__m256 r = _mm256_rsqrt_ps(x);
+			__m256 hxr = _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), x), r);
+			__m256 nr = _mm256_mul_ps(r, _mm256_sub_ps(_mm256_set1_ps(1.5f), _mm256_mul_ps(hxr, r)));
+			__m256 special = _mm256_or_ps(_mm256_cmp_ps(_mm256_andnot_ps(_mm256_set1_ps(-0.0f), x), _mm256_set1_ps(FLT_MIN), _CMP_LT_OQ),
+				_mm256_cmp_ps(x, _mm256_set1_ps(INFINITY), _CMP_EQ_OQ));
+			return _mm256_blendv_ps(nr, r, special);
+		}
+
+		ENGINE_TARGET_SSE41 static ENGINE_INLINE __m128 exp2(__m128 x)
+		{
+			using namespace FastMathConst;
+			x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(EXP2_MIN)), _mm_set1_ps(EXP2_MAX));
+			__m128 j = _mm_round_ps(x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+			__m128 f = _mm_sub_ps(x, j);
+
+			__m128 p = _mm_add_ps(_mm_set1_ps(EXP2_5), _mm_mul_ps(f, _mm_set1_ps(EXP2_6)));
+			p = _mm_add_ps(_mm_set1_ps(EXP2_4), _mm_mul_ps(f, p));
+			p = _mm_add_ps(_mm_set1_ps(EXP2_3), _mm_mul_ps(f, p));
+			p = _mm_add_ps(_mm_set1_ps(EXP2_2), _mm_mul_ps(f, p));
+			p = _mm_add_ps(_mm_set1_ps(EXP2_1), _mm_mul_ps(f, p));
+			p = _mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(f, p));
+
+			// 2^j as two factors, so j = -150 and j = 128 stay in the exponent range
+			__m128i e = _mm_cvtps_epi32(j);
+			__m128i e1 = _mm_srai_epi32(e, 1);
+			__m128i e2 = _mm_sub_epi32(e, e1);
+			p = _mm_mul_ps(p, _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(e1, _mm_set1_epi32(127)), 23)));
+			return _mm_mul_ps(p, _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(e2, _mm_set1_epi32(127)), 23)));
+		}
+
+		ENGINE_TARGET_AVX2 static ENGINE_INLINE __m256 exp2(__m256 x)
+		{
+			using namespace FastMathConst;
+			x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(EXP2_MIN)), _mm256_set1_ps(EXP2_MAX));
+			__m256 j = _mm256_round_ps(x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+			__m256 f = _mm256_sub_ps(x, j);
+
+			__m256 p = _mm256_fmadd_ps(f, _mm256_set1_ps(EXP2_6), _mm256_set1_ps(EXP2_5));
+			p = _mm256_fmadd_ps(f, p, _mm256_set1_ps(EXP2_4));
+			p = _mm256_fmadd_ps(f, p, _mm256_set1_ps(EXP2_3));
+			p = _mm256_fmadd_ps(f, p, _mm256_set1_ps(EXP2_2));
+			p = _mm256_fmadd_ps(f, p, _mm256_set1_ps(EXP2_1));
+			p = _mm256_fmadd_ps(f, p, _mm256_set1_ps(1.0f));
+
+			__m256i e = _mm256_cvtps_epi32(j);
+			__m256i e1 = _mm256_srai_epi32(e, 1);
+			__m256i e2 = _mm256_sub_epi32(e, e1);
+			p = _mm256_mul_ps(p, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(e1, _mm256_set1_epi32(127)), 23)));
+			return _mm256_mul_ps(p, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(e2, _mm256_set1_epi32(127)), 23)));
+		}
+
+		/**
+		x must be a positive normal number
+		*/
+		ENGINE_TARGET_SSE41 static ENGINE_INLINE __m128 log2(__m128 x)
+		{
+			using namespace FastMathConst;
+			const __m128 one = _mm_set1_ps(1.0f);
+			__m128i bits = _mm_castps_si128(x);
+
+			// x = m * 2^e, m in [0.5, 1)
+			__m128 e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(126)));
+			__m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f000000)));
+
+			// m < sqrt(0.5) -> 2m - 1 and e - 1, else m - 1
+			__m128 small = _mm_cmplt_ps(m, _mm_set1_ps(SQRTHF));
+			e = _mm_sub_ps(e, _mm_and_ps(small, one));
+			__m128 t = _mm_sub_ps(_mm_add_ps(m, _mm_and_ps(small, m)), one);
+			__m128 z = _mm_mul_ps(t, t);
+
+			__m128 p = _mm_add_ps(_mm_set1_ps(LOG_8), _mm_mul_ps(t, _mm_set1_ps(LOG_9)));
+			p = _mm_add_ps(_mm_set1_ps(LOG_7), _mm_mul_ps(t, p));
+			p = _mm_add_ps(_mm_set1_ps(LOG_6), _mm_mul_ps(t, p));
+			p = _mm_add_ps(_mm_set1_ps(LOG_5), _mm_mul_ps(t, p));
+			p = _mm_add_ps(_mm_set1_ps(LOG_4), _mm_mul_ps(t, p));
+			p = _mm_add_ps(_mm_set1_ps(LOG_3), _mm_mul_ps(t, p));
+			p = _mm_add_ps(_mm_set1_ps(LOG_2), _mm_mul_ps(t, p));
+			p = _mm_add_ps(_mm_set1_ps(LOG_1), _mm_mul_ps(t, p));
+			__m128 y = _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(t, z), p), _mm_mul_ps(_mm_set1_ps(0.5f), z));
+
+			__m128 r = _mm_mul_ps(y, _mm_set1_ps(LOG2EA));
+			r = _mm_add_ps(r, _mm_mul_ps(t, _mm_set1_ps(LOG2EA)));
+			r = _mm_add_ps(r, y);
+			r = _mm_add_ps(r, t);
+			return _mm_add_ps(r, e);
+		}
+
+		ENGINE_TARGET_AVX2 static ENGINE_INLINE __m256 log2(__m256 x)
+		{
+			using namespace FastMathConst;
+			const __m256 one = _mm256_set1_ps(1.0f);
+			__m256i bits = _mm256_castps_si256(x);
+
+			__m256 e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(126)));
+			__m256 m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)), _mm256_set1_epi32(0x3f000000)));
+
+			__m256 small = _mm256_cmp_ps(m, _mm256_set1_ps(SQRTHF), _CMP_LT_OQ);
+			e = _mm256_sub_ps(e, _mm256_and_ps(small, one));
+			__m256 t = _mm256_sub_ps(_mm256_add_ps(m, _mm256_and_ps(small, m)), one);
+			__m256 z = _mm256_mul_ps(t, t);
+
+			__m256 p = _mm256_fmadd_ps(t, _mm256_set1_ps(LOG_9), _mm256_set1_ps(LOG_8));
+			p = _mm256_fmadd_ps(t, p, _mm256_set1_ps(LOG_7));
+			p = _mm256_fmadd_ps(t, p, _mm256_set1_ps(LOG_6));
+			p = _mm256_fmadd_ps(t, p, _mm256_set1_ps(LOG_5));
+			p = _mm256_fmadd_ps(t, p, _mm256_set1_ps(LOG_4));
+			p = _mm256_fmadd_ps(t, p, _mm256_set1_ps(LOG_3));
+			p = _mm256_fmadd_ps(t, p, _mm256_set1_ps(LOG_2));
+			p = _mm256_fmadd_ps(t, p, _mm256_set1_ps(LOG_1));
+			__m256 y = _mm256_fnmadd_ps(_mm256_set1_ps(0.5f), z, _mm256_mul_ps(_mm256_mul_ps(t, z), p));
+
+			__m256 r = _mm256_mul_ps(y, _mm256_set1_ps(LOG2EA));
+			r = _mm256_fmadd_ps(t, _mm256_set1_ps(LOG2EA), r);
+			r = _mm256_add_ps(r, y);
+			r = _mm256_add_ps(r, t);
+			return _mm256_add_ps(r, e);
+		}
+	};
+#endif
+}
@@ -0,0 +1,254 @@
+/* Copyright (C) 2009-2020, Nick Galko Ltd. All rights reserved.
+*
+* This file is part of the NGTech (https://galek.github.io/portfolio/).
+*
+* Your use and or redistribution of this software in source and / or
+* binary form, with or without modification, is subject to: (i) your
+* ongoing acceptance of and compliance with the terms and conditions of
+* the NGTech License Agreement; and (ii) your inclusion of this notice
+* in any version of this software that you use or redistribute.
+* A copy of the NGTech License Agreement is available by contacting
+* Nick Galko Ltd. at https://galek.github.io/portfolio/
+*/
+//***************************************************************************
+#include <math.h>
+#include <string.h>
+//***************************************************************************
+#include "Frustum.h"
+#include "BBox.h"
+#include "BSphere.h"
+#include "SIMD.h"
+#include "Parallel.h"
+//***************************************************************************
+
+namespace NGTech
+{
+	static_assert(sizeof(BBox) == 12 * sizeof(float), "Frustum culling expects BBox as mins, maxes, center, half size!");
+	static_assert(sizeof(BSphere) == 4 * sizeof(float), "Frustum culling expects BSphere as center, radius!");
+
+	static const size_t MIN_OBJECTS_PER_THREAD = 32768;
+
+	/*
+	Gribb/Hartmann: the planes are sums and differences of the 4th row with the other rows
+	*/
+	void Frustum::Set(const Mat4& viewProj)
+	{
+		const float* e = viewProj.e;
+
+		for (int i = 0; i < PLANE_COUNT; i++)
+		{
+			int row = i / 2;
+			float sign = (i & 1) ? -Math::ONEFLOAT : Math::ONEFLOAT;
+
+			Vec4 p(e[3] + sign * e[row], e[7] + sign * e[4 + row], e[11] + sign * e[8 + row], e[15] + sign * e[12 + row]);
+
+			float length = sqrtf(p.x * p.x + p.y * p.y + p.z * p.z);
+			if (length > 0)
+				p = p * (Math::ONEFLOAT / length);
+
+			planes[i] = p;
+		}
+	}
+
+	/*
+	Box is outside when its vertex farthest along the plane normal is behind the plane.
+	max(n.x * min.x, n.x * max.x) picks that vertex per axis without branches, the SIMD
+	versions do the same operations in the same order, so results are identical.
+	*/
+	static ENGINE_INLINE bool _BoxVisible(const Vec4* planes, const BBox& box)
+	{
+		for (int i = 0; i < Frustum::PLANE_COUNT; i++)
+		{
+			const Vec4& p = planes[i];
+			float d = Math::Max(p.x * box.mins.x, p.x * box.maxes.x) + Math::Max(p.y * box.mins.y, p.y * box.maxes.y)
+				+ Math::Max(p.z * box.mins.z, p.z * box.maxes.z) + p.w;
+			if (d < 0)
+				return false;
+		}
+		return true;
+	}
+
+	static ENGINE_INLINE bool _SphereVisible(const Vec4* planes, const BSphere& sphere)
+	{
+		for (int i = 0; i < Frustum::PLANE_COUNT; i++)
+		{
+			const Vec4& p = planes[i];
+			float d = p.x * sphere.center.x + p.y * sphere.center.y + p.z * sphere.center.z + p.w;
+			if (d < -sphere.radius)
+				return false;
+		}
+		return true;
+	}
+
+	bool Frustum::IsVisible(const BBox& box) const
+	{
+		return _BoxVisible(planes, box);
+	}
+
+	bool Frustum::IsVisible(const BSphere& sphere) const
+	{
+		return _SphereVisible(planes, sphere);
+	}
+
+	/*
+	Kernels set the bits of objects [begin, end), the words must be cleared before
+	*/
+	static void _CullBoxesScalar(const Vec4* planes, const BBox* boxes, uint32_t* visibility, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+			visibility[i >> 5] |= (uint32_t)_BoxVisible(planes, boxes[i]) << (i & 31);
+	}
+
+	static void _CullSpheresScalar(const Vec4* planes, const BSphere* spheres, uint32_t* visibility, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+			visibility[i >> 5] |= (uint32_t)_SphereVisible(planes, spheres[i]) << (i & 31);
+	}
+
+#if MATH_SIMD_X86
+	/*
+	4 boxes: loads at mins.x and mins.z transpose to (minx, miny, minz, maxx) and (minz, maxx, maxy, maxz)
+	*/
+	ENGINE_TARGET_SSE41 static size_t _CullBoxesSSE41(const Vec4* planes, const BBox* boxes, uint32_t* visibility, size_t begin, size_t end)
+	{
+		size_t i = begin;
+		for (; i + 4 <= end; i += 4)
+		{
+			const BBox* b = boxes + i;
+			__m128 minX = _mm_loadu_ps(&b[0].mins.x), minY = _mm_loadu_ps(&b[1].mins.x), minZ = _mm_loadu_ps(&b[2].mins.x), maxX = _mm_loadu_ps(&b[3].mins.x);
+			__m128 t0 = _mm_loadu_ps(&b[0].mins.z), t1 = _mm_loadu_ps(&b[1].mins.z), maxY = _mm_loadu_ps(&b[2].mins.z), maxZ = _mm_loadu_ps(&b[3].mins.z);
+			_MM_TRANSPOSE4_PS(minX, minY, minZ, maxX);
+			_MM_TRANSPOSE4_PS(t0, t1, maxY, maxZ);
+
+			__m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (int p = 0; p < Frustum::PLANE_COUNT; p++)
+			{
+				__m128 nx = _mm_set1_ps(planes[p].x), ny = _mm_set1_ps(planes[p].y), nz = _mm_set1_ps(planes[p].z);
+				__m128 d = _mm_max_ps(_mm_mul_ps(nx, minX), _mm_mul_ps(nx, maxX));
+				d = _mm_add_ps(d, _mm_max_ps(_mm_mul_ps(ny, minY), _mm_mul_ps(ny, maxY)));
+				d = _mm_add_ps(d, _mm_max_ps(_mm_mul_ps(nz, minZ), _mm_mul_ps(nz, maxZ)));
+				d = _mm_add_ps(d, _mm_set1_ps(planes[p].w));
+				visible = _mm_andnot_ps(_mm_cmplt_ps(d, _mm_setzero_ps()), visible);
+			}
+
+			visibility[i >> 5] |= (uint32_t)_mm_movemask_ps(visible) << (i & 31);
+		}
+		return i;
+	}
+
+	ENGINE_TARGET_SSE41 static size_t _CullSpheresSSE41(const Vec4* planes, const BSphere* spheres, uint32_t* visibility, size_t begin, size_t end)
+	{
+		size_t i = begin;
+		for (; i + 4 <= end; i += 4)
+		{
+			const float* s = &spheres[i].center.x;
+			__m128 x = _mm_loadu_ps(s + 0), y = _mm_loadu_ps(s + 4), z = _mm_loadu_ps(s + 8), r = _mm_loadu_ps(s + 12);
+			_MM_TRANSPOSE4_PS(x, y, z, r);
+			__m128 minusR = _mm_sub_ps(_mm_setzero_ps(), r);
+
+			__m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (int p = 0; p < Frustum::PLANE_COUNT; p++)
+			{
+				__m128 d = _mm_mul_ps(_mm_set1_ps(planes[p].x), x);
+				d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(planes[p].y), y));
+				d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(planes[p].z), z));
+				d = _mm_add_ps(d, _mm_set1_ps(planes[p].w));
+				visible = _mm_andnot_ps(_mm_cmplt_ps(d, minusR), visible);
+			}
+
+			visibility[i >> 5] |= (uint32_t)_mm_movemask_ps(visible) << (i & 31);
+		}
+		return i;
+	}
+
+	/*
+	8 objects, boxes i and i + 4 share a register and are transposed in their 128-bit lanes
+	*/
+	ENGINE_TARGET_AVX2 static size_t _CullBoxesAVX2(const Vec4* planes, const BBox* boxes, uint32_t* visibility, size_t begin, size_t end)
+	{
+		size_t i = begin;
+		for (; i + 8 <= end; i += 8)
+		{
+			const BBox* b = boxes + i;
+			__m256 minX = SIMD::Load2(&b[0].mins.x, &b[4].mins.x), minY = SIMD::Load2(&b[1].mins.x, &b[5].mins.x);
+			__m256 minZ = SIMD::Load2(&b[2].mins.x, &b[6].mins.x), maxX = SIMD::Load2(&b[3].mins.x, &b[7].mins.x);
+			__m256 t0 = SIMD::Load2(&b[0].mins.z, &b[4].mins.z), t1 = SIMD::Load2(&b[1].mins.z, &b[5].mins.z);
+			__m256 maxY = SIMD::Load2(&b[2].mins.z, &b[6].mins.z), maxZ = SIMD::Load2(&b[3].mins.z, &b[7].mins.z);
+			SIMD::Transpose4x4(minX, minY, minZ, maxX);
+			SIMD::Transpose4x4(t0, t1, maxY, maxZ);
+
+			__m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+			for (int p = 0; p < Frustum::PLANE_COUNT; p++)
+			{
+				__m256 nx = _mm256_set1_ps(planes[p].x), ny = _mm256_set1_ps(planes[p].y), nz = _mm256_set1_ps(planes[p].z);
+				__m256 d = _mm256_max_ps(_mm256_mul_ps(nx, minX), _mm256_mul_ps(nx, maxX));
+				d = _mm256_add_ps(d, _mm256_max_ps(_mm256_mul_ps(ny, minY), _mm256_mul_ps(ny, maxY)));
+				d = _mm256_add_ps(d, _mm256_max_ps(_mm256_mul_ps(nz, minZ), _mm256_mul_ps(nz, maxZ)));
+				d = _mm256_add_ps(d, _mm256_set1_ps(planes[p].w));
+				visible = _mm256_andnot_ps(_mm256_cmp_ps(d, _mm256_setzero_ps(), _CMP_LT_OQ), visible);
+			}
+
+			visibility[i >> 5] |= (uint32_t)_mm256_movemask_ps(visible) << (i & 31);
+		}
+		return _CullBoxesSSE41(planes, boxes, visibility, i, end);
+	}
+
+	ENGINE_TARGET_AVX2 static size_t _CullSpheresAVX2(const Vec4* planes, const BSphere* spheres, uint32_t* visibility, size_t begin, size_t end)
+	{
+		size_t i = begin;
+		for (; i + 8 <= end; i += 8)
+		{
+			const float* s = &spheres[i].center.x;
+			__m256 x = SIMD::Load2(s + 0, s + 16), y = SIMD::Load2(s + 4, s + 20), z = SIMD::Load2(s + 8, s + 24), r = SIMD::Load2(s + 12, s + 28);
+			SIMD::Transpose4x4(x, y, z, r);
+			__m256 minusR = _mm256_sub_ps(_mm256_setzero_ps(), r);
+
+			__m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+			for (int p = 0; p < Frustum::PLANE_COUNT; p++)
+			{
+				__m256 d = _mm256_mul_ps(_mm256_set1_ps(planes[p].x), x);
+				d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_set1_ps(planes[p].y), y));
+				d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_set1_ps(planes[p].z), z));
+				d = _mm256_add_ps(d, _mm256_set1_ps(planes[p].w));
+				visible = _mm256_andnot_ps(_mm256_cmp_ps(d, minusR, _CMP_LT_OQ), visible);
+			}
+
+			visibility[i >> 5] |= (uint32_t)_mm256_movemask_ps(visible) << (i & 31);
+		}
+		return _CullSpheresSSE41(planes, spheres, visibility, i, end);
+	}
+#endif
+
+	/*
+	Threads get whole words of the visibility mask
+	*/
+	void Frustum::Cull(const BBox* boxes, size_t count, uint32_t* visibility) const
+	{
+		size_t words = (count + 31) / 32;
+		Parallel::For(words, MIN_OBJECTS_PER_THREAD / 32, [&](size_t first, size_t last)
+		{
+			memset(visibility + first, 0, (last - first) * sizeof(uint32_t));
+
+			size_t begin = first * 32;
+			size_t end = Math::Min(last * 32, count);
+			size_t i = begin;
+			SIMD_DISPATCH(i, _CullBoxes, planes, boxes, visibility, begin, end);
+			_CullBoxesScalar(planes, boxes, visibility, i, end);
+		});
+	}
+
+	void Frustum::Cull(const BSphere* spheres, size_t count, uint32_t* visibility) const
+	{
+		size_t words = (count + 31) / 32;
+		Parallel::For(words, MIN_OBJECTS_PER_THREAD / 32, [&](size_t first, size_t last)
+		{
+			memset(visibility + first, 0, (last - first) * sizeof(uint32_t));
+
+			size_t begin = first * 32;
+			size_t end = Math::Min(last * 32, count);
+			size_t i = begin;
+			SIMD_DISPATCH(i, _CullSpheres, planes, spheres, visibility, begin, end);
+			_CullSpheresScalar(planes, spheres, visibility, i, end);
+		});
+	}
+}
@@ -0,0 +1,67 @@
+/* Copyright (C) 2009-2020, Nick Galko Ltd. All rights reserved.
+*
+* This file is part of the NGTech (https://galek.github.io/portfolio/).
+*
+* Your use and or redistribution of this software in source and / or
+* binary form, with or without modification, is subject to: (i) your
+* ongoing acceptance of and compliance with the terms and conditions of
+* the NGTech License Agreement; and (ii) your inclusion of this notice
+* in any version of this software that you use or redistribute.
+* A copy of the NGTech License Agreement is available by contacting
+* Nick Galko Ltd. at https://galek.github.io/portfolio/
+*/
+#pragma once
+
+//***************************************************************************
+#include "MathLib.h"
+//***************************************************************************
+
+namespace NGTech
+{
+	class BBox;
+	class BSphere;
+
+	/**
+	View frustum as 6 planes (normal, distance) with normals pointing inside, extracted from
+	a view-projection matrix with OpenGL clip space (-w <= z <= w), as made by Mat4::perspective
+	and Mat4::ortho. Planes are normalized, so Vec4::dot(plane, Vec4(p, 1)) is a distance.
+	*/
+	class Frustum
+	{
+	public:
+		enum Plane
+		{
+			PLANE_LEFT = 0,
+			PLANE_RIGHT,
+			PLANE_BOTTOM,
+			PLANE_TOP,
+			PLANE_NEAR,
+			PLANE_FAR,
+			PLANE_COUNT
+		};
+
+		Vec4 planes[PLANE_COUNT];
+
+		/**
+		Every object is visible
+		*/
+		Frustum() {}
+		explicit Frustum(const Mat4& viewProj) { Set(viewProj); }
+
+		void Set(const Mat4& viewProj);
+
+		/**
+		Conservative tests: objects intersecting the frustum or only touching a plane are visible
+		*/
+		bool IsVisible(const BBox& box) const;
+		bool IsVisible(const BSphere& sphere) const;
+
+		/**
+		Batch tests, same results as IsVisible. Bit (i % 32) of visibility[i / 32] is set when
+		object i is visible; visibility must hold (count + 31) / 32 words, unused bits are cleared.
+		Large arrays are split over the Parallel threads.
+		*/
+		void Cull(const BBox* boxes, size_t count, uint32_t* visibility) const;
+		void Cull(const BSphere* spheres, size_t count, uint32_t* visibility) const;
+	};
+}
@@ -0,0 +1,193 @@
+/* Copyright (C) 2009-2020, Nick Galko Ltd. All rights reserved.
+*
+* This file is part of the NGTech (https://galek.github.io/portfolio/).
+*
+* Your use and or redistribution of this software in source and / or
+* binary form, with or without modification, is subject to: (i) your
+* ongoing acceptance of and compliance with the terms and conditions of
+* the NGTech License Agreement; and (ii) your inclusion of this notice
+* in any version of this software that you use or redistribute.
+* A copy of the NGTech License Agreement is available by contacting
+* Nick Galko Ltd. at https://galek.github.io/portfolio/
+*/
+//***************************************************************************
+#include "MathLib.h"
+#include "SIMD.h"
+#include "Parallel.h"
+//***************************************************************************
+#include <string.h>
+#include <vector>
+//***************************************************************************
+
+namespace NGTech
+{
+	/*
+	Below this many nodes per thread the propagation runs on the calling thread
+	*/
+	static const size_t MIN_NODES_PER_THREAD = 4096;
+
+	/*
+	Sources of the local matrices
+	*/
+	struct _LocalMat4
+	{
+		const Mat4* local;
+
+		ENGINE_INLINE const float* Get(size_t i, Mat4&) const {
+			return local[i].e;
+		}
+	};
+
+	struct _LocalTRS
+	{
+		const Vec3* translations;
+		const Quat* rotations;
+		const Vec3* scales;
+
+		ENGINE_INLINE const float* Get(size_t i, Mat4& tmp) const {
+			Utils::QuatTRSToMat4(translations + i, rotations + i, scales ? scales + i : nullptr, &tmp, 1);
+			return tmp.e;
+		}
+	};
+
+	/*
+	r may be the same memory as b
+	*/
+	static void _MulScalar(float* r, const float* a, const float* b)
+	{
+		float t[16];
+		for (int c = 0; c < 16; c += 4) {
+			t[c + 0] = (a[0] * b[c]) + (a[4] * b[c + 1]) + (a[8] * b[c + 2]) + (a[12] * b[c + 3]);
+			t[c + 1] = (a[1] * b[c]) + (a[5] * b[c + 1]) + (a[9] * b[c + 2]) + (a[13] * b[c + 3]);
+			t[c + 2] = (a[2] * b[c]) + (a[6] * b[c + 1]) + (a[10] * b[c + 2]) + (a[14] * b[c + 3]);
+			t[c + 3] = (a[3] * b[c]) + (a[7] * b[c + 1]) + (a[11] * b[c + 2]) + (a[15] * b[c + 3]);
+		}
+		memcpy(r, t, sizeof(t));
+	}
+
+#if MATH_SIMD_X86
+	ENGINE_TARGET_SSE41 static void _MulSSE41(float* r, const float* a, const float* b)
+	{
+		SIMD::MulMat4SSE41(r, a, b);
+	}
+
+	ENGINE_TARGET_AVX2 static void _MulAVX2(float* r, const float* a, const float* b)
+	{
+		SIMD::MulMat4AVX2(r, a, b);
+	}
+#endif
+
+	/*
+	Processes nodes[0..count) (or 0..count when nodes is nullptr) in the given order
+	*/
+	template<class LOCAL, void(*MUL)(float*, const float*, const float*)>
+	static void _Propagate(const LOCAL& local, const int* parents, Mat4* world, const int* nodes, size_t count)
+	{
+		Mat4 tmp;
+
+		for (size_t k = 0; k < count; k++)
+		{
+			size_t i = nodes ? (size_t)nodes[k] : k;
+			int parent = parents[i];
+			ASSERT(parent < (int)i, "[Utils] PARENT MUST PRECEDE ITS CHILDREN");
+
+			const float* l = local.Get(i, tmp);
+			if (parent < 0)
+				memmove(world[i].e, l, sizeof(Mat4));
+			else
+				MUL(world[i].e, world[parent].e, l);
+		}
+	}
+
+	template<class LOCAL>
+	static void _PropagateDispatch(const LOCAL& local, const int* parents, Mat4* world, const int* nodes, size_t count)
+	{
+		switch (SIMD::GetLevel())
+		{
+#if MATH_SIMD_X86
+		case SIMD::LEVEL_AVX2: _Propagate<LOCAL, _MulAVX2>(local, parents, world, nodes, count); break;
+		case SIMD::LEVEL_SSE41: _Propagate<LOCAL, _MulSSE41>(local, parents, world, nodes, count); break;
+#endif
+		default: _Propagate<LOCAL, _MulScalar>(local, parents, world, nodes, count); break;
+		}
+	}
+
+	/*
+	Subtrees of different roots do not depend on each other. Roots are grouped
+	to ranges of about the same node count, then nodes are bucketed per range
+	keeping their order, so every range stays topologically sorted.
+	*/
+	template<class LOCAL>
+	static void _PropagateHierarchy(const LOCAL& local, const int* parents, Mat4* world, size_t count)
+	{
+		size_t ranges = Parallel::GetRangeCount(count, MIN_NODES_PER_THREAD);
+		if (ranges <= 1) {
+			_PropagateDispatch(local, parents, world, nullptr, count);
+			return;
+		}
+
+		// subtree sizes, counted at the root
+		std::vector<int> group(count);
+		std::vector<int> sizes(count, 0);
+		for (size_t i = 0; i < count; i++)
+		{
+			int parent = parents[i];
+			group[i] = (parent < 0) ? (int)i : group[parent];
+			sizes[group[i]]++;
+		}
+
+		// root -> range, children inherit the range of the parent
+		std::vector<size_t> offsets(ranges + 1, 0);
+		size_t current = 0, assigned = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			int parent = parents[i];
+			if (parent < 0) {
+				if (current + 1 < ranges && assigned >= count * (current + 1) / ranges)
+					current++;
+				group[i] = (int)current;
+				assigned += sizes[i];
+			}
+			else
+				group[i] = group[parent];
+
+			offsets[group[i] + 1]++;
+		}
+
+		ranges = current + 1;
+		if (ranges <= 1) {
+			_PropagateDispatch(local, parents, world, nullptr, count);
+			return;
+		}
+
+		for (size_t r = 0; r < ranges; r++)
+			offsets[r + 1] += offsets[r];
+
+		// reuse sizes as the ordered node lists
+		std::vector<int>& nodes = sizes;
+		std::vector<size_t> cursor(offsets.begin(), offsets.begin() + ranges);
+		for (size_t i = 0; i < count; i++)
+			nodes[cursor[group[i]]++] = (int)i;
+
+		Parallel::For(ranges, 1, [&](size_t begin, size_t end)
+		{
+			for (size_t r = begin; r < end; r++)
+				_PropagateDispatch(local, parents, world, nodes.data() + offsets[r], offsets[r + 1] - offsets[r]);
+		});
+	}
+
+	namespace Utils
+	{
+		void PropagateHierarchy(const Mat4* local, const int* parents, Mat4* world, size_t count)
+		{
+			_LocalMat4 source = { local };
+			_PropagateHierarchy(source, parents, world, count);
+		}
+
+		void PropagateHierarchy(const Vec3* translations, const Quat* rotations, const Vec3* scales, const int* parents, Mat4* world, size_t count)
+		{
+			_LocalTRS source = { translations, rotations, scales };
+			_PropagateHierarchy(source, parents, world, count);
+		}
+	}
+}
@@ -0,0 +1,427 @@
+/* Copyright (C) 2009-2020, Nick Galko Ltd. All rights reserved.
+*
+* This file is part of the NGTech (https://galek.github.io/portfolio/).
+*
+* Your use and or redistribution of this software in source and / or
+* binary form, with or without modification, is subject to: (i) your
+* ongoing acceptance of and compliance with the terms and conditions of
+* the NGTech License Agreement; and (ii) your inclusion of this notice
+* in any version of this software that you use or redistribute.
+* A copy of the NGTech License Agreement is available by contacting
+* Nick Galko Ltd. at https://galek.github.io/portfolio/
+*/
+//***************************************************************************
+#include <stdint.h>
+//***************************************************************************
+#include "Intersection.h"
+#include "BSphere.h"
+#include "Vec3SoA.h"
+#include "SIMD.h"
+//***************************************************************************
+
+namespace NGTech
+{
+	/*
+	Closest triangle so far, index is SIZE_MAX until something is hit
+	*/
+	struct _TriangleHit
+	{
+		size_t index;
+		float t, u, v;
+	};
+
+	static void _IntersectTrianglesScalar(const Vec3* triangles, size_t begin, size_t end, const Vec3& src, const Vec3& dst, _TriangleHit& hit)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			const Vec3* p = triangles + i * 3;
+			float t, u, v;
+			if (Math::intersectTriangleByRay(p[0], p[1], p[2], src, dst, t, u, v) && t < hit.t) {
+				hit.index = i;
+				hit.t = t;
+				hit.u = u;
+				hit.v = v;
+			}
+		}
+	}
+
+	/*
+	Closest sphere so far, index is SIZE_MAX until something is hit
+	*/
+	struct _SphereHit
+	{
+		size_t index;
+		float t;
+	};
+
+	static void _IntersectSpheresScalar(const Vec3SoA& centers, const float* radii, size_t begin, size_t end, const Vec3& src, const Vec3& dst, _SphereHit& hit)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			float t;
+			if (BSphere(centers.Get(i), radii[i]).IntersectsRay(src, dst, t) && t < hit.t) {
+				hit.index = i;
+				hit.t = t;
+			}
+		}
+	}
+
+	static size_t _IntersectSphereByRaysScalar(const BSphere& sphere, const Vec3SoA& src, const Vec3SoA& dst, size_t begin, size_t end, float* t)
+	{
+		size_t hits = 0;
+		for (size_t i = begin; i < end; i++)
+		{
+			if (sphere.IntersectsRay(src.Get(i), dst.Get(i), t[i]))
+				hits++;
+			else
+				t[i] = -1;
+		}
+
+		return hits;
+	}
+
+	static ENGINE_INLINE size_t _BitCount(uint32_t bits)
+	{
+		size_t count = 0;
+		for (; bits; bits &= bits - 1)
+			count++;
+		return count;
+	}
+
+#if MATH_SIMD_X86
+	/*
+	Lanes keep their own closest hit (index relative to begin, -1 for none), the lanes
+	are merged to hit in the end. Lanes run SIMD::IntersectTriangles with tMax 1.
+	*/
+	static void _MergeLanes(const float* t, const float* u, const float* v, const int* index, int lanes, size_t begin, _TriangleHit& hit)
+	{
+		int best = SIMD::BestLane(t, index, lanes);
+		if (best >= 0 && t[best] < hit.t) {
+			hit.index = begin + index[best];
+			hit.t = t[best];
+			hit.u = u[best];
+			hit.v = v[best];
+		}
+	}
+
+	/*
+	Triangle k starts at p + 9 * k: loads at vertex 0 and 1 transpose to (x, y, z, -),
+	the load of vertex 2 starts one float earlier to stay inside the last triangle
+	*/
+	ENGINE_TARGET_SSE41 static size_t _IntersectTrianglesSSE41(const Vec3* triangles, size_t begin, size_t end, const Vec3& src, const Vec3& dst, _TriangleHit& hit)
+	{
+		Vec3 dir = dst - src;
+		__m128 o[3] = { _mm_set1_ps(src.x), _mm_set1_ps(src.y), _mm_set1_ps(src.z) };
+		__m128 d[3] = { _mm_set1_ps(dir.x), _mm_set1_ps(dir.y), _mm_set1_ps(dir.z) };
+		__m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+
+		__m128 bestT = _mm_set1_ps(hit.t), bestU = zero, bestV = zero;
+		__m128i bestIndex = _mm_set1_epi32(-1);
+		__m128i index = _mm_setr_epi32(0, 1, 2, 3);
+
+		size_t i = begin;
+		for (; i + 4 <= end; i += 4, index = _mm_add_epi32(index, _mm_set1_epi32(4)))
+		{
+			const float* p = &triangles[i * 3].x;
+			__m128 ax = _mm_loadu_ps(p + 0), ay = _mm_loadu_ps(p + 9), az = _mm_loadu_ps(p + 18), aw = _mm_loadu_ps(p + 27);
+			__m128 bx = _mm_loadu_ps(p + 3), by = _mm_loadu_ps(p + 12), bz = _mm_loadu_ps(p + 21), bw = _mm_loadu_ps(p + 30);
+			__m128 cw = _mm_loadu_ps(p + 5), cx = _mm_loadu_ps(p + 14), cy = _mm_loadu_ps(p + 23), cz = _mm_loadu_ps(p + 32);
+			_MM_TRANSPOSE4_PS(ax, ay, az, aw);
+			_MM_TRANSPOSE4_PS(bx, by, bz, bw);
+			_MM_TRANSPOSE4_PS(cw, cx, cy, cz);
+
+			__m128 va[3] = { ax, ay, az }, vb[3] = { bx, by, bz }, vc[3] = { cx, cy, cz };
+			__m128 t, u, v;
+			__m128 mask = SIMD::IntersectTriangles(o, d, va, vb, vc, one, t, u, v);
+			mask = _mm_and_ps(mask, _mm_cmplt_ps(t, bestT));
+
+			bestT = _mm_blendv_ps(bestT, t, mask);
+			bestU = _mm_blendv_ps(bestU, u, mask);
+			bestV = _mm_blendv_ps(bestV, v, mask);
+			bestIndex = _mm_castps_si128(_mm_blendv_ps(_mm_castsi128_ps(bestIndex), _mm_castsi128_ps(index), mask));
+		}
+
+		float t[4], u[4], v[4];
+		int lanes[4];
+		_mm_storeu_ps(t, bestT);
+		_mm_storeu_ps(u, bestU);
+		_mm_storeu_ps(v, bestV);
+		_mm_storeu_si128((__m128i*)lanes, bestIndex);
+		_MergeLanes(t, u, v, lanes, 4, begin, hit);
+
+		return i;
+	}
+
+	/*
+	Triangles k and k + 4 share a register
+	*/
+	ENGINE_TARGET_AVX2 static size_t _IntersectTrianglesAVX2(const Vec3* triangles, size_t begin, size_t end, const Vec3& src, const Vec3& dst, _TriangleHit& hit)
+	{
+		Vec3 dir = dst - src;
+		__m256 o[3] = { _mm256_set1_ps(src.x), _mm256_set1_ps(src.y), _mm256_set1_ps(src.z) };
+		__m256 d[3] = { _mm256_set1_ps(dir.x), _mm256_set1_ps(dir.y), _mm256_set1_ps(dir.z) };
+		__m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+
+		__m256 bestT = _mm256_set1_ps(hit.t), bestU = zero, bestV = zero;
+		__m256i bestIndex = _mm256_set1_epi32(-1);
+		__m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+		size_t i = begin;
+		for (; i + 8 <= end; i += 8, index = _mm256_add_epi32(index, _mm256_set1_epi32(8)))
+		{
+			const float* p = &triangles[i * 3].x;
+			__m256 ax = SIMD::Load2(p + 0, p + 36), ay = SIMD::Load2(p + 9, p + 45), az = SIMD::Load2(p + 18, p + 54), aw = SIMD::Load2(p + 27, p + 63);
+			__m256 bx = SIMD::Load2(p + 3, p + 39), by = SIMD::Load2(p + 12, p + 48), bz = SIMD::Load2(p + 21, p + 57), bw = SIMD::Load2(p + 30, p + 66);
+			__m256 cw = SIMD::Load2(p + 5, p + 41), cx = SIMD::Load2(p + 14, p + 50), cy = SIMD::Load2(p + 23, p + 59), cz = SIMD::Load2(p + 32, p + 68);
+			SIMD::Transpose4x4(ax, ay, az, aw);
+			SIMD::Transpose4x4(bx, by, bz, bw);
+			SIMD::Transpose4x4(cw, cx, cy, cz);
+
+			__m256 va[3] = { ax, ay, az }, vb[3] = { bx, by, bz }, vc[3] = { cx, cy, cz };
+			__m256 t, u, v;
+			__m256 mask = SIMD::IntersectTriangles(o, d, va, vb, vc, one, t, u, v);
+			mask = _mm256_and_ps(mask, _mm256_cmp_ps(t, bestT, _CMP_LT_OQ));
+
+			bestT = _mm256_blendv_ps(bestT, t, mask);
+			bestU = _mm256_blendv_ps(bestU, u, mask);
+			bestV = _mm256_blendv_ps(bestV, v, mask);
+			bestIndex = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(bestIndex), _mm256_castsi256_ps(index), mask));
+		}
+
+		float t[8], u[8], v[8];
+		int lanes[8];
+		_mm256_storeu_ps(t, bestT);
+		_mm256_storeu_ps(u, bestU);
+		_mm256_storeu_ps(v, bestV);
+		_mm256_storeu_si256((__m256i*)lanes, bestIndex);
+		_MergeLanes(t, u, v, lanes, 8, begin, hit);
+
+		return _IntersectTrianglesSSE41(triangles, i, end, src, dst, hit);
+	}
+
+	static void _MergeSphereLanes(const float* t, const int* index, int lanes, size_t begin, _SphereHit& hit)
+	{
+		int best = SIMD::BestLane(t, index, lanes);
+		if (best >= 0 && t[best] < hit.t) {
+			hit.index = begin + index[best];
+			hit.t = t[best];
+		}
+	}
+
+	/*
+	Same operations as BSphere::IntersectsRay per lane, returns the hit mask.
+	t is only computed when some lane hits from outside, misses never take the square root.
+	*/
+	ENGINE_TARGET_SSE41 static ENGINE_INLINE __m128 _SphereSSE41(__m128 ocx, __m128 ocy, __m128 ocz, __m128 dx, __m128 dy, __m128 dz, __m128 radius, __m128& t)
+	{
+		__m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+		__m128 c = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(ocx, ocx), _mm_mul_ps(ocy, ocy)), _mm_mul_ps(ocz, ocz)), _mm_mul_ps(radius, radius));
+		__m128 a = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+		__m128 b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, ocx), _mm_mul_ps(dy, ocy)), _mm_mul_ps(dz, ocz));
+		__m128 disc = _mm_sub_ps(_mm_mul_ps(b, b), _mm_mul_ps(a, c));
+		__m128 negB = _mm_sub_ps(zero, b);
+
+		__m128 inside = _mm_cmple_ps(c, zero);
+		__m128 end = _mm_or_ps(_mm_cmple_ps(_mm_add_ps(_mm_add_ps(a, _mm_add_ps(b, b)), c), zero), _mm_cmple_ps(negB, a));
+		__m128 ahead = _mm_and_ps(_mm_and_ps(_mm_cmplt_ps(b, zero), _mm_cmpge_ps(disc, zero)), end);
+
+		t = zero;
+		if (_mm_movemask_ps(ahead)) {
+			__m128 tHit = _mm_min_ps(_mm_div_ps(_mm_sub_ps(negB, _mm_sqrt_ps(_mm_max_ps(disc, zero))), a), one);
+			t = _mm_andnot_ps(inside, tHit);
+		}
+
+		return _mm_or_ps(inside, ahead);
+	}
+
+	ENGINE_TARGET_SSE41 static size_t _IntersectSpheresSSE41(const Vec3SoA& centers, const float* radii, size_t begin, size_t end, const Vec3& src, const Vec3& dst, _SphereHit& hit)
+	{
+		Vec3 dir = dst - src;
+		__m128 ox = _mm_set1_ps(src.x), oy = _mm_set1_ps(src.y), oz = _mm_set1_ps(src.z);
+		__m128 dx = _mm_set1_ps(dir.x), dy = _mm_set1_ps(dir.y), dz = _mm_set1_ps(dir.z);
+
+		__m128 bestT = _mm_set1_ps(hit.t);
+		__m128i bestIndex = _mm_set1_epi32(-1);
+		__m128i index = _mm_setr_epi32(0, 1, 2, 3);
+
+		size_t i = begin;
+		for (; i + 4 <= end; i += 4, index = _mm_add_epi32(index, _mm_set1_epi32(4)))
+		{
+			__m128 ocx = _mm_sub_ps(ox, _mm_loadu_ps(centers.x + i));
+			__m128 ocy = _mm_sub_ps(oy, _mm_loadu_ps(centers.y + i));
+			__m128 ocz = _mm_sub_ps(oz, _mm_loadu_ps(centers.z + i));
+
+			__m128 t;
+			__m128 mask = _SphereSSE41(ocx, ocy, ocz, dx, dy, dz, _mm_loadu_ps(radii + i), t);
+			mask = _mm_and_ps(mask, _mm_cmplt_ps(t, bestT));
+
+			bestT = _mm_blendv_ps(bestT, t, mask);
+			bestIndex = _mm_castps_si128(_mm_blendv_ps(_mm_castsi128_ps(bestIndex), _mm_castsi128_ps(index), mask));
+		}
+
+		float t[4];
+		int lanes[4];
+		_mm_storeu_ps(t, bestT);
+		_mm_storeu_si128((__m128i*)lanes, bestIndex);
+		_MergeSphereLanes(t, lanes, 4, begin, hit);
+
+		return i;
+	}
+
+	ENGINE_TARGET_SSE41 static size_t _IntersectSphereByRaysSSE41(const BSphere& sphere, const Vec3SoA& src, const Vec3SoA& dst, size_t& i, size_t end, float* t)
+	{
+		__m128 cx = _mm_set1_ps(sphere.center.x), cy = _mm_set1_ps(sphere.center.y), cz = _mm_set1_ps(sphere.center.z);
+		__m128 radius = _mm_set1_ps(sphere.radius), miss = _mm_set1_ps(-1.0f);
+
+		size_t hits = 0;
+		for (; i + 4 <= end; i += 4)
+		{
+			__m128 ox = _mm_loadu_ps(src.x + i), oy = _mm_loadu_ps(src.y + i), oz = _mm_loadu_ps(src.z + i);
+			__m128 dx = _mm_sub_ps(_mm_loadu_ps(dst.x + i), ox);
+			__m128 dy = _mm_sub_ps(_mm_loadu_ps(dst.y + i), oy);
+			__m128 dz = _mm_sub_ps(_mm_loadu_ps(dst.z + i), oz);
+
+			__m128 tHit;
+			__m128 mask = _SphereSSE41(_mm_sub_ps(ox, cx), _mm_sub_ps(oy, cy), _mm_sub_ps(oz, cz), dx, dy, dz, radius, tHit);
+			_mm_storeu_ps(t + i, _mm_blendv_ps(miss, tHit, mask));
+			hits += _BitCount((uint32_t)_mm_movemask_ps(mask));
+		}
+
+		return hits;
+	}
+
+	ENGINE_TARGET_AVX2 static ENGINE_INLINE __m256 _SphereAVX2(__m256 ocx, __m256 ocy, __m256 ocz, __m256 dx, __m256 dy, __m256 dz, __m256 radius, __m256& t)
+	{
+		__m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+		__m256 c = _mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ocx, ocx), _mm256_mul_ps(ocy, ocy)), _mm256_mul_ps(ocz, ocz)), _mm256_mul_ps(radius, radius));
+		__m256 a = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+		__m256 b = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, ocx), _mm256_mul_ps(dy, ocy)), _mm256_mul_ps(dz, ocz));
+		__m256 disc = _mm256_sub_ps(_mm256_mul_ps(b, b), _mm256_mul_ps(a, c));
+		__m256 negB = _mm256_sub_ps(zero, b);
+
+		__m256 inside = _mm256_cmp_ps(c, zero, _CMP_LE_OQ);
+		__m256 end = _mm256_or_ps(_mm256_cmp_ps(_mm256_add_ps(_mm256_add_ps(a, _mm256_add_ps(b, b)), c), zero, _CMP_LE_OQ), _mm256_cmp_ps(negB, a, _CMP_LE_OQ));
+		__m256 ahead = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(b, zero, _CMP_LT_OQ), _mm256_cmp_ps(disc, zero, _CMP_GE_OQ)), end);
+
+		t = zero;
+		if (_mm256_movemask_ps(ahead)) {
+			__m256 tHit = _mm256_min_ps(_mm256_div_ps(_mm256_sub_ps(negB, _mm256_sqrt_ps(_mm256_max_ps(disc, zero))), a), one);
+			t = _mm256_andnot_ps(inside, tHit);
+		}
+
+		return _mm256_or_ps(inside, ahead);
+	}
+
+	ENGINE_TARGET_AVX2 static size_t _IntersectSpheresAVX2(const Vec3SoA& centers, const float* radii, size_t begin, size_t end, const Vec3& src, const Vec3& dst, _SphereHit& hit)
+	{
+		Vec3 dir = dst - src;
+		__m256 ox = _mm256_set1_ps(src.x), oy = _mm256_set1_ps(src.y), oz = _mm256_set1_ps(src.z);
+		__m256 dx = _mm256_set1_ps(dir.x), dy = _mm256_set1_ps(dir.y), dz = _mm256_set1_ps(dir.z);
+
+		__m256 bestT = _mm256_set1_ps(hit.t);
+		__m256i bestIndex = _mm256_set1_epi32(-1);
+		__m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+		size_t i = begin;
+		for (; i + 8 <= end; i += 8, index = _mm256_add_epi32(index, _mm256_set1_epi32(8)))
+		{
+			__m256 ocx = _mm256_sub_ps(ox, _mm256_loadu_ps(centers.x + i));
+			__m256 ocy = _mm256_sub_ps(oy, _mm256_loadu_ps(centers.y + i));
+			__m256 ocz = _mm256_sub_ps(oz, _mm256_loadu_ps(centers.z + i));
+
+			__m256 t;
+			__m256 mask = _SphereAVX2(ocx, ocy, ocz, dx, dy, dz, _mm256_loadu_ps(radii + i), t);
+			mask = _mm256_and_ps(mask, _mm256_cmp_ps(t, bestT, _CMP_LT_OQ));
+
+			bestT = _mm256_blendv_ps(bestT, t, mask);
+			bestIndex = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(bestIndex), _mm256_castsi256_ps(index), mask));
+		}
+
+		float t[8];
+		int lanes[8];
+		_mm256_storeu_ps(t, bestT);
+		_mm256_storeu_si256((__m256i*)lanes, bestIndex);
+		_MergeSphereLanes(t, lanes, 8, begin, hit);
+
+		return _IntersectSpheresSSE41(centers, radii, i, end, src, dst, hit);
+	}
+
+	ENGINE_TARGET_AVX2 static size_t _IntersectSphereByRaysAVX2(const BSphere& sphere, const Vec3SoA& src, const Vec3SoA& dst, size_t& i, size_t end, float* t)
+	{
+		__m256 cx = _mm256_set1_ps(sphere.center.x), cy = _mm256_set1_ps(sphere.center.y), cz = _mm256_set1_ps(sphere.center.z);
+		__m256 radius = _mm256_set1_ps(sphere.radius), miss = _mm256_set1_ps(-1.0f);
+
+		size_t hits = 0;
+		for (; i + 8 <= end; i += 8)
+		{
+			__m256 ox = _mm256_loadu_ps(src.x + i), oy = _mm256_loadu_ps(src.y + i), oz = _mm256_loadu_ps(src.z + i);
+			__m256 dx = _mm256_sub_ps(_mm256_loadu_ps(dst.x + i), ox);
+			__m256 dy = _mm256_sub_ps(_mm256_loadu_ps(dst.y + i), oy);
+			__m256 dz = _mm256_sub_ps(_mm256_loadu_ps(dst.z + i), oz);
+
+			__m256 tHit;
+			__m256 mask = _SphereAVX2(_mm256_sub_ps(ox, cx), _mm256_sub_ps(oy, cy), _mm256_sub_ps(oz, cz), dx, dy, dz, radius, tHit);
+			_mm256_storeu_ps(t + i, _mm256_blendv_ps(miss, tHit, mask));
+			hits += _BitCount((uint32_t)_mm256_movemask_ps(mask));
+		}
+
+		return hits + _IntersectSphereByRaysSSE41(sphere, src, dst, i, end, t);
+	}
+#endif
+
+	namespace Utils
+	{
+		bool IntersectTrianglesByRay(const Vec3* triangles, size_t count, const Vec3& src, const Vec3& dst,
+			size_t& index, float& t, float& u, float& v)
+		{
+			_TriangleHit hit;
+			hit.index = SIZE_MAX;
+			hit.t = FLT_MAX;
+			hit.u = hit.v = 0;
+
+			size_t i = 0;
+			SIMD_DISPATCH(i, _IntersectTriangles, triangles, 0, count, src, dst, hit);
+			_IntersectTrianglesScalar(triangles, i, count, src, dst, hit);
+
+			if (hit.index == SIZE_MAX)
+				return false;
+
+			index = hit.index;
+			t = hit.t;
+			u = hit.u;
+			v = hit.v;
+			return true;
+		}
+
+		bool IntersectSpheresByRay(const Vec3SoA& centers, const float* radii, const Vec3& src, const Vec3& dst,
+			size_t& index, float& t)
+		{
+			_SphereHit hit;
+			hit.index = SIZE_MAX;
+			hit.t = FLT_MAX;
+
+			size_t count = centers.Size();
+			size_t i = 0;
+			SIMD_DISPATCH(i, _IntersectSpheres, centers, radii, 0, count, src, dst, hit);
+			_IntersectSpheresScalar(centers, radii, i, count, src, dst, hit);
+
+			if (hit.index == SIZE_MAX)
+				return false;
+
+			index = hit.index;
+			t = hit.t;
+			return true;
+		}
+
+		size_t IntersectSphereByRays(const BSphere& sphere, const Vec3SoA& src, const Vec3SoA& dst, float* t)
+		{
+			ASSERT(src.Size() == dst.Size(), "[Intersection] SIZE MISMATCH");
+
+			size_t count = src.Size();
+			size_t i = 0, hits = 0;
+			SIMD_DISPATCH(hits, _IntersectSphereByRays, sphere, src, dst, i, count, t);
+
+			return hits + _IntersectSphereByRaysScalar(sphere, src, dst, i, count, t);
+		}
+	}
+}
@@ -0,0 +1,47 @@
+/* Copyright (C) 2009-2020, Nick Galko Ltd. All rights reserved.
+*
+* This file is part of the NGTech (https://galek.github.io/portfolio/).
+*
+* Your use and or redistribution of this software in source and / or
+* binary form, with or without modification, is subject to: (i) your
+* ongoing acceptance of and compliance with the terms and conditions of
+* the NGTech License Agreement; and (ii) your inclusion of this notice
+* in any version of this software that you use or redistribute.
+* A copy of the NGTech License Agreement is available by contacting
+* Nick Galko Ltd. at https://galek.github.io/portfolio/
+*/
+#pragma once
+
+//***************************************************************************
+#include "MathLib.h"
+//***************************************************************************
+
+namespace NGTech
+{
+	class Vec3SoA;
+	class BSphere;
+
+	namespace Utils
+	{
+		/**
+		Closest hit of the segment src-dst with count triangles stored as 3 consecutive vertices each,
+		4 (SSE4.1) or 8 (AVX2) triangles per iteration. Same test as Math::intersectTriangleByRay,
+		equally close hits go to the lower index.
+		*/
+		bool IntersectTrianglesByRay(const Vec3* triangles, size_t count, const Vec3& src, const Vec3& dst,
+			size_t& index, float& t, float& u, float& v);
+
+		/**
+		Closest hit of the segment src-dst with centers.Size() spheres, same test as BSphere::IntersectsRay.
+		Square roots are only taken for the blocks of 4 (SSE4.1) or 8 (AVX2) spheres that have a hit
+		closer than the best one so far, equally close hits go to the lower index.
+		*/
+		bool IntersectSpheresByRay(const Vec3SoA& centers, const float* radii, const Vec3& src, const Vec3& dst,
+			size_t& index, float& t);
+		/**
+		Segments src[i]-dst[i] against one sphere. t[i] is the hit t or -1 for a miss,
+		returns the number of hits
+		*/
+		size_t IntersectSphereByRays(const BSphere& sphere, const Vec3SoA& src, const Vec3SoA& dst, float* t);
+	}
+}
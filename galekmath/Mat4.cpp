@@ -12,6 +12,7 @@
 */
 //***************************************************************************
 #include "MathLib.h"
+#include "SIMD.h"
 //***************************************************************************
 
 namespace NGTech
@@ -40,12 +41,6 @@ namespace NGTech
 		0, 0, 0, 1);
 
 	/**/
-	Mat4::Mat4() {
-		Identity();
-	}
-
-	Mat4::~Mat4() {}
-
 	void Mat4::Identity() {
 		e[0] = Math::ONEFLOAT; e[4] = Math::ZEROFLOAT; e[8] = Math::ZEROFLOAT; e[12] = Math::ZEROFLOAT;
 		e[1] = Math::ZEROFLOAT; e[5] = Math::ONEFLOAT; e[9] = Math::ZEROFLOAT; e[13] = Math::ZEROFLOAT;
@@ -60,23 +55,6 @@ namespace NGTech
 		e[3] = Math::ZEROFLOAT; e[7] = Math::ZEROFLOAT; e[11] = Math::ZEROFLOAT; e[15] = Math::ZEROFLOAT;
 	}
 
-	Mat4::Mat4(float e0, float e4, float e8, float e12,
-		float e1, float e5, float e9, float e13,
-		float e2, float e6, float e10, float e14,
-		float e3, float e7, float e11, float e15) {
-		e[0] = e0; e[4] = e4; e[8] = e8;  e[12] = e12;
-		e[1] = e1; e[5] = e5; e[9] = e9;  e[13] = e13;
-		e[2] = e2; e[6] = e6; e[10] = e10; e[14] = e14;
-		e[3] = e3; e[7] = e7; e[11] = e11; e[15] = e15;
-	}
-
-	Mat4::Mat4(const Mat4& in) {
-		e[0] = in.e[0]; e[4] = in.e[4]; e[8] = in.e[8];  e[12] = in.e[12];
-		e[1] = in.e[1]; e[5] = in.e[5]; e[9] = in.e[9];  e[13] = in.e[13];
-		e[2] = in.e[2]; e[6] = in.e[6]; e[10] = in.e[10]; e[14] = in.e[14];
-		e[3] = in.e[3]; e[7] = in.e[7]; e[11] = in.e[11]; e[15] = in.e[15];
-	}
-
 	Mat4::Mat4(const Mat3& in) {
 		e[0] = in.e[0]; e[4] = in.e[3]; e[8] = in.e[6];  e[12] = 0.0;
 		e[1] = in.e[1]; e[5] = in.e[4]; e[9] = in.e[7];  e[13] = 0.0;
@@ -84,14 +62,6 @@ namespace NGTech
 		e[3] = 0.0;  e[7] = 0.0;  e[11] = 0.0;  e[15] = 1.0;
 	}
 
-	Mat4& Mat4::operator=(const Mat4& in) {
-		e[0] = in.e[0]; e[4] = in.e[4]; e[8] = in.e[8];  e[12] = in.e[12];
-		e[1] = in.e[1]; e[5] = in.e[5]; e[9] = in.e[9];  e[13] = in.e[13];
-		e[2] = in.e[2]; e[6] = in.e[6]; e[10] = in.e[10]; e[14] = in.e[14];
-		e[3] = in.e[3]; e[7] = in.e[7]; e[11] = in.e[11]; e[15] = in.e[15];
-		return *this;
-	}
-
 	Mat4& Mat4::operator*=(const Mat4& in) {
 		*this = *this * in;
 		return *this;
@@ -143,7 +113,125 @@ namespace NGTech
 			m.e[12], m.e[13], m.e[14], m.e[15]);
 	}
 
-	Mat4 Mat4::inverse(const Mat4& m) {
+	Mat4 Mat4::inverse(const Mat4& m, InverseType* used) {
+		if (m.IsAffine()) {
+			if (used) *used = INVERSE_AFFINE;
+			return inverseAffine(m);
+		}
+
+		if (used) *used = INVERSE_GENERAL;
+		return inverseGeneral(m);
+	}
+
+	/*
+	Columns a, b, c, d of the matrix are split to 3D part and bottom row x, y, z, w:
+	s = a ^ b, t = c ^ d, u = a * y - b * x, v = c * w - d * z, det = s | v + t | u
+	and the rows of the inverse are built from them
+	(E. Lengyel, Foundations of Game Engine Development, Vol. 1).
+	*/
+	static void _InverseScalar(float* r, const float* m) {
+		Vec3 a(m[0], m[1], m[2]), b(m[4], m[5], m[6]), c(m[8], m[9], m[10]), d(m[12], m[13], m[14]);
+		float x = m[3], y = m[7], z = m[11], w = m[15];
+
+		Vec3 s = Vec3::cross(a, b);
+		Vec3 t = Vec3::cross(c, d);
+		Vec3 u = a * y - b * x;
+		Vec3 v = c * w - d * z;
+
+		float invDet = Math::ONEFLOAT / (Vec3::dot(s, v) + Vec3::dot(t, u));
+		s *= invDet;
+		t *= invDet;
+		u *= invDet;
+		v *= invDet;
+
+		Vec3 r0 = Vec3::cross(b, v) + t * y;
+		Vec3 r1 = Vec3::cross(v, a) - t * x;
+		Vec3 r2 = Vec3::cross(d, u) + s * w;
+		Vec3 r3 = Vec3::cross(u, c) - s * z;
+
+		r[0] = r0.x; r[4] = r0.y; r[8] = r0.z;  r[12] = -Vec3::dot(b, t);
+		r[1] = r1.x; r[5] = r1.y; r[9] = r1.z;  r[13] = Vec3::dot(a, t);
+		r[2] = r2.x; r[6] = r2.y; r[10] = r2.z; r[14] = -Vec3::dot(d, s);
+		r[3] = r3.x; r[7] = r3.y; r[11] = r3.z; r[15] = Vec3::dot(c, s);
+	}
+
+#if MATH_SIMD_X86
+	/*
+	Same algorithm as _InverseScalar, one column per register
+	*/
+	ENGINE_TARGET_SSE41 static void _InverseSSE41(float* r, const float* m) {
+		__m128 a = _mm_loadu_ps(m + 0);
+		__m128 b = _mm_loadu_ps(m + 4);
+		__m128 c = _mm_loadu_ps(m + 8);
+		__m128 d = _mm_loadu_ps(m + 12);
+
+		__m128 x = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 3));
+		__m128 y = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 3, 3, 3));
+		__m128 z = _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 3, 3));
+		__m128 w = _mm_shuffle_ps(d, d, _MM_SHUFFLE(3, 3, 3, 3));
+
+		__m128 s = SIMD::Cross3(a, b);
+		__m128 t = SIMD::Cross3(c, d);
+		__m128 u = _mm_sub_ps(_mm_mul_ps(a, y), _mm_mul_ps(b, x));
+		__m128 v = _mm_sub_ps(_mm_mul_ps(c, w), _mm_mul_ps(d, z));
+
+		// 0x7F: dot of xyz, broadcast to all lanes
+		__m128 det = _mm_add_ps(_mm_dp_ps(s, v, 0x7F), _mm_dp_ps(t, u, 0x7F));
+		__m128 invDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+		s = _mm_mul_ps(s, invDet);
+		t = _mm_mul_ps(t, invDet);
+		u = _mm_mul_ps(u, invDet);
+		v = _mm_mul_ps(v, invDet);
+
+		__m128 r0 = _mm_add_ps(SIMD::Cross3(b, v), _mm_mul_ps(t, y));
+		__m128 r1 = _mm_sub_ps(SIMD::Cross3(v, a), _mm_mul_ps(t, x));
+		__m128 r2 = _mm_add_ps(SIMD::Cross3(d, u), _mm_mul_ps(s, w));
+		__m128 r3 = _mm_sub_ps(SIMD::Cross3(u, c), _mm_mul_ps(s, z));
+
+		__m128 zero = _mm_setzero_ps();
+		r0 = _mm_blend_ps(r0, _mm_sub_ps(zero, _mm_dp_ps(b, t, 0x7F)), 0x8);
+		r1 = _mm_blend_ps(r1, _mm_dp_ps(a, t, 0x7F), 0x8);
+		r2 = _mm_blend_ps(r2, _mm_sub_ps(zero, _mm_dp_ps(d, s, 0x7F)), 0x8);
+		r3 = _mm_blend_ps(r3, _mm_dp_ps(c, s, 0x7F), 0x8);
+
+		// r0..r3 are rows, storage is column-major
+		_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+		_mm_storeu_ps(r + 0, r0);
+		_mm_storeu_ps(r + 4, r1);
+		_mm_storeu_ps(r + 8, r2);
+		_mm_storeu_ps(r + 12, r3);
+	}
+#endif
+
+	Mat4 Mat4::inverseGeneral(const Mat4& m) {
+		Mat4 iMat;
+
+		switch (SIMD::GetLevel())
+		{
+#if MATH_SIMD_X86
+		case SIMD::LEVEL_AVX2:
+		case SIMD::LEVEL_SSE41: _InverseSSE41(iMat.e, m.e); break;
+#endif
+		default: _InverseScalar(iMat.e, m.e); break;
+		}
+
+		return iMat;
+	}
+
+	Mat4 Mat4::inverseRigid(const Mat4& m) {
+		Mat4 iMat(m.e[0], m.e[1], m.e[2], 0,
+			m.e[4], m.e[5], m.e[6], 0,
+			m.e[8], m.e[9], m.e[10], 0,
+			0, 0, 0, 1);
+
+		iMat.e[12] = -(m.e[12] * iMat.e[0] + m.e[13] * iMat.e[4] + m.e[14] * iMat.e[8]);
+		iMat.e[13] = -(m.e[12] * iMat.e[1] + m.e[13] * iMat.e[5] + m.e[14] * iMat.e[9]);
+		iMat.e[14] = -(m.e[12] * iMat.e[2] + m.e[13] * iMat.e[6] + m.e[14] * iMat.e[10]);
+
+		return iMat;
+	}
+
+	Mat4 Mat4::inverseAffine(const Mat4& m) {
 		Mat4 iMat = m;
 
 		float iDet = Math::ONEFLOAT / iMat.getDeterminant();
@@ -171,17 +259,9 @@ namespace NGTech
 		return iMat;
 	}
 
-	Mat4 Mat4::translate(const Vec3& trans) {
-		Mat4 out;
-		out.e[12] = trans.x;
-		out.e[13] = trans.y;
-		out.e[14] = trans.z;
-		return out;
-	}
-
 	Mat4 Mat4::rotate(float angle, const Vec3& axis) {
-		float s = sinf(Math::DegreesToRadians(angle));
-		float c = cosf(Math::DegreesToRadians(angle));
+		float s, c;
+		Math::SinCos(Math::DegreesToRadians(angle), s, c);
 
 		Mat4 rMat;
 
@@ -195,13 +275,13 @@ namespace NGTech
 		rMat.e[3] = 0;
 
 		rMat.e[4] = (1 - c) * uy * ux - s * uz;
-		rMat.e[5] = c + (1 - c) * pow(uy, 2);
+		rMat.e[5] = c + (1 - c) * uy * uy;
 		rMat.e[6] = (1 - c) * uy * uz + s * ux;
 		rMat.e[7] = 0;
 
 		rMat.e[8] = (1 - c) * uz * ux + s * uy;
 		rMat.e[9] = (1 - c) * uz * uz - s * ux;
-		rMat.e[10] = c + (1 - c) * pow(uz, 2);
+		rMat.e[10] = c + (1 - c) * uz * uz;
 		rMat.e[11] = 0;
 
 		rMat.e[12] = 0;
@@ -212,14 +292,6 @@ namespace NGTech
 		return rMat;
 	}
 
-	Mat4 Mat4::scale(const Vec3& scale) {
-		Mat4 out;
-		out.e[0] = scale.x;
-		out.e[5] = scale.y;
-		out.e[10] = scale.z;
-		return out;
-	}
-
 	Mat4 Mat4::lookAt(const Vec3& eye, const Vec3& center, const Vec3& up) {
 		Mat4 out;
 		Vec3 x, y, z;
@@ -244,16 +316,16 @@ namespace NGTech
 
 	Mat4 Mat4::perspective(float fovy, float aspect, float n, float f) {
 		Mat4 out;
-		float sine, cotangent, delta_z;
+		float sine, cosine, cotangent, delta_z;
 		float radians = (fovy / 2.0f) * (M_PI / 180.0f);
 
 		delta_z = f - n;
-		sine = sinf(radians);
+		Math::SinCos(radians, sine, cosine);
 		if ((delta_z == 0) || (sine == 0) || (aspect == 0)) {
 			out.Identity();
 			return out;
 		}
-		cotangent = cosf(radians) / sine;
+		cotangent = cosine / sine;
 
 		out.Identity();
 		out.e[0] = cotangent / aspect;
@@ -265,20 +337,6 @@ namespace NGTech
 		return out;
 	}
 
-	Mat4 Mat4::ortho(float left, float right, float bottom, float top, float n, float f) {
-		Mat4 out;
-		out.e[0] = 2.0f / (right - left);
-
-		out.e[5] = 2.0f / (top - bottom);
-
-		out.e[10] = -2.0f / (f - n);
-
-		out.e[12] = -(right + left) / (right - left);
-		out.e[13] = -(top + bottom) / (top - bottom);
-		out.e[14] = -(f + n) / (f - n);
-		return out;
-	}
-
 	Mat4 Mat4::reflect(const Vec4& plane) {
 		Mat4 out;
 		float x = plane.x;
@@ -365,29 +423,57 @@ namespace NGTech
 	}
 
 	/*Arithmetic operators*/
-	Mat4 Mat4::operator*(const Mat4& b) const {
-		Mat4 result;
 
-		const Mat4& a = *this;
-		result.e[0] = (a.e[0] * b.e[0]) + (a.e[4] * b.e[1]) + (a.e[8] * b.e[2]) + (a.e[12] * b.e[3]);
-		result.e[1] = (a.e[1] * b.e[0]) + (a.e[5] * b.e[1]) + (a.e[9] * b.e[2]) + (a.e[13] * b.e[3]);
-		result.e[2] = (a.e[2] * b.e[0]) + (a.e[6] * b.e[1]) + (a.e[10] * b.e[2]) + (a.e[14] * b.e[3]);
-		result.e[3] = (a.e[3] * b.e[0]) + (a.e[7] * b.e[1]) + (a.e[11] * b.e[2]) + (a.e[15] * b.e[3]);
+	/*
+	Reference code, used when CPU has no SSE4.1.
+	Matrices are column-major: e[column * 4 + row]
+	*/
+	static void _MulMat4Scalar(float* r, const float* a, const float* b) {
+		for (int c = 0; c < 16; c += 4) {
+			r[c + 0] = (a[0] * b[c]) + (a[4] * b[c + 1]) + (a[8] * b[c + 2]) + (a[12] * b[c + 3]);
+			r[c + 1] = (a[1] * b[c]) + (a[5] * b[c + 1]) + (a[9] * b[c + 2]) + (a[13] * b[c + 3]);
+			r[c + 2] = (a[2] * b[c]) + (a[6] * b[c + 1]) + (a[10] * b[c + 2]) + (a[14] * b[c + 3]);
+			r[c + 3] = (a[3] * b[c]) + (a[7] * b[c + 1]) + (a[11] * b[c + 2]) + (a[15] * b[c + 3]);
+		}
+	}
+
+	static void _MulVec4Scalar(float* r, const float* m, const float* v) {
+		r[0] = m[0] * v[0] + m[4] * v[1] + m[8] * v[2] + m[12] * v[3];
+		r[1] = m[1] * v[0] + m[5] * v[1] + m[9] * v[2] + m[13] * v[3];
+		r[2] = m[2] * v[0] + m[6] * v[1] + m[10] * v[2] + m[14] * v[3];
+		r[3] = m[3] * v[0] + m[7] * v[1] + m[11] * v[2] + m[15] * v[3];
+	}
+
+#if MATH_SIMD_X86
+	ENGINE_TARGET_SSE41 static void _MulVec4SSE41(float* r, const float* m, const float* v) {
+		__m128 vv = _mm_loadu_ps(v);
+		__m128 res = _mm_mul_ps(_mm_loadu_ps(m + 0), _mm_shuffle_ps(vv, vv, _MM_SHUFFLE(0, 0, 0, 0)));
+		res = _mm_add_ps(res, _mm_mul_ps(_mm_loadu_ps(m + 4), _mm_shuffle_ps(vv, vv, _MM_SHUFFLE(1, 1, 1, 1))));
+		res = _mm_add_ps(res, _mm_mul_ps(_mm_loadu_ps(m + 8), _mm_shuffle_ps(vv, vv, _MM_SHUFFLE(2, 2, 2, 2))));
+		res = _mm_add_ps(res, _mm_mul_ps(_mm_loadu_ps(m + 12), _mm_shuffle_ps(vv, vv, _MM_SHUFFLE(3, 3, 3, 3))));
+		_mm_storeu_ps(r, res);
+	}
 
-		result.e[4] = (a.e[0] * b.e[4]) + (a.e[4] * b.e[5]) + (a.e[8] * b.e[6]) + (a.e[12] * b.e[7]);
-		result.e[5] = (a.e[1] * b.e[4]) + (a.e[5] * b.e[5]) + (a.e[9] * b.e[6]) + (a.e[13] * b.e[7]);
-		result.e[6] = (a.e[2] * b.e[4]) + (a.e[6] * b.e[5]) + (a.e[10] * b.e[6]) + (a.e[14] * b.e[7]);
-		result.e[7] = (a.e[3] * b.e[4]) + (a.e[7] * b.e[5]) + (a.e[11] * b.e[6]) + (a.e[15] * b.e[7]);
+	ENGINE_TARGET_AVX2 static void _MulVec4AVX2(float* r, const float* m, const float* v) {
+		__m128 res = _mm_mul_ps(_mm_loadu_ps(m + 0), _mm_broadcast_ss(v + 0));
+		res = _mm_fmadd_ps(_mm_loadu_ps(m + 4), _mm_broadcast_ss(v + 1), res);
+		res = _mm_fmadd_ps(_mm_loadu_ps(m + 8), _mm_broadcast_ss(v + 2), res);
+		res = _mm_fmadd_ps(_mm_loadu_ps(m + 12), _mm_broadcast_ss(v + 3), res);
+		_mm_storeu_ps(r, res);
+	}
+#endif
 
-		result.e[8] = (a.e[0] * b.e[8]) + (a.e[4] * b.e[9]) + (a.e[8] * b.e[10]) + (a.e[12] * b.e[11]);
-		result.e[9] = (a.e[1] * b.e[8]) + (a.e[5] * b.e[9]) + (a.e[9] * b.e[10]) + (a.e[13] * b.e[11]);
-		result.e[10] = (a.e[2] * b.e[8]) + (a.e[6] * b.e[9]) + (a.e[10] * b.e[10]) + (a.e[14] * b.e[11]);
-		result.e[11] = (a.e[3] * b.e[8]) + (a.e[7] * b.e[9]) + (a.e[11] * b.e[10]) + (a.e[15] * b.e[11]);
+	Mat4 Mat4::operator*(const Mat4& b) const {
+		Mat4 result;
 
-		result.e[12] = (a.e[0] * b.e[12]) + (a.e[4] * b.e[13]) + (a.e[8] * b.e[14]) + (a.e[12] * b.e[15]);
-		result.e[13] = (a.e[1] * b.e[12]) + (a.e[5] * b.e[13]) + (a.e[9] * b.e[14]) + (a.e[13] * b.e[15]);
-		result.e[14] = (a.e[2] * b.e[12]) + (a.e[6] * b.e[13]) + (a.e[10] * b.e[14]) + (a.e[14] * b.e[15]);
-		result.e[15] = (a.e[3] * b.e[12]) + (a.e[7] * b.e[13]) + (a.e[11] * b.e[14]) + (a.e[15] * b.e[15]);
+		switch (SIMD::GetLevel())
+		{
+#if MATH_SIMD_X86
+		case SIMD::LEVEL_AVX2: SIMD::MulMat4AVX2(result.e, e, b.e); break;
+		case SIMD::LEVEL_SSE41: SIMD::MulMat4SSE41(result.e, e, b.e); break;
+#endif
+		default: _MulMat4Scalar(result.e, e, b.e); break;
+		}
 
 		return result;
 	}
@@ -395,11 +481,15 @@ namespace NGTech
 	Vec4 Mat4::operator*(const Vec4& v) const {
 		Vec4 result;
 
-		const Mat4& m = *this;
-		result.x = m.e[0] * v.x + m.e[4] * v.y + m.e[8] * v.z + m.e[12] * v.w;
-		result.y = m.e[1] * v.x + m.e[5] * v.y + m.e[9] * v.z + m.e[13] * v.w;
-		result.z = m.e[2] * v.x + m.e[6] * v.y + m.e[10] * v.z + m.e[14] * v.w;
-		result.w = m.e[3] * v.x + m.e[7] * v.y + m.e[11] * v.z + m.e[15] * v.w;
+		switch (SIMD::GetLevel())
+		{
+#if MATH_SIMD_X86
+		case SIMD::LEVEL_AVX2: _MulVec4AVX2(result.f, e, v.f); break;
+		case SIMD::LEVEL_SSE41: _MulVec4SSE41(result.f, e, v.f); break;
+#endif
+		default: _MulVec4Scalar(result.f, e, v.f); break;
+		}
+
 		return result;
 	}
 
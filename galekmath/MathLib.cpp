@@ -33,7 +33,7 @@ namespace NGTech {
 		float dot = Vec3::dot(va, vb);
 		float length = va.length() * vb.length();
 
-		float angle = acos(dot / length);
+		float angle = Math::ACos(dot / length);
 
 		if (angle < EPSILON)
 			return Math::ZEROFLOAT;
@@ -100,39 +100,83 @@ namespace NGTech {
 		return false;
 	}
 
+	/*
+	Moller-Trumbore without the range check of t, the barycentric tests also reject NaN
+	*/
+	static ENGINE_INLINE bool _IntersectTriangle(const Vec3& v0, const Vec3& v1, const Vec3& v2, const Vec3& src, const Vec3& dir, float& t, float& u, float& v) {
+		Vec3 e1 = v1 - v0;
+		Vec3 e2 = v2 - v0;
+		Vec3 p = Vec3::cross(dir, e2);
+		float det = Vec3::dot(e1, p);
+		if (det == 0)
+			return false;
+
+		float invDet = Math::ONEFLOAT / det;
+		Vec3 s = src - v0;
+		u = Vec3::dot(s, p) * invDet;
+		if (!(u >= 0 && u <= 1))
+			return false;
+
+		Vec3 q = Vec3::cross(s, e1);
+		v = Vec3::dot(dir, q) * invDet;
+		if (!(v >= 0 && u + v <= 1))
+			return false;
+
+		t = Vec3::dot(e2, q) * invDet;
+		return true;
+	}
+
+	/*
+	src must be in front of the triangle (same side test as intersectPlaneByRay), the hit
+	may be anywhere on the ray from src through dst
+	*/
 	bool Math::intersectPolygonByRay(const Vec3& v0, const Vec3& v1, const Vec3& v2, const Vec3& src, const Vec3& dst, Vec3& point) {
-		if (!intersectPlaneByRay(v0, v1, v2, src, dst, point))
+		Vec3 normal;
+		TBNComputer::computeN(normal, v0, v1, v2);
+		float distance = -((normal.x * v0.x) + (normal.y * v0.y) + (normal.z * v0.z));
+
+		if (((normal.x * src.x) + (normal.y * src.y) + (normal.z * src.z)) + distance <= Math::ZERODELTA)
 			return false;
 
-		if (insidePolygon(v0, v1, v2, point))
-			return true;
+		Vec3 dir = dst - src;
+		float t, u, v;
+		if (!_IntersectTriangle(v0, v1, v2, src, dir, t, u, v) || !(t >= 0))
+			return false;
 
-		return false;
+		point = src + dir * t;
+		return true;
+	}
+
+	bool Math::intersectTriangleByRay(const Vec3& v0, const Vec3& v1, const Vec3& v2, const Vec3& src, const Vec3& dst, float& t, float& u, float& v) {
+		return intersectTriangleBySegment(v0, v1, v2, src, dst - src, Math::ONEFLOAT, t, u, v);
+	}
+
+	bool Math::intersectTriangleBySegment(const Vec3& v0, const Vec3& v1, const Vec3& v2, const Vec3& src, const Vec3& dir, float tMax, float& t, float& u, float& v) {
+		return _IntersectTriangle(v0, v1, v2, src, dir, t, u, v) && t >= 0 && t <= tMax;
 	}
 
 	bool Math::intersectSphereByRay(const Vec3& center, float radius, const Vec3& src, const Vec3& dst) {
 		Vec3 v1 = center - src;
-		Vec3 v2 = Vec3::normalize(dst - src);
+		Vec3 dir = dst - src;
 
-		float t = Vec3::dot(v2, v1);
+		float t = Vec3::dot(dir, v1);
+		float dist2 = Vec3::dot(v1, v1);
+		float radius2 = radius * radius;
 
-		if (t <= 0 && (center - src).length() > radius)
+		if (t <= 0 && dist2 > radius2)
 			return false;
 
-		Vec3 v3 = v2 * t;
-		Vec3 cp = src + v3;
+		// src == dst is a point, it hits when it is inside
+		float length2 = Vec3::dot(dir, dir);
+		if (length2 == 0)
+			return dist2 < radius2;
 
-		return (cp - center).length() < radius;
+		// squared distance from the center to the line is dist2 - t^2 / |dir|^2
+		return dist2 * length2 - t * t < radius2 * length2;
 	}
 
 	/*
 	*/
-	Mat3::Mat3() {
-		Identity();
-	}
-
-	Mat3::~Mat3() {}
-
 	void Mat3::Identity() {
 		e[0] = Math::ONEFLOAT; e[3] = Math::ZEROFLOAT; e[6] = Math::ZEROFLOAT;
 		e[1] = Math::ZEROFLOAT; e[4] = Math::ONEFLOAT; e[7] = Math::ZEROFLOAT;
@@ -145,33 +189,12 @@ namespace NGTech {
 		e[2] = Math::ZEROFLOAT; e[5] = Math::ZEROFLOAT; e[8] = Math::ZEROFLOAT;
 	}
 
-	Mat3::Mat3(float e0, float e3, float e6,
-		float e1, float e4, float e7,
-		float e2, float e5, float e8) {
-		e[0] = e0; e[3] = e3; e[6] = e6;
-		e[1] = e1; e[4] = e4; e[7] = e7;
-		e[2] = e2; e[5] = e5; e[8] = e8;
-	}
-
-	Mat3::Mat3(const Mat3& in) {
-		e[0] = in.e[0]; e[3] = in.e[3]; e[6] = in.e[6];
-		e[1] = in.e[1]; e[4] = in.e[4]; e[7] = in.e[7];
-		e[2] = in.e[2]; e[5] = in.e[5]; e[8] = in.e[8];
-	}
-
 	Mat3::Mat3(const Mat4& in) {
 		e[0] = in.e[0]; e[3] = in.e[4]; e[6] = in.e[8];
 		e[1] = in.e[1]; e[4] = in.e[5]; e[7] = in.e[9];
 		e[2] = in.e[2]; e[5] = in.e[6]; e[8] = in.e[10];
 	}
 
-	Mat3& Mat3::operator=(const Mat3& in) {
-		e[0] = in.e[0]; e[3] = in.e[3]; e[6] = in.e[6];
-		e[1] = in.e[1]; e[4] = in.e[4]; e[7] = in.e[7];
-		e[2] = in.e[2]; e[5] = in.e[5]; e[8] = in.e[8];
-		return *this;
-	}
-
 	Mat3& Mat3::operator*=(const Mat3& in) {
 		*this = *this * in;
 		return *this;
@@ -228,8 +251,8 @@ namespace NGTech {
 	}
 
 	Mat3 Mat3::rotate(float angle, const Vec3& axis) {
-		float s = sinf(Math::DegreesToRadians(angle));
-		float c = cosf(Math::DegreesToRadians(angle));
+		float s, c;
+		Math::SinCos(Math::DegreesToRadians(angle), s, c);
 
 		Mat3 rMat;
 
@@ -16,11 +16,23 @@
 //***************************************************************************
 #include <math.h>
 #include <limits>
+#include <type_traits>
 #undef max
 #undef min
 #include <float.h>
 //***************************************************************************
 
+/*
+Small Vec2/Vec3/Vec4/Quat functions are defined in Vec*.inl/Quat.inl.
+With GALEKMATH_HEADER_ONLY they are inline and included at the end of this file,
+otherwise they are compiled once into the library by Vec*.cpp/Quat.cpp.
+*/
+#if GALEKMATH_HEADER_ONLY
+#define MATH_HEADER_INLINE ENGINE_INLINE
+#else
+#define MATH_HEADER_INLINE
+#endif
+
 namespace NGTech {
 	static const float M_PI = 3.14159265358979323846f;
 	static const float TWOPI = 1.57079632679489f;
@@ -33,6 +45,7 @@ namespace NGTech {
 	class Vec3;
 	class Vec4;
 	class Mat4;
+	class Quat;
 
 	/**
 	Some math functions
@@ -58,7 +71,19 @@ namespace NGTech {
 		static bool insidePolygon(const Vec3& v0, const Vec3& v1, const Vec3& v2, const Vec3& point);
 		static bool intersectPlaneByRay(const Vec3& v0, const Vec3& v1, const Vec3& v2, const Vec3& src, const Vec3& dst, Vec3& point);
 		static bool intersectPolygonByRay(const Vec3& v0, const Vec3& v1, const Vec3& v2, const Vec3& src, const Vec3& dst, Vec3& point);
+		/**
+		Ray from src through dst, src == dst hits when the point is inside the sphere
+		*/
 		static bool intersectSphereByRay(const Vec3& center, float radius, const Vec3& src, const Vec3& dst);
+		/**
+		Moller-Trumbore test of the segment src-dst against a two-sided triangle.
+		Hit point is src + (dst - src) * t = v0 * (1 - u - v) + v1 * u + v2 * v, t in [0, 1]
+		*/
+		static bool intersectTriangleByRay(const Vec3& v0, const Vec3& v1, const Vec3& v2, const Vec3& src, const Vec3& dst, float& t, float& u, float& v);
+		/**
+		Same test for the segment src + dir * t, t in [0, tMax]
+		*/
+		static bool intersectTriangleBySegment(const Vec3& v0, const Vec3& v1, const Vec3& v2, const Vec3& src, const Vec3& dir, float tMax, float& t, float& u, float& v);
 
 		template<typename type>
 		static ENGINE_INLINE type DegreesToRadians(type value) {
@@ -105,6 +130,69 @@ namespace NGTech {
 					std::numeric_limits<t2>::epsilon());
 		};
 
+		/**
+		Polynomial approximations of libm functions (Cephes single precision), for one value
+		or over arrays with SSE4.1/AVX2 kernels. Max errors against the double precision libm:
+		sin/cos/sincos: 2 ulp for |x| < 8192, absolute error 1e-7 near the zeros
+		acos: 2 ulp, atan2: 4 ulp, rsqrt: 4 ulp (0 gives inf, inf gives 0),
+		exp2: 2 ulp for x in [-126, 128), log2: 2 ulp for positive normal x
+		*/
+		struct Fast
+		{
+			static void sincos(float x, float& s, float& c);
+			static float sin(float x);
+			static float cos(float x);
+			/**
+			|x| > 1 is clamped
+			*/
+			static float acos(float x);
+			static float atan2(float y, float x);
+			static float rsqrt(float x);
+			static float exp2(float x);
+			/**
+			x must be a positive normal number
+			*/
+			static float log2(float x);
+
+			/**
+			Same over arrays, out may be the same array as in
+			*/
+			static void sincos(const float* in, float* s, float* c, size_t count);
+			static void acos(const float* in, float* out, size_t count);
+			static void atan2(const float* y, const float* x, float* out, size_t count);
+			static void rsqrt(const float* in, float* out, size_t count);
+			static void exp2(const float* in, float* out, size_t count);
+			static void log2(const float* in, float* out, size_t count);
+		};
+
+		/**
+		Used by the library itself: libm, or Math::Fast when GALEKMATH_FAST_MATH is defined
+		*/
+		static ENGINE_INLINE void SinCos(float x, float& s, float& c) {
+#if GALEKMATH_FAST_MATH
+			Fast::sincos(x, s, c);
+#else
+			s = ::sinf(x);
+			c = ::cosf(x);
+#endif
+		}
+
+		static ENGINE_INLINE float Sin(float x) {
+#if GALEKMATH_FAST_MATH
+			return Fast::sin(x);
+#else
+			return ::sinf(x);
+#endif
+		}
+
+		static ENGINE_INLINE float ACos(float x) {
+#if GALEKMATH_FAST_MATH
+			return Fast::acos(x);
+#else
+			return ::acosf(x);
+#endif
+		}
+
 		// Constatns
 		static const float ZEROFLOAT;
 		static const float ONEFLOAT;
@@ -134,10 +222,8 @@ namespace NGTech {
 			float f[2];
 		};
 
-		Vec2();
-		~Vec2();
-		Vec2(float cx, float cy);
-		Vec2(const Vec2& in);
+		constexpr Vec2() : x(0), y(0) {}
+		constexpr Vec2(float cx, float cy) : x(cx), y(cy) {}
 		Vec2(const Vec3& in);
 		Vec2(const Vec4& in);
 		Vec2(const float* ar)
@@ -147,8 +233,6 @@ namespace NGTech {
 			y = ar[1];
 		}
 
-		Vec2& operator=(const Vec2& in);
-
 		float& operator[](intptr_t index);
 		float operator[](intptr_t index) const;
 
@@ -245,11 +329,9 @@ namespace NGTech {
 			float f[3];
 		};
 
-		Vec3();
-		~Vec3();
-		Vec3(float cx, float cy, float cz);
+		constexpr Vec3() : x(0), y(0), z(0) {}
+		constexpr Vec3(float cx, float cy, float cz) : x(cx), y(cy), z(cz) {}
 		Vec3(const Vec2& in);
-		Vec3(const Vec3& in);
 		Vec3(const Vec4& in);
 		Vec3(const float* ar)
 		{
@@ -259,8 +341,6 @@ namespace NGTech {
 			z = ar[2];
 		}
 
-		Vec3& operator=(const Vec3& in);
-
 		//!@todo ��� ��������� �������� ����������� - ��� ������ ���������� �������� �� �������?! - ���������� ��� ���� ���������
 		float& operator[](intptr_t index);
 		float operator[](intptr_t index) const;
@@ -436,20 +516,17 @@ namespace NGTech {
 			float f[4];
 		};
 
-		Vec4();
-		~Vec4();
-		Vec4(float cx, float cy, float cz, float cw);
+		constexpr Vec4() : x(0), y(0), z(0), w(0) {}
+		constexpr Vec4(float cx, float cy, float cz, float cw) : x(cx), y(cy), z(cz), w(cw) {}
 		Vec4(const Vec2& in);
 		Vec4(const Vec3& in);
 		Vec4(const Vec3& in, float cw);
-		Vec4(const Vec4& in);
 		Vec4(const float* ar)
 		{
 			ASSERT(ar, "Vec4] INVALID POINTER");
 			x = ar[0]; y = ar[1]; z = ar[2]; w = ar[3];
 		}
 
-		Vec4& operator=(const Vec4& in);
 		float& operator[](intptr_t index);
 		float operator[](intptr_t index) const;
 
@@ -655,20 +732,18 @@ namespace NGTech {
 	public:
 		float e[9];
 
-		Mat3();
-		~Mat3();
+		constexpr Mat3() : e{ 1, 0, 0, 0, 1, 0, 0, 0, 1 } {}
 
 		void Identity();
 		void SetZero();
 
-		Mat3(float e0, float e3, float e6,
+		constexpr Mat3(float e0, float e3, float e6,
 			float e1, float e4, float e7,
-			float e2, float e5, float e8);
+			float e2, float e5, float e8)
+			: e{ e0, e1, e2, e3, e4, e5, e6, e7, e8 } {}
 
-		Mat3(const Mat3& in);
 		Mat3(const Mat4& in);
 
-		Mat3& operator=(const Mat3& in);
 		Mat3& operator*=(const Mat3& in);
 
 		float& operator[](intptr_t index);
@@ -699,16 +774,14 @@ namespace NGTech {
 	*/
 	class Mat4 {
 	public:
-		Mat4();
-		~Mat4();
-		Mat4(float e0, float e4, float e8, float e12,
+		constexpr Mat4() : e{ 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 } {}
+		constexpr Mat4(float e0, float e4, float e8, float e12,
 			float e1, float e5, float e9, float e13,
 			float e2, float e6, float e10, float e14,
-			float e3, float e7, float e11, float e15);
-		Mat4(const Mat4& in);
+			float e3, float e7, float e11, float e15)
+			: e{ e0, e1, e2, e3, e4, e5, e6, e7, e8, e9, e10, e11, e12, e13, e14, e15 } {}
 		Mat4(const Mat3& in);
 
-		Mat4& operator=(const Mat4& in);
 		Mat4& operator*=(const Mat4& in);
 
 		float& operator[](intptr_t index);
@@ -739,18 +812,55 @@ namespace NGTech {
 		/*
 		*/
 		static Mat4 transpose(const Mat4& m);
-		static Mat4 inverse(const Mat4& m);
 
-		static Mat4 translate(const Vec3& trans);
+		enum InverseType
+		{
+			INVERSE_GENERAL,	// any invertible matrix
+			INVERSE_AFFINE,		// bottom row is 0, 0, 0, 1
+			INVERSE_RIGID		// rotation + translation only
+		};
+
+		/*
+		Picks inverseAffine when the bottom row is 0, 0, 0, 1 and inverseGeneral otherwise.
+		used (if not null) receives the path which was taken.
+		*/
+		static Mat4 inverse(const Mat4& m, InverseType* used = nullptr);
+		static Mat4 inverseGeneral(const Mat4& m);
+		static Mat4 inverseAffine(const Mat4& m);
+		/*
+		Upper 3x3 must be orthonormal, it is transposed
+		*/
+		static Mat4 inverseRigid(const Mat4& m);
+
+		ENGINE_INLINE bool IsAffine() const {
+			return e[3] == 0 && e[7] == 0 && e[11] == 0 && e[15] == 1;
+		}
+
+		static constexpr Mat4 translate(const Vec3& trans) {
+			return Mat4(1, 0, 0, trans.x,
+				0, 1, 0, trans.y,
+				0, 0, 1, trans.z,
+				0, 0, 0, 1);
+		}
 		/*
 		angle-can be only Degrees
 		*/
 		static Mat4 rotate(float degree, const Vec3& axis);
-		static Mat4 scale(const Vec3& scale);
+		static constexpr Mat4 scale(const Vec3& scale) {
+			return Mat4(scale.x, 0, 0, 0,
+				0, scale.y, 0, 0,
+				0, 0, scale.z, 0,
+				0, 0, 0, 1);
+		}
 		static Mat4 lookAt(const Vec3& eye, const Vec3& center, const Vec3& up);
 
 		static Mat4 perspective(float fovy, float aspect, float n, float f);
-		static Mat4 ortho(float left, float right, float bottom, float top, float n, float f);
+		static constexpr Mat4 ortho(float left, float right, float bottom, float top, float n, float f) {
+			return Mat4(2.0f / (right - left), 0, 0, -(right + left) / (right - left),
+				0, 2.0f / (top - bottom), 0, -(top + bottom) / (top - bottom),
+				0, 0, -2.0f / (f - n), -(f + n) / (f - n),
+				0, 0, 0, 1);
+		}
 
 		static Mat4 reflect(const Vec4& plane);
 		static Mat4 reflectProjection(const Mat4& proj, const Vec4& plane);
@@ -803,6 +913,38 @@ namespace NGTech {
 			out[2] = tmp[2] / tmp[3];
 		}
 
+		/**
+		Batch versions of Mat4 * Vec3 over contiguous arrays, in and out may be the same array.
+		TransformPoints uses w = 1, TransformVectors w = 0 (no translation),
+		TransformCoords w = 1 and divides by the resulting w like TransformCoord.
+		*/
+		void TransformPoints(const Mat4& m, const Vec3* in, Vec3* out, size_t count);
+		void TransformVectors(const Mat4& m, const Vec3* in, Vec3* out, size_t count);
+		void TransformCoords(const Mat4& m, const Vec3* in, Vec3* out, size_t count);
+
+		/**
+		Rotates the vectors by q, same result as q.toMatrix() * v. in and out may be the same array
+		*/
+		void RotateVectors(const Quat& q, const Vec3* in, Vec3* out, size_t count);
+
+		/**
+		Rotation matrices of the quaternions, and translate(translations[i]) * rotations[i] * scale(scales[i]).
+		scales may be nullptr
+		*/
+		void QuatToMat4(const Quat* in, Mat4* out, size_t count);
+		void QuatTRSToMat4(const Vec3* translations, const Quat* rotations, const Vec3* scales, Mat4* out, size_t count);
+
+		/**
+		Local to world matrices: world[i] = world[parents[i]] * local[i], roots (parents[i] < 0) copy local[i].
+		Parents must precede their children, local and world may be the same array.
+		Big arrays are split by root subtrees over the Parallel threads.
+		*/
+		void PropagateHierarchy(const Mat4* local, const int* parents, Mat4* world, size_t count);
+		/**
+		Same with local[i] = translate(translations[i]) * rotations[i] * scale(scales[i]), scales may be nullptr
+		*/
+		void PropagateHierarchy(const Vec3* translations, const Quat* rotations, const Vec3* scales, const int* parents, Mat4* world, size_t count);
+
 		/**
 		TODO: Maybe deprecated
 		*/
@@ -838,8 +980,8 @@ namespace NGTech {
 			float f[4];
 		};
 
-		Quat();
-		Quat(float _x, float _y, float _z, float _w);
+		constexpr Quat() : x(0), y(0), z(0), w(1) {}
+		constexpr Quat(float _x, float _y, float _z, float _w) : x(_x), y(_y), z(_z), w(_w) {}
 		Quat(float angle, const Vec3& axis);
 
 		Quat(const Mat3& in);
@@ -927,4 +1069,19 @@ namespace NGTech {
 	static_assert(sizeof(Mat3) == 9 * sizeof(float), "Invalid Mat3 padding!");
 	static_assert(sizeof(Mat4) == 16 * sizeof(float), "Invalid Mat4 padding!");
 	static_assert(sizeof(Quat) == 4 * sizeof(float), "Invalid Quat padding!");
-};
\ No newline at end of file
+
+	// Arrays of these types are copied with memcpy/memmove
+	static_assert(std::is_trivially_copyable<Vec2>::value, "Vec2 must be trivially copyable!");
+	static_assert(std::is_trivially_copyable<Vec3>::value, "Vec3 must be trivially copyable!");
+	static_assert(std::is_trivially_copyable<Vec4>::value, "Vec4 must be trivially copyable!");
+	static_assert(std::is_trivially_copyable<Mat3>::value, "Mat3 must be trivially copyable!");
+	static_assert(std::is_trivially_copyable<Mat4>::value, "Mat4 must be trivially copyable!");
+	static_assert(std::is_trivially_copyable<Quat>::value, "Quat must be trivially copyable!");
+};
+
+#if GALEKMATH_HEADER_ONLY
+#include "Vec2.inl"
+#include "Vec3.inl"
+#include "Vec4.inl"
+#include "Quat.inl"
+#endif
\ No newline at end of file
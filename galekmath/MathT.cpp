@@ -0,0 +1,204 @@
+/* Copyright (C) 2009-2020, Nick Galko Ltd. All rights reserved.
+*
+* This file is part of the NGTech (https://galek.github.io/portfolio/).
+*
+* Your use and or redistribution of this software in source and / or
+* binary form, with or without modification, is subject to: (i) your
+* ongoing acceptance of and compliance with the terms and conditions of
+* the NGTech License Agreement; and (ii) your inclusion of this notice
+* in any version of this software that you use or redistribute.
+* A copy of the NGTech License Agreement is available by contacting
+* Nick Galko Ltd. at https://galek.github.io/portfolio/
+*/
+//***************************************************************************
+#include "MathT.h"
+#include "SIMD.h"
+//***************************************************************************
+
+namespace NGTech
+{
+	/*
+	Reference code, same as Mat4. Matrices are column-major: e[column * 4 + row]
+	*/
+	template<typename T>
+	static void _MulMat4Scalar(T* r, const T* a, const T* b) {
+		for (int c = 0; c < 16; c += 4) {
+			r[c + 0] = (a[0] * b[c]) + (a[4] * b[c + 1]) + (a[8] * b[c + 2]) + (a[12] * b[c + 3]);
+			r[c + 1] = (a[1] * b[c]) + (a[5] * b[c + 1]) + (a[9] * b[c + 2]) + (a[13] * b[c + 3]);
+			r[c + 2] = (a[2] * b[c]) + (a[6] * b[c + 1]) + (a[10] * b[c + 2]) + (a[14] * b[c + 3]);
+			r[c + 3] = (a[3] * b[c]) + (a[7] * b[c + 1]) + (a[11] * b[c + 2]) + (a[15] * b[c + 3]);
+		}
+	}
+
+	static void _TransformScalar(const Mat4d& m, const Vec3d* in, Vec3d* out, size_t begin, size_t count, double w) {
+		for (size_t i = begin; i < count; i++) {
+			Vec3d v = in[i];
+			out[i] = Vec3d(m.e[0] * v.x + m.e[4] * v.y + m.e[8] * v.z + m.e[12] * w,
+				m.e[1] * v.x + m.e[5] * v.y + m.e[9] * v.z + m.e[13] * w,
+				m.e[2] * v.x + m.e[6] * v.y + m.e[10] * v.z + m.e[14] * w);
+		}
+	}
+
+	static void _ToRelativeScalar(const Vec3d* in, const Vec3d& origin, Vec3* out, size_t begin, size_t count) {
+		for (size_t i = begin; i < count; i++)
+			out[i] = Vec3(in[i] - origin);
+	}
+
+#if MATH_SIMD_X86
+	/*
+	A column of the result is a linear combination of the columns of A, one column per register
+	*/
+	ENGINE_TARGET_AVX2 static void _MulMat4dAVX2(double* r, const double* a, const double* b) {
+		__m256d a0 = _mm256_loadu_pd(a + 0);
+		__m256d a1 = _mm256_loadu_pd(a + 4);
+		__m256d a2 = _mm256_loadu_pd(a + 8);
+		__m256d a3 = _mm256_loadu_pd(a + 12);
+
+		for (int c = 0; c < 16; c += 4) {
+			__m256d col = _mm256_mul_pd(a0, _mm256_broadcast_sd(b + c + 0));
+			col = _mm256_fmadd_pd(a1, _mm256_broadcast_sd(b + c + 1), col);
+			col = _mm256_fmadd_pd(a2, _mm256_broadcast_sd(b + c + 2), col);
+			col = _mm256_fmadd_pd(a3, _mm256_broadcast_sd(b + c + 3), col);
+			_mm256_storeu_pd(r + c, col);
+		}
+	}
+
+	/*
+	4 packed Vec3d are a = (x0 y0 z0 x1), b = (y1 z1 x2 y2), c = (z2 x3 y3 z3)
+	*/
+	ENGINE_TARGET_AVX2 static ENGINE_INLINE void _Deinterleave(__m256d a, __m256d b, __m256d c, __m256d& x, __m256d& y, __m256d& z)
+	{
+		x = _mm256_permute4x64_pd(_mm256_blend_pd(_mm256_blend_pd(a, b, 0x4), c, 0x2), _MM_SHUFFLE(1, 2, 3, 0));
+		y = _mm256_permute4x64_pd(_mm256_blend_pd(_mm256_blend_pd(a, b, 0x9), c, 0x4), _MM_SHUFFLE(2, 3, 0, 1));
+		z = _mm256_permute4x64_pd(_mm256_blend_pd(_mm256_blend_pd(a, b, 0x2), c, 0x9), _MM_SHUFFLE(3, 0, 1, 2));
+	}
+
+	/*
+	Inverse of _Deinterleave, the permutations are their own inverses
+	*/
+	ENGINE_TARGET_AVX2 static ENGINE_INLINE void _Interleave(__m256d x, __m256d y, __m256d z, __m256d& a, __m256d& b, __m256d& c)
+	{
+		x = _mm256_permute4x64_pd(x, _MM_SHUFFLE(1, 2, 3, 0));
+		y = _mm256_permute4x64_pd(y, _MM_SHUFFLE(2, 3, 0, 1));
+		z = _mm256_permute4x64_pd(z, _MM_SHUFFLE(3, 0, 1, 2));
+		a = _mm256_blend_pd(_mm256_blend_pd(x, y, 0x2), z, 0x4);
+		b = _mm256_blend_pd(_mm256_blend_pd(x, y, 0x9), z, 0x2);
+		c = _mm256_blend_pd(_mm256_blend_pd(x, y, 0x4), z, 0x9);
+	}
+
+	ENGINE_TARGET_AVX2 static size_t _TransformAVX2(const Mat4d& m, const Vec3d* in, Vec3d* out, size_t count, bool point)
+	{
+		__m256d m0 = _mm256_set1_pd(m.e[0]), m4 = _mm256_set1_pd(m.e[4]), m8 = _mm256_set1_pd(m.e[8]);
+		__m256d m1 = _mm256_set1_pd(m.e[1]), m5 = _mm256_set1_pd(m.e[5]), m9 = _mm256_set1_pd(m.e[9]);
+		__m256d m2 = _mm256_set1_pd(m.e[2]), m6 = _mm256_set1_pd(m.e[6]), m10 = _mm256_set1_pd(m.e[10]);
+		__m256d tx = _mm256_set1_pd(point ? m.e[12] : 0.0);
+		__m256d ty = _mm256_set1_pd(point ? m.e[13] : 0.0);
+		__m256d tz = _mm256_set1_pd(point ? m.e[14] : 0.0);
+
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			const double* p = in[i].f;
+			__m256d x, y, z;
+			_Deinterleave(_mm256_loadu_pd(p), _mm256_loadu_pd(p + 4), _mm256_loadu_pd(p + 8), x, y, z);
+
+			__m256d rx = _mm256_fmadd_pd(m0, x, _mm256_fmadd_pd(m4, y, _mm256_fmadd_pd(m8, z, tx)));
+			__m256d ry = _mm256_fmadd_pd(m1, x, _mm256_fmadd_pd(m5, y, _mm256_fmadd_pd(m9, z, ty)));
+			__m256d rz = _mm256_fmadd_pd(m2, x, _mm256_fmadd_pd(m6, y, _mm256_fmadd_pd(m10, z, tz)));
+
+			__m256d a, b, c;
+			_Interleave(rx, ry, rz, a, b, c);
+			double* o = out[i].f;
+			_mm256_storeu_pd(o, a);
+			_mm256_storeu_pd(o + 4, b);
+			_mm256_storeu_pd(o + 8, c);
+		}
+		return i;
+	}
+
+	/*
+	The origin is repeated with the period of the packed Vec3d, no deinterleave is needed
+	*/
+	ENGINE_TARGET_AVX2 static size_t _ToRelativeAVX2(const Vec3d* in, const Vec3d& origin, Vec3* out, size_t count)
+	{
+		__m256d oa = _mm256_setr_pd(origin.x, origin.y, origin.z, origin.x);
+		__m256d ob = _mm256_setr_pd(origin.y, origin.z, origin.x, origin.y);
+		__m256d oc = _mm256_setr_pd(origin.z, origin.x, origin.y, origin.z);
+
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			const double* p = in[i].f;
+			float* o = out[i].f;
+			_mm_storeu_ps(o, _mm256_cvtpd_ps(_mm256_sub_pd(_mm256_loadu_pd(p), oa)));
+			_mm_storeu_ps(o + 4, _mm256_cvtpd_ps(_mm256_sub_pd(_mm256_loadu_pd(p + 4), ob)));
+			_mm_storeu_ps(o + 8, _mm256_cvtpd_ps(_mm256_sub_pd(_mm256_loadu_pd(p + 8), oc)));
+		}
+		return i;
+	}
+#endif
+
+	template<>
+	Mat4T<float> Mat4T<float>::operator*(const Mat4T<float>& m) const {
+		Mat4T<float> result;
+
+		switch (SIMD::GetLevel())
+		{
+#if MATH_SIMD_X86
+		case SIMD::LEVEL_AVX2: SIMD::MulMat4AVX2(result.e, e, m.e); break;
+		case SIMD::LEVEL_SSE41: SIMD::MulMat4SSE41(result.e, e, m.e); break;
+#endif
+		default: _MulMat4Scalar(result.e, e, m.e); break;
+		}
+
+		return result;
+	}
+
+	template<>
+	Mat4T<double> Mat4T<double>::operator*(const Mat4T<double>& m) const {
+		Mat4T<double> result;
+
+		switch (SIMD::GetLevel())
+		{
+#if MATH_SIMD_X86
+		case SIMD::LEVEL_AVX2: _MulMat4dAVX2(result.e, e, m.e); break;
+#endif
+		default: _MulMat4Scalar(result.e, e, m.e); break;
+		}
+
+		return result;
+	}
+
+	namespace Utils
+	{
+		void TransformPoints(const Mat4d& m, const Vec3d* in, Vec3d* out, size_t count)
+		{
+			size_t i = 0;
+#if MATH_SIMD_X86
+			if (SIMD::GetLevel() == SIMD::LEVEL_AVX2)
+				i = _TransformAVX2(m, in, out, count, true);
+#endif
+			_TransformScalar(m, in, out, i, count, 1.0);
+		}
+
+		void TransformVectors(const Mat4d& m, const Vec3d* in, Vec3d* out, size_t count)
+		{
+			size_t i = 0;
+#if MATH_SIMD_X86
+			if (SIMD::GetLevel() == SIMD::LEVEL_AVX2)
+				i = _TransformAVX2(m, in, out, count, false);
+#endif
+			_TransformScalar(m, in, out, i, count, 0.0);
+		}
+
+		void ToRelative(const Vec3d* in, const Vec3d& origin, Vec3* out, size_t count)
+		{
+			size_t i = 0;
+#if MATH_SIMD_X86
+			if (SIMD::GetLevel() == SIMD::LEVEL_AVX2)
+				i = _ToRelativeAVX2(in, origin, out, count);
+#endif
+			_ToRelativeScalar(in, origin, out, i, count);
+		}
+	}
+}
@@ -0,0 +1,331 @@
+/* Copyright (C) 2009-2020, Nick Galko Ltd. All rights reserved.
+*
+* This file is part of the NGTech (https://galek.github.io/portfolio/).
+*
+* Your use and or redistribution of this software in source and / or
+* binary form, with or without modification, is subject to: (i) your
+* ongoing acceptance of and compliance with the terms and conditions of
+* the NGTech License Agreement; and (ii) your inclusion of this notice
+* in any version of this software that you use or redistribute.
+* A copy of the NGTech License Agreement is available by contacting
+* Nick Galko Ltd. at https://galek.github.io/portfolio/
+*/
+#pragma once
+
+//***************************************************************************
+#include "MathLib.h"
+//***************************************************************************
+
+namespace NGTech
+{
+	/**
+	Precision templates of Vec3, Quat and Mat4 (same layout and meaning as the float classes).
+	Vec3T<float> etc. convert explicitly from/to the existing classes, which are
+	used by the rest of the library. Mat4T<float> and Mat4T<double> products and the
+	Mat4d batch transforms are SIMD (doubles are 4-wide on AVX2)
+	*/
+	template<typename T>
+	class Vec3T
+	{
+	public:
+		union
+		{
+			struct
+			{
+				T x;
+				T y;
+				T z;
+			};
+			T f[3];
+		};
+
+		constexpr Vec3T() : x(0), y(0), z(0) {}
+		constexpr Vec3T(T cx, T cy, T cz) : x(cx), y(cy), z(cz) {}
+		template<typename U>
+		constexpr explicit Vec3T(const Vec3T<U>& v) : x((T)v.x), y((T)v.y), z((T)v.z) {}
+		constexpr explicit Vec3T(const Vec3& v) : x((T)v.x), y((T)v.y), z((T)v.z) {}
+
+		ENGINE_INLINE explicit operator Vec3() const { return Vec3((float)x, (float)y, (float)z); }
+
+		ENGINE_INLINE T& operator[](intptr_t index) { return f[index]; }
+		ENGINE_INLINE T operator[](intptr_t index) const { return f[index]; }
+
+		ENGINE_INLINE Vec3T operator-() const { return Vec3T(-x, -y, -z); }
+		ENGINE_INLINE Vec3T operator+(const Vec3T& v) const { return Vec3T(x + v.x, y + v.y, z + v.z); }
+		ENGINE_INLINE Vec3T operator-(const Vec3T& v) const { return Vec3T(x - v.x, y - v.y, z - v.z); }
+		ENGINE_INLINE Vec3T operator*(const Vec3T& v) const { return Vec3T(x * v.x, y * v.y, z * v.z); }
+		ENGINE_INLINE Vec3T operator*(T c) const { return Vec3T(x * c, y * c, z * c); }
+		ENGINE_INLINE Vec3T operator/(T c) const { return Vec3T(x / c, y / c, z / c); }
+
+		ENGINE_INLINE Vec3T& operator+=(const Vec3T& v) { x += v.x; y += v.y; z += v.z; return *this; }
+		ENGINE_INLINE Vec3T& operator-=(const Vec3T& v) { x -= v.x; y -= v.y; z -= v.z; return *this; }
+		ENGINE_INLINE Vec3T& operator*=(T c) { x *= c; y *= c; z *= c; return *this; }
+
+		ENGINE_INLINE bool operator==(const Vec3T& v) const { return x == v.x && y == v.y && z == v.z; }
+		ENGINE_INLINE bool operator!=(const Vec3T& v) const { return !(*this == v); }
+
+		ENGINE_INLINE T length() const { return std::sqrt(x * x + y * y + z * z); }
+		ENGINE_INLINE T GetSquaredLength() const { return x * x + y * y + z * z; }
+		ENGINE_INLINE void Normalize() { *this = normalize(*this); }
+
+		static ENGINE_INLINE T dot(const Vec3T& a, const Vec3T& b) {
+			return a.x * b.x + a.y * b.y + a.z * b.z;
+		}
+		static ENGINE_INLINE Vec3T cross(const Vec3T& a, const Vec3T& b) {
+			return Vec3T(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+		}
+		static ENGINE_INLINE Vec3T normalize(const Vec3T& a) {
+			T len = a.length();
+			return (len != 0) ? a * (T(1) / len) : a;
+		}
+	};
+
+	template<typename T>
+	ENGINE_INLINE Vec3T<T> operator*(T c, const Vec3T<T>& v) { return v * c; }
+
+	/**
+	Unlike Quat::operator*, the product is the Hamilton product: (a * b) rotates by b first
+	*/
+	template<typename T>
+	class QuatT
+	{
+	public:
+		union
+		{
+			struct
+			{
+				T x;
+				T y;
+				T z;
+				T w;
+			};
+			T f[4];
+		};
+
+		constexpr QuatT() : x(0), y(0), z(0), w(1) {}
+		constexpr QuatT(T _x, T _y, T _z, T _w) : x(_x), y(_y), z(_z), w(_w) {}
+		template<typename U>
+		constexpr explicit QuatT(const QuatT<U>& q) : x((T)q.x), y((T)q.y), z((T)q.z), w((T)q.w) {}
+		constexpr explicit QuatT(const Quat& q) : x((T)q.x), y((T)q.y), z((T)q.z), w((T)q.w) {}
+
+		/**
+		angle in degrees, like Quat
+		*/
+		QuatT(T angle, const Vec3T<T>& axis) {
+			Vec3T<T> n = Vec3T<T>::normalize(axis);
+			T half = angle * T(3.14159265358979323846 / 360.0);
+			T s = std::sin(half);
+			x = n.x * s;
+			y = n.y * s;
+			z = n.z * s;
+			w = std::cos(half);
+		}
+
+		ENGINE_INLINE explicit operator Quat() const { return Quat((float)x, (float)y, (float)z, (float)w); }
+
+		ENGINE_INLINE T& operator[](intptr_t i) { return f[i]; }
+		ENGINE_INLINE T operator[](intptr_t i) const { return f[i]; }
+
+		ENGINE_INLINE QuatT operator*(const QuatT& b) const {
+			return QuatT(w * b.x + x * b.w + y * b.z - z * b.y,
+				w * b.y - x * b.z + y * b.w + z * b.x,
+				w * b.z + x * b.y - y * b.x + z * b.w,
+				w * b.w - x * b.x - y * b.y - z * b.z);
+		}
+
+		ENGINE_INLINE QuatT GetConjugate() const { return QuatT(-x, -y, -z, w); }
+
+		ENGINE_INLINE void Normalize() {
+			T len = std::sqrt(x * x + y * y + z * z + w * w);
+			if (len != 0) {
+				T inv = T(1) / len;
+				x *= inv; y *= inv; z *= inv; w *= inv;
+			}
+		}
+
+		/**
+		v + w * t + cross(q, t), t = 2 * cross(q, v)
+		*/
+		ENGINE_INLINE Vec3T<T> Rotate(const Vec3T<T>& v) const {
+			Vec3T<T> q(x, y, z);
+			Vec3T<T> t = Vec3T<T>::cross(q, v) * T(2);
+			return v + t * w + Vec3T<T>::cross(q, t);
+		}
+
+		static QuatT slerp(const QuatT& q0, const QuatT& q1, T t) {
+			T cosomega = q0.x * q1.x + q0.y * q1.y + q0.z * q1.z + q0.w * q1.w;
+			T sign = (cosomega < 0) ? T(-1) : T(1);
+			cosomega *= sign;
+
+			T k0 = T(1) - t, k1 = t;
+			if (T(1) - cosomega > T(1e-6)) {
+				T omega = std::acos(cosomega);
+				T sinomega = std::sin(omega);
+				k0 = std::sin((T(1) - t) * omega) / sinomega;
+				k1 = std::sin(t * omega) / sinomega;
+			}
+			k1 *= sign;
+
+			return QuatT(q0.x * k0 + q1.x * k1, q0.y * k0 + q1.y * k1, q0.z * k0 + q1.z * k1, q0.w * k0 + q1.w * k1);
+		}
+	};
+
+	/**
+	Column-major 4x4 matrix, e[column * 4 + row]. The constructor takes the values row by row like Mat4
+	*/
+	template<typename T>
+	class Mat4T
+	{
+	public:
+		T e[16];
+
+		constexpr Mat4T() : e{ 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 } {}
+		constexpr Mat4T(T e0, T e4, T e8, T e12,
+			T e1, T e5, T e9, T e13,
+			T e2, T e6, T e10, T e14,
+			T e3, T e7, T e11, T e15)
+			: e{ e0, e1, e2, e3, e4, e5, e6, e7, e8, e9, e10, e11, e12, e13, e14, e15 } {}
+
+		template<typename U>
+		explicit Mat4T(const Mat4T<U>& m) {
+			for (int i = 0; i < 16; i++)
+				e[i] = (T)m.e[i];
+		}
+		explicit Mat4T(const Mat4& m) {
+			for (int i = 0; i < 16; i++)
+				e[i] = (T)m.e[i];
+		}
+
+		explicit operator Mat4() const {
+			Mat4 m;
+			for (int i = 0; i < 16; i++)
+				m.e[i] = (float)e[i];
+			return m;
+		}
+
+		ENGINE_INLINE T& operator[](intptr_t index) { return e[index]; }
+		ENGINE_INLINE T operator[](intptr_t index) const { return e[index]; }
+
+		ENGINE_INLINE Vec3T<T> GetPosition() const { return Vec3T<T>(e[12], e[13], e[14]); }
+		ENGINE_INLINE void SetPosition(const Vec3T<T>& v) { e[12] = v.x; e[13] = v.y; e[14] = v.z; }
+
+		/**
+		Specialized with SIMD for float and double
+		*/
+		Mat4T operator*(const Mat4T& m) const {
+			Mat4T r;
+			for (int c = 0; c < 4; c++)
+				for (int row = 0; row < 4; row++)
+					r.e[c * 4 + row] = e[row] * m.e[c * 4] + e[4 + row] * m.e[c * 4 + 1] + e[8 + row] * m.e[c * 4 + 2] + e[12 + row] * m.e[c * 4 + 3];
+			return r;
+		}
+
+		ENGINE_INLINE Mat4T& operator*=(const Mat4T& m) {
+			*this = *this * m;
+			return *this;
+		}
+
+		/**
+		Point (w = 1) and vector (w = 0) transform
+		*/
+		ENGINE_INLINE Vec3T<T> operator*(const Vec3T<T>& v) const {
+			return Vec3T<T>(e[0] * v.x + e[4] * v.y + e[8] * v.z + e[12],
+				e[1] * v.x + e[5] * v.y + e[9] * v.z + e[13],
+				e[2] * v.x + e[6] * v.y + e[10] * v.z + e[14]);
+		}
+		ENGINE_INLINE Vec3T<T> TransformVector(const Vec3T<T>& v) const {
+			return Vec3T<T>(e[0] * v.x + e[4] * v.y + e[8] * v.z,
+				e[1] * v.x + e[5] * v.y + e[9] * v.z,
+				e[2] * v.x + e[6] * v.y + e[10] * v.z);
+		}
+
+		static Mat4T transpose(const Mat4T& m) {
+			Mat4T r;
+			for (int c = 0; c < 4; c++)
+				for (int row = 0; row < 4; row++)
+					r.e[c * 4 + row] = m.e[row * 4 + c];
+			return r;
+		}
+
+		/**
+		Bottom row must be 0, 0, 0, 1
+		*/
+		static Mat4T inverseAffine(const Mat4T& m) {
+			Vec3T<T> c0(m.e[0], m.e[1], m.e[2]), c1(m.e[4], m.e[5], m.e[6]), c2(m.e[8], m.e[9], m.e[10]);
+
+			// rows of the inverse 3x3
+			Vec3T<T> r0 = Vec3T<T>::cross(c1, c2);
+			Vec3T<T> r1 = Vec3T<T>::cross(c2, c0);
+			Vec3T<T> r2 = Vec3T<T>::cross(c0, c1);
+			T invDet = T(1) / Vec3T<T>::dot(c0, r0);
+			r0 *= invDet;
+			r1 *= invDet;
+			r2 *= invDet;
+
+			Vec3T<T> t = m.GetPosition();
+			return Mat4T(r0.x, r0.y, r0.z, -Vec3T<T>::dot(r0, t),
+				r1.x, r1.y, r1.z, -Vec3T<T>::dot(r1, t),
+				r2.x, r2.y, r2.z, -Vec3T<T>::dot(r2, t),
+				0, 0, 0, 1);
+		}
+
+		static constexpr Mat4T translate(const Vec3T<T>& t) {
+			return Mat4T(1, 0, 0, t.x,
+				0, 1, 0, t.y,
+				0, 0, 1, t.z,
+				0, 0, 0, 1);
+		}
+		static constexpr Mat4T scale(const Vec3T<T>& s) {
+			return Mat4T(s.x, 0, 0, 0,
+				0, s.y, 0, 0,
+				0, 0, s.z, 0,
+				0, 0, 0, 1);
+		}
+		/**
+		q must be normalized
+		*/
+		static Mat4T rotate(const QuatT<T>& q) {
+			T x2 = q.x + q.x, y2 = q.y + q.y, z2 = q.z + q.z;
+			T xx = q.x * x2, yy = q.y * y2, zz = q.z * z2;
+			T xy = q.x * y2, yz = q.y * z2, xz = q.z * x2;
+			T wx = q.w * x2, wy = q.w * y2, wz = q.w * z2;
+
+			return Mat4T(1 - (yy + zz), xy - wz, xz + wy, 0,
+				xy + wz, 1 - (xx + zz), yz - wx, 0,
+				xz - wy, yz + wx, 1 - (xx + yy), 0,
+				0, 0, 0, 1);
+		}
+	};
+
+	template<> Mat4T<float> Mat4T<float>::operator*(const Mat4T<float>& m) const;
+	template<> Mat4T<double> Mat4T<double>::operator*(const Mat4T<double>& m) const;
+
+	typedef Vec3T<float> Vec3f;
+	typedef Vec3T<double> Vec3d;
+	typedef QuatT<float> Quatf;
+	typedef QuatT<double> Quatd;
+	typedef Mat4T<float> Mat4f;
+	typedef Mat4T<double> Mat4d;
+
+	static_assert(sizeof(Vec3d) == 3 * sizeof(double), "Invalid Vec3d padding!");
+	static_assert(sizeof(Quatd) == 4 * sizeof(double), "Invalid Quatd padding!");
+	static_assert(sizeof(Mat4d) == 16 * sizeof(double), "Invalid Mat4d padding!");
+	static_assert(std::is_trivially_copyable<Vec3d>::value, "Vec3d must be trivially copyable!");
+	static_assert(std::is_trivially_copyable<Quatd>::value, "Quatd must be trivially copyable!");
+	static_assert(std::is_trivially_copyable<Mat4d>::value, "Mat4d must be trivially copyable!");
+
+	namespace Utils
+	{
+		/**
+		Same as the Mat4 versions, in double precision. in and out may be the same array
+		*/
+		void TransformPoints(const Mat4d& m, const Vec3d* in, Vec3d* out, size_t count);
+		void TransformVectors(const Mat4d& m, const Vec3d* in, Vec3d* out, size_t count);
+
+		/**
+		out[i] = Vec3(in[i] - origin). Subtraction is done in double, so far away positions
+		keep their precision relative to the origin (camera-relative rendering, local physics)
+		*/
+		void ToRelative(const Vec3d* in, const Vec3d& origin, Vec3* out, size_t count);
+	}
+}
@@ -0,0 +1,667 @@
+/* Copyright (C) 2009-2020, Nick Galko Ltd. All rights reserved.
+*
+* This file is part of the NGTech (https://galek.github.io/portfolio/).
+*
+* Your use and or redistribution of this software in source and / or
+* binary form, with or without modification, is subject to: (i) your
+* ongoing acceptance of and compliance with the terms and conditions of
+* the NGTech License Agreement; and (ii) your inclusion of this notice
+* in any version of this software that you use or redistribute.
+* A copy of the NGTech License Agreement is available by contacting
+* Nick Galko Ltd. at https://galek.github.io/portfolio/
+*/
+//***************************************************************************
+#include <string.h>
+//***************************************************************************
+#include "Packed.h"
+#include "BBox.h"
+#include "SIMD.h"
+//***************************************************************************
+
+namespace NGTech
+{
+	/*
+	Smallest three: the kept components are in [-1/sqrt(2), 1/sqrt(2)] and mapped to [0, 2 * CENTER]
+	*/
+	static const float QUAT_SQRT2 = 1.41421356237309505f;
+	static const float QUAT_INV_SQRT2 = 0.70710678118654752f;
+	static const int QUAT32_CENTER = 511;
+	static const int QUAT48_CENTER = 16383;
+
+	static const float OCT_SCALE = 32767.0f;
+	static const float QUANT16_MAX = 65535.0f;
+
+	static ENGINE_INLINE uint32_t _AsUInt(float f) {
+		uint32_t u;
+		memcpy(&u, &f, sizeof(u));
+		return u;
+	}
+
+	static ENGINE_INLINE float _AsFloat(uint32_t u) {
+		float f;
+		memcpy(&f, &u, sizeof(f));
+		return f;
+	}
+
+	/*
+	Same rounding as _mm_cvtps_epi32 (nearest even)
+	*/
+	static ENGINE_INLINE int _Round(float f) {
+		return (int)lrintf(f);
+	}
+
+	static ENGINE_INLINE float _Clamp(float v, float lo, float hi) {
+		return (v < lo) ? lo : ((v > hi) ? hi : v);
+	}
+
+	/*
+	Half conversions work on the bit patterns, after F. Giesen (float_to_half_fast3_rtne, half_to_float_fast5)
+	*/
+	static const uint32_t HALF_F32_INF = 255u << 23;
+	static const uint32_t HALF_F16_MAX = (127u + 16u) << 23;						// first float which is inf in half
+	static const uint32_t HALF_DENORM_MAGIC = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+	static const uint32_t HALF_MIN_NORMAL = 113u << 23;							// 2^-14
+	static const uint32_t HALF_REBIAS = (uint32_t)(15 - 127) << 23;
+	static const uint32_t HALF_SHIFTED_EXP = 0x7c00u << 13;
+
+	uint16_t Vec3Half::FloatToHalf(float f)
+	{
+		uint32_t u = _AsUInt(f);
+		uint32_t sign = u & 0x80000000u;
+		u ^= sign;
+
+		uint32_t o;
+		if (u >= HALF_F16_MAX)
+			o = (u > HALF_F32_INF) ? 0x7e00 : 0x7c00;
+		else if (u < HALF_MIN_NORMAL)
+			o = _AsUInt(_AsFloat(u) + _AsFloat(HALF_DENORM_MAGIC)) - HALF_DENORM_MAGIC;
+		else {
+			uint32_t mantOdd = (u >> 13) & 1;
+			o = (u + HALF_REBIAS + 0xfff + mantOdd) >> 13;
+		}
+
+		return (uint16_t)(o | (sign >> 16));
+	}
+
+	float Vec3Half::HalfToFloat(uint16_t h)
+	{
+		uint32_t o = (uint32_t)(h & 0x7fff) << 13;
+		uint32_t exp = o & HALF_SHIFTED_EXP;
+		o += (127u - 15u) << 23;
+
+		if (exp == HALF_SHIFTED_EXP)
+			o += (128u - 16u) << 23;				// inf, NaN
+		else if (exp == 0)
+			o = _AsUInt(_AsFloat(o + (1u << 23)) - _AsFloat(HALF_MIN_NORMAL));		// zero, denormal
+
+		return _AsFloat(o | ((uint32_t)(h & 0x8000) << 16));
+	}
+
+	/*
+	*/
+	Vec3Half::Vec3Half(const Vec3& v)
+		: x(FloatToHalf(v.x)), y(FloatToHalf(v.y)), z(FloatToHalf(v.z))
+	{}
+
+	Vec3 Vec3Half::ToVec3() const {
+		return Vec3(HalfToFloat(x), HalfToFloat(y), HalfToFloat(z));
+	}
+
+	/*
+	Projection on the octahedron |x| + |y| + |z| = 1, the lower half is folded over the diagonals
+	*/
+	OctNormal::OctNormal(const Vec3& n)
+	{
+		float inv = Math::ONEFLOAT / (fabsf(n.x) + fabsf(n.y) + fabsf(n.z));
+		float ox = n.x * inv, oy = n.y * inv;
+
+		if (n.z < 0) {
+			float fx = copysignf(Math::ONEFLOAT - fabsf(oy), ox);
+			float fy = copysignf(Math::ONEFLOAT - fabsf(ox), oy);
+			ox = fx;
+			oy = fy;
+		}
+
+		x = (int16_t)_Round(_Clamp(ox, -1.0f, 1.0f) * OCT_SCALE);
+		y = (int16_t)_Round(_Clamp(oy, -1.0f, 1.0f) * OCT_SCALE);
+	}
+
+	Vec3 OctNormal::ToVec3() const
+	{
+		float ox = Math::Max(x * (1.0f / OCT_SCALE), -1.0f);
+		float oy = Math::Max(y * (1.0f / OCT_SCALE), -1.0f);
+		float oz = Math::ONEFLOAT - fabsf(ox) - fabsf(oy);
+
+		float t = Math::Max(-oz, 0.0f);
+		ox -= copysignf(t, ox);
+		oy -= copysignf(t, oy);
+
+		float inv = Math::ONEFLOAT / sqrtf(ox * ox + oy * oy + oz * oz);
+		return Vec3(ox * inv, oy * inv, oz * inv);
+	}
+
+	/*
+	Index of the largest component (first one on ties) and the others in order, with the sign
+	of the largest folded in (q and -q are the same rotation)
+	*/
+	static ENGINE_INLINE int _SmallestThree(const Quat& q, float c[3])
+	{
+		int m = 0;
+		float best = fabsf(q.f[0]);
+		for (int i = 1; i < 4; i++) {
+			if (fabsf(q.f[i]) > best) {
+				best = fabsf(q.f[i]);
+				m = i;
+			}
+		}
+
+		float sign = (q.f[m] < 0) ? -1.0f : 1.0f;
+		for (int i = 0, j = 0; i < 4; i++)
+			if (i != m)
+				c[j++] = q.f[i] * sign;
+
+		return m;
+	}
+
+	static ENGINE_INLINE int _QuantizeQuat(float c, int center) {
+		return _Round(_Clamp(c * (QUAT_SQRT2 * center) + center, 0.0f, 2.0f * center));
+	}
+
+	static ENGINE_INLINE float _DequantizeQuat(int q, int center) {
+		return (q - center) * (QUAT_INV_SQRT2 / center);
+	}
+
+	static ENGINE_INLINE Quat _FromSmallestThree(int m, const float c[3])
+	{
+		float d = sqrtf(Math::Max(Math::ONEFLOAT - (c[0] * c[0] + c[1] * c[1] + c[2] * c[2]), 0.0f));
+
+		Quat q;
+		for (int i = 0, j = 0; i < 4; i++)
+			q.f[i] = (i == m) ? d : c[j++];
+		return q;
+	}
+
+	QuatPacked32::QuatPacked32(const Quat& q)
+	{
+		float c[3];
+		uint32_t m = (uint32_t)_SmallestThree(q, c);
+		bits = m << 30
+			| (uint32_t)_QuantizeQuat(c[0], QUAT32_CENTER) << 20
+			| (uint32_t)_QuantizeQuat(c[1], QUAT32_CENTER) << 10
+			| (uint32_t)_QuantizeQuat(c[2], QUAT32_CENTER);
+	}
+
+	Quat QuatPacked32::ToQuat() const
+	{
+		float c[3] = {
+			_DequantizeQuat((bits >> 20) & 1023, QUAT32_CENTER),
+			_DequantizeQuat((bits >> 10) & 1023, QUAT32_CENTER),
+			_DequantizeQuat(bits & 1023, QUAT32_CENTER)
+		};
+		return _FromSmallestThree((int)(bits >> 30), c);
+	}
+
+	QuatPacked48::QuatPacked48(const Quat& q)
+	{
+		float c[3];
+		int m = _SmallestThree(q, c);
+		v[0] = (uint16_t)(_QuantizeQuat(c[0], QUAT48_CENTER) | (m >> 1) << 15);
+		v[1] = (uint16_t)(_QuantizeQuat(c[1], QUAT48_CENTER) | (m & 1) << 15);
+		v[2] = (uint16_t)_QuantizeQuat(c[2], QUAT48_CENTER);
+	}
+
+	Quat QuatPacked48::ToQuat() const
+	{
+		float c[3] = {
+			_DequantizeQuat(v[0] & 0x7fff, QUAT48_CENTER),
+			_DequantizeQuat(v[1] & 0x7fff, QUAT48_CENTER),
+			_DequantizeQuat(v[2] & 0x7fff, QUAT48_CENTER)
+		};
+		return _FromSmallestThree((v[0] >> 15) << 1 | (v[1] >> 15), c);
+	}
+
+	/*
+	A flat box axis encodes to 0 and decodes to mins
+	*/
+	static ENGINE_INLINE Vec3 _QuantizeScale(const BBox& box)
+	{
+		Vec3 extent = box.maxes - box.mins;
+		return Vec3((extent.x > 0) ? QUANT16_MAX / extent.x : 0,
+			(extent.y > 0) ? QUANT16_MAX / extent.y : 0,
+			(extent.z > 0) ? QUANT16_MAX / extent.z : 0);
+	}
+
+	Vec3Quantized16::Vec3Quantized16(const Vec3& p, const BBox& box)
+	{
+		Vec3 scale = _QuantizeScale(box);
+		x = (uint16_t)_Round(_Clamp((p.x - box.mins.x) * scale.x, 0, QUANT16_MAX));
+		y = (uint16_t)_Round(_Clamp((p.y - box.mins.y) * scale.y, 0, QUANT16_MAX));
+		z = (uint16_t)_Round(_Clamp((p.z - box.mins.z) * scale.z, 0, QUANT16_MAX));
+	}
+
+	Vec3 Vec3Quantized16::ToVec3(const BBox& box) const
+	{
+		Vec3 step = (box.maxes - box.mins) * (1.0f / QUANT16_MAX);
+		return Vec3(box.mins.x + x * step.x, box.mins.y + y * step.y, box.mins.z + z * step.z);
+	}
+
+#if MATH_SIMD_X86
+	/*
+	4 elements of three uint16 (24 bytes) from/to the low 16 bits of 32-bit lanes
+	*/
+	ENGINE_TARGET_SSE41 static ENGINE_INLINE void _Store3x16(uint16_t* p, __m128i x, __m128i y, __m128i z)
+	{
+		const __m128i loXY = _mm_setr_epi8(0, 1, 8, 9, -128, -128, 2, 3, 10, 11, -128, -128, 4, 5, 12, 13);
+		const __m128i loZ = _mm_setr_epi8(-128, -128, -128, -128, 0, 1, -128, -128, -128, -128, 2, 3, -128, -128, -128, -128);
+		const __m128i hiXY = _mm_setr_epi8(-128, -128, 6, 7, 14, 15, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128);
+		const __m128i hiZ = _mm_setr_epi8(4, 5, -128, -128, -128, -128, 6, 7, -128, -128, -128, -128, -128, -128, -128, -128);
+
+		__m128i xy = _mm_packus_epi32(x, y);	// x0 x1 x2 x3 y0 y1 y2 y3
+		__m128i zz = _mm_packus_epi32(z, z);
+
+		__m128i lo = _mm_or_si128(_mm_shuffle_epi8(xy, loXY), _mm_shuffle_epi8(zz, loZ));	// x0 y0 z0 x1 y1 z1 x2 y2
+		__m128i hi = _mm_or_si128(_mm_shuffle_epi8(xy, hiXY), _mm_shuffle_epi8(zz, hiZ));	// z2 x3 y3 z3
+		_mm_storeu_si128((__m128i*)p, lo);
+		_mm_storel_epi64((__m128i*)(p + 8), hi);
+	}
+
+	ENGINE_TARGET_SSE41 static ENGINE_INLINE void _Load3x16(const uint16_t* p, __m128i& x, __m128i& y, __m128i& z)
+	{
+		const __m128i loX = _mm_setr_epi8(0, 1, -128, -128, 6, 7, -128, -128, 12, 13, -128, -128, -128, -128, -128, -128);
+		const __m128i hiX = _mm_setr_epi8(-128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, 2, 3, -128, -128);
+		const __m128i loY = _mm_setr_epi8(2, 3, -128, -128, 8, 9, -128, -128, 14, 15, -128, -128, -128, -128, -128, -128);
+		const __m128i hiY = _mm_setr_epi8(-128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, 4, 5, -128, -128);
+		const __m128i loZ = _mm_setr_epi8(4, 5, -128, -128, 10, 11, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128);
+		const __m128i hiZ = _mm_setr_epi8(-128, -128, -128, -128, -128, -128, -128, -128, 0, 1, -128, -128, 6, 7, -128, -128);
+
+		__m128i lo = _mm_loadu_si128((const __m128i*)p);
+		__m128i hi = _mm_loadl_epi64((const __m128i*)(p + 8));
+		x = _mm_or_si128(_mm_shuffle_epi8(lo, loX), _mm_shuffle_epi8(hi, hiX));
+		y = _mm_or_si128(_mm_shuffle_epi8(lo, loY), _mm_shuffle_epi8(hi, hiY));
+		z = _mm_or_si128(_mm_shuffle_epi8(lo, loZ), _mm_shuffle_epi8(hi, hiZ));
+	}
+
+	ENGINE_TARGET_SSE41 static ENGINE_INLINE __m128i _FloatToHalfSSE41(__m128 f)
+	{
+		__m128i u = _mm_castps_si128(f);
+		__m128i sign = _mm_and_si128(u, _mm_set1_epi32((int)0x80000000u));
+		u = _mm_xor_si128(u, sign);
+
+		__m128i infNan = _mm_blendv_epi8(_mm_set1_epi32(0x7c00), _mm_set1_epi32(0x7e00), _mm_cmpgt_epi32(u, _mm_set1_epi32((int)HALF_F32_INF)));
+
+		__m128 magic = _mm_castsi128_ps(_mm_set1_epi32((int)HALF_DENORM_MAGIC));
+		__m128i denorm = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(u), magic)), _mm_castps_si128(magic));
+
+		__m128i mantOdd = _mm_and_si128(_mm_srli_epi32(u, 13), _mm_set1_epi32(1));
+		__m128i normal = _mm_add_epi32(_mm_add_epi32(u, _mm_set1_epi32((int)(HALF_REBIAS + 0xfff))), mantOdd);
+		normal = _mm_srli_epi32(normal, 13);
+
+		__m128i o = _mm_blendv_epi8(normal, denorm, _mm_cmplt_epi32(u, _mm_set1_epi32((int)HALF_MIN_NORMAL)));
+		o = _mm_blendv_epi8(o, infNan, _mm_cmpgt_epi32(u, _mm_set1_epi32((int)HALF_F16_MAX - 1)));
+		return _mm_or_si128(o, _mm_srli_epi32(sign, 16));
+	}
+
+	ENGINE_TARGET_SSE41 static ENGINE_INLINE __m128 _HalfToFloatSSE41(__m128i h)
+	{
+		__m128i shiftedExp = _mm_set1_epi32((int)HALF_SHIFTED_EXP);
+		__m128i o = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x7fff)), 13);
+		__m128i exp = _mm_and_si128(o, shiftedExp);
+		o = _mm_add_epi32(o, _mm_set1_epi32((int)((127u - 15u) << 23)));
+
+		o = _mm_add_epi32(o, _mm_and_si128(_mm_cmpeq_epi32(exp, shiftedExp), _mm_set1_epi32((int)((128u - 16u) << 23))));
+
+		__m128 denorm = _mm_sub_ps(_mm_castsi128_ps(_mm_add_epi32(o, _mm_set1_epi32(1 << 23))), _mm_castsi128_ps(_mm_set1_epi32((int)HALF_MIN_NORMAL)));
+		o = _mm_blendv_epi8(o, _mm_castps_si128(denorm), _mm_cmpeq_epi32(exp, _mm_setzero_si128()));
+
+		return _mm_castsi128_ps(_mm_or_si128(o, _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x8000)), 16)));
+	}
+
+	ENGINE_TARGET_SSE41 static size_t _PackHalfSSE41(const Vec3* in, Vec3Half* out, size_t count)
+	{
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 x, y, z;
+			SIMD::LoadVec3x4(in[i].f, x, y, z);
+			_Store3x16(&out[i].x, _FloatToHalfSSE41(x), _FloatToHalfSSE41(y), _FloatToHalfSSE41(z));
+		}
+		return i;
+	}
+
+	ENGINE_TARGET_SSE41 static size_t _UnpackHalfSSE41(const Vec3Half* in, Vec3* out, size_t count)
+	{
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128i x, y, z;
+			_Load3x16(&in[i].x, x, y, z);
+			SIMD::StoreVec3x4(out[i].f, _HalfToFloatSSE41(x), _HalfToFloatSSE41(y), _HalfToFloatSSE41(z));
+		}
+		return i;
+	}
+
+	ENGINE_TARGET_SSE41 static ENGINE_INLINE __m128 _CopySign(__m128 v, __m128 s)
+	{
+		__m128 signMask = _mm_set1_ps(-0.0f);
+		return _mm_or_ps(_mm_andnot_ps(signMask, v), _mm_and_ps(signMask, s));
+	}
+
+	ENGINE_TARGET_SSE41 static ENGINE_INLINE __m128 _Abs(__m128 v)
+	{
+		return _mm_andnot_ps(_mm_set1_ps(-0.0f), v);
+	}
+
+	ENGINE_TARGET_SSE41 static size_t _PackOctSSE41(const Vec3* in, OctNormal* out, size_t count)
+	{
+		__m128 one = _mm_set1_ps(1.0f);
+		__m128 minusOne = _mm_set1_ps(-1.0f);
+		__m128 scale = _mm_set1_ps(OCT_SCALE);
+
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 x, y, z;
+			SIMD::LoadVec3x4(in[i].f, x, y, z);
+
+			__m128 inv = _mm_div_ps(one, _mm_add_ps(_mm_add_ps(_Abs(x), _Abs(y)), _Abs(z)));
+			x = _mm_mul_ps(x, inv);
+			y = _mm_mul_ps(y, inv);
+
+			__m128 lower = _mm_cmplt_ps(z, _mm_setzero_ps());
+			__m128 fx = _CopySign(_mm_sub_ps(one, _Abs(y)), x);
+			__m128 fy = _CopySign(_mm_sub_ps(one, _Abs(x)), y);
+			x = _mm_blendv_ps(x, fx, lower);
+			y = _mm_blendv_ps(y, fy, lower);
+
+			__m128i qx = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(x, minusOne), one), scale));
+			__m128i qy = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(y, minusOne), one), scale));
+
+			// x0 y0 x1 y1 x2 y2 x3 y3
+			_mm_storeu_si128((__m128i*)&out[i], _mm_unpacklo_epi16(_mm_packs_epi32(qx, qx), _mm_packs_epi32(qy, qy)));
+		}
+		return i;
+	}
+
+	ENGINE_TARGET_SSE41 static size_t _UnpackOctSSE41(const OctNormal* in, Vec3* out, size_t count)
+	{
+		__m128 one = _mm_set1_ps(1.0f);
+		__m128 minusOne = _mm_set1_ps(-1.0f);
+		__m128 invScale = _mm_set1_ps(1.0f / OCT_SCALE);
+
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128i v = _mm_loadu_si128((const __m128i*)&in[i]);
+			__m128 x = _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(v, 16), 16)), invScale), minusOne);
+			__m128 y = _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(v, 16)), invScale), minusOne);
+			__m128 z = _mm_sub_ps(_mm_sub_ps(one, _Abs(x)), _Abs(y));
+
+			__m128 t = _mm_max_ps(_mm_sub_ps(_mm_setzero_ps(), z), _mm_setzero_ps());
+			x = _mm_sub_ps(x, _CopySign(t, x));
+			y = _mm_sub_ps(y, _CopySign(t, y));
+
+			__m128 inv = _mm_div_ps(one, _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z))));
+			SIMD::StoreVec3x4(out[i].f, _mm_mul_ps(x, inv), _mm_mul_ps(y, inv), _mm_mul_ps(z, inv));
+		}
+		return i;
+	}
+
+	/*
+	4 quaternions transposed to x, y, z, w: index of the largest component and the other three
+	in order, with the sign of the largest folded in
+	*/
+	ENGINE_TARGET_SSE41 static ENGINE_INLINE __m128i _SmallestThreeSSE41(const Quat* q, __m128& a, __m128& b, __m128& c)
+	{
+		__m128 x = _mm_loadu_ps(q[0].f), y = _mm_loadu_ps(q[1].f), z = _mm_loadu_ps(q[2].f), w = _mm_loadu_ps(q[3].f);
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+
+		__m128i m = _mm_setzero_si128();
+		__m128 best = _Abs(x), largest = x;
+		__m128 comp[3] = { y, z, w };
+		for (int k = 0; k < 3; k++)
+		{
+			__m128 gt = _mm_cmpgt_ps(_Abs(comp[k]), best);
+			best = _mm_max_ps(best, _Abs(comp[k]));
+			largest = _mm_blendv_ps(largest, comp[k], gt);
+			m = _mm_blendv_epi8(m, _mm_set1_epi32(k + 1), _mm_castps_si128(gt));
+		}
+
+		__m128 first = _mm_castsi128_ps(_mm_cmpeq_epi32(m, _mm_setzero_si128()));
+		__m128 upTo1 = _mm_castsi128_ps(_mm_cmplt_epi32(m, _mm_set1_epi32(2)));
+		__m128 upTo2 = _mm_castsi128_ps(_mm_cmplt_epi32(m, _mm_set1_epi32(3)));
+
+		__m128 sign = _mm_and_ps(largest, _mm_set1_ps(-0.0f));
+		a = _mm_xor_ps(_mm_blendv_ps(x, y, first), sign);
+		b = _mm_xor_ps(_mm_blendv_ps(y, z, upTo1), sign);
+		c = _mm_xor_ps(_mm_blendv_ps(z, w, upTo2), sign);
+		return m;
+	}
+
+	ENGINE_TARGET_SSE41 static ENGINE_INLINE void _FromSmallestThreeSSE41(__m128i m, __m128 a, __m128 b, __m128 c, Quat* q)
+	{
+		__m128 d = _mm_sub_ps(_mm_set1_ps(1.0f), _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, a), _mm_mul_ps(b, b)), _mm_mul_ps(c, c)));
+		d = _mm_sqrt_ps(_mm_max_ps(d, _mm_setzero_ps()));
+
+		__m128 is0 = _mm_castsi128_ps(_mm_cmpeq_epi32(m, _mm_setzero_si128()));
+		__m128 is1 = _mm_castsi128_ps(_mm_cmpeq_epi32(m, _mm_set1_epi32(1)));
+		__m128 is2 = _mm_castsi128_ps(_mm_cmpeq_epi32(m, _mm_set1_epi32(2)));
+		__m128 is3 = _mm_castsi128_ps(_mm_cmpeq_epi32(m, _mm_set1_epi32(3)));
+
+		__m128 x = _mm_blendv_ps(a, d, is0);
+		__m128 y = _mm_blendv_ps(_mm_blendv_ps(b, d, is1), a, is0);
+		__m128 z = _mm_blendv_ps(_mm_blendv_ps(c, d, is2), b, _mm_or_ps(is0, is1));
+		__m128 w = _mm_blendv_ps(c, d, is3);
+
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+		_mm_storeu_ps(q[0].f, x);
+		_mm_storeu_ps(q[1].f, y);
+		_mm_storeu_ps(q[2].f, z);
+		_mm_storeu_ps(q[3].f, w);
+	}
+
+	ENGINE_TARGET_SSE41 static ENGINE_INLINE __m128i _QuantizeQuatSSE41(__m128 c, int center)
+	{
+		__m128 v = _mm_add_ps(_mm_mul_ps(c, _mm_set1_ps(QUAT_SQRT2 * center)), _mm_set1_ps((float)center));
+		v = _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(2.0f * center));
+		return _mm_cvtps_epi32(v);
+	}
+
+	ENGINE_TARGET_SSE41 static ENGINE_INLINE __m128 _DequantizeQuatSSE41(__m128i q, int center)
+	{
+		return _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(q, _mm_set1_epi32(center))), _mm_set1_ps(QUAT_INV_SQRT2 / center));
+	}
+
+	ENGINE_TARGET_SSE41 static size_t _PackQuat32SSE41(const Quat* in, QuatPacked32* out, size_t count)
+	{
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 a, b, c;
+			__m128i m = _SmallestThreeSSE41(in + i, a, b, c);
+
+			__m128i bits = _mm_slli_epi32(m, 30);
+			bits = _mm_or_si128(bits, _mm_slli_epi32(_QuantizeQuatSSE41(a, QUAT32_CENTER), 20));
+			bits = _mm_or_si128(bits, _mm_slli_epi32(_QuantizeQuatSSE41(b, QUAT32_CENTER), 10));
+			bits = _mm_or_si128(bits, _QuantizeQuatSSE41(c, QUAT32_CENTER));
+			_mm_storeu_si128((__m128i*)&out[i], bits);
+		}
+		return i;
+	}
+
+	ENGINE_TARGET_SSE41 static size_t _UnpackQuat32SSE41(const QuatPacked32* in, Quat* out, size_t count)
+	{
+		__m128i mask = _mm_set1_epi32(1023);
+
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128i bits = _mm_loadu_si128((const __m128i*)&in[i]);
+			__m128 a = _DequantizeQuatSSE41(_mm_and_si128(_mm_srli_epi32(bits, 20), mask), QUAT32_CENTER);
+			__m128 b = _DequantizeQuatSSE41(_mm_and_si128(_mm_srli_epi32(bits, 10), mask), QUAT32_CENTER);
+			__m128 c = _DequantizeQuatSSE41(_mm_and_si128(bits, mask), QUAT32_CENTER);
+			_FromSmallestThreeSSE41(_mm_srli_epi32(bits, 30), a, b, c, out + i);
+		}
+		return i;
+	}
+
+	ENGINE_TARGET_SSE41 static size_t _PackQuat48SSE41(const Quat* in, QuatPacked48* out, size_t count)
+	{
+		__m128i one = _mm_set1_epi32(1);
+
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 a, b, c;
+			__m128i m = _SmallestThreeSSE41(in + i, a, b, c);
+
+			__m128i qa = _mm_or_si128(_QuantizeQuatSSE41(a, QUAT48_CENTER), _mm_slli_epi32(_mm_srli_epi32(m, 1), 15));
+			__m128i qb = _mm_or_si128(_QuantizeQuatSSE41(b, QUAT48_CENTER), _mm_slli_epi32(_mm_and_si128(m, one), 15));
+			_Store3x16(out[i].v, qa, qb, _QuantizeQuatSSE41(c, QUAT48_CENTER));
+		}
+		return i;
+	}
+
+	ENGINE_TARGET_SSE41 static size_t _UnpackQuat48SSE41(const QuatPacked48* in, Quat* out, size_t count)
+	{
+		__m128i mask = _mm_set1_epi32(0x7fff);
+
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128i qa, qb, qc;
+			_Load3x16(in[i].v, qa, qb, qc);
+
+			__m128i m = _mm_or_si128(_mm_slli_epi32(_mm_srli_epi32(qa, 15), 1), _mm_srli_epi32(qb, 15));
+			__m128 a = _DequantizeQuatSSE41(_mm_and_si128(qa, mask), QUAT48_CENTER);
+			__m128 b = _DequantizeQuatSSE41(_mm_and_si128(qb, mask), QUAT48_CENTER);
+			__m128 c = _DequantizeQuatSSE41(_mm_and_si128(qc, mask), QUAT48_CENTER);
+			_FromSmallestThreeSSE41(m, a, b, c, out + i);
+		}
+		return i;
+	}
+
+	ENGINE_TARGET_SSE41 static size_t _PackQuantizedSSE41(const Vec3* in, const Vec3& mins, const Vec3& scale, Vec3Quantized16* out, size_t count)
+	{
+		__m128 mx = _mm_set1_ps(mins.x), my = _mm_set1_ps(mins.y), mz = _mm_set1_ps(mins.z);
+		__m128 sx = _mm_set1_ps(scale.x), sy = _mm_set1_ps(scale.y), sz = _mm_set1_ps(scale.z);
+		__m128 zero = _mm_setzero_ps(), maxv = _mm_set1_ps(QUANT16_MAX);
+
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 x, y, z;
+			SIMD::LoadVec3x4(in[i].f, x, y, z);
+
+			x = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(x, mx), sx), zero), maxv);
+			y = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(y, my), sy), zero), maxv);
+			z = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(z, mz), sz), zero), maxv);
+			_Store3x16(&out[i].x, _mm_cvtps_epi32(x), _mm_cvtps_epi32(y), _mm_cvtps_epi32(z));
+		}
+		return i;
+	}
+
+	ENGINE_TARGET_SSE41 static size_t _UnpackQuantizedSSE41(const Vec3Quantized16* in, const Vec3& mins, const Vec3& step, Vec3* out, size_t count)
+	{
+		__m128 mx = _mm_set1_ps(mins.x), my = _mm_set1_ps(mins.y), mz = _mm_set1_ps(mins.z);
+		__m128 sx = _mm_set1_ps(step.x), sy = _mm_set1_ps(step.y), sz = _mm_set1_ps(step.z);
+
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128i x, y, z;
+			_Load3x16(&in[i].x, x, y, z);
+			SIMD::StoreVec3x4(out[i].f,
+				_mm_add_ps(mx, _mm_mul_ps(_mm_cvtepi32_ps(x), sx)),
+				_mm_add_ps(my, _mm_mul_ps(_mm_cvtepi32_ps(y), sy)),
+				_mm_add_ps(mz, _mm_mul_ps(_mm_cvtepi32_ps(z), sz)));
+		}
+		return i;
+	}
+#endif
+
+	/*
+	The kernels are bound by loads/stores and shuffles, AVX2 uses the SSE4.1 ones
+	*/
+	namespace Utils
+	{
+		void Pack(const Vec3* in, Vec3Half* out, size_t count)
+		{
+			size_t i = 0;
+			SIMD_DISPATCH_SSE41(i, _PackHalf, in, out, count);
+			for (; i < count; i++)
+				out[i] = Vec3Half(in[i]);
+		}
+
+		void Unpack(const Vec3Half* in, Vec3* out, size_t count)
+		{
+			size_t i = 0;
+			SIMD_DISPATCH_SSE41(i, _UnpackHalf, in, out, count);
+			for (; i < count; i++)
+				out[i] = in[i].ToVec3();
+		}
+
+		void Pack(const Vec3* in, OctNormal* out, size_t count)
+		{
+			size_t i = 0;
+			SIMD_DISPATCH_SSE41(i, _PackOct, in, out, count);
+			for (; i < count; i++)
+				out[i] = OctNormal(in[i]);
+		}
+
+		void Unpack(const OctNormal* in, Vec3* out, size_t count)
+		{
+			size_t i = 0;
+			SIMD_DISPATCH_SSE41(i, _UnpackOct, in, out, count);
+			for (; i < count; i++)
+				out[i] = in[i].ToVec3();
+		}
+
+		void Pack(const Quat* in, QuatPacked32* out, size_t count)
+		{
+			size_t i = 0;
+			SIMD_DISPATCH_SSE41(i, _PackQuat32, in, out, count);
+			for (; i < count; i++)
+				out[i] = QuatPacked32(in[i]);
+		}
+
+		void Unpack(const QuatPacked32* in, Quat* out, size_t count)
+		{
+			size_t i = 0;
+			SIMD_DISPATCH_SSE41(i, _UnpackQuat32, in, out, count);
+			for (; i < count; i++)
+				out[i] = in[i].ToQuat();
+		}
+
+		void Pack(const Quat* in, QuatPacked48* out, size_t count)
+		{
+			size_t i = 0;
+			SIMD_DISPATCH_SSE41(i, _PackQuat48, in, out, count);
+			for (; i < count; i++)
+				out[i] = QuatPacked48(in[i]);
+		}
+
+		void Unpack(const QuatPacked48* in, Quat* out, size_t count)
+		{
+			size_t i = 0;
+			SIMD_DISPATCH_SSE41(i, _UnpackQuat48, in, out, count);
+			for (; i < count; i++)
+				out[i] = in[i].ToQuat();
+		}
+
+		void Pack(const Vec3* in, const BBox& box, Vec3Quantized16* out, size_t count)
+		{
+			size_t i = 0;
+			SIMD_DISPATCH_SSE41(i, _PackQuantized, in, box.mins, _QuantizeScale(box), out, count);
+			for (; i < count; i++)
+				out[i] = Vec3Quantized16(in[i], box);
+		}
+
+		void Unpack(const Vec3Quantized16* in, const BBox& box, Vec3* out, size_t count)
+		{
+			size_t i = 0;
+			SIMD_DISPATCH_SSE41(i, _UnpackQuantized, in, box.mins, (box.maxes - box.mins) * (1.0f / QUANT16_MAX), out, count);
+			for (; i < count; i++)
+				out[i] = in[i].ToVec3(box);
+		}
+	}
+}
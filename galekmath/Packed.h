@@ -0,0 +1,129 @@
+/* Copyright (C) 2009-2020, Nick Galko Ltd. All rights reserved.
+*
+* This file is part of the NGTech (https://galek.github.io/portfolio/).
+*
+* Your use and or redistribution of this software in source and / or
+* binary form, with or without modification, is subject to: (i) your
+* ongoing acceptance of and compliance with the terms and conditions of
+* the NGTech License Agreement; and (ii) your inclusion of this notice
+* in any version of this software that you use or redistribute.
+* A copy of the NGTech License Agreement is available by contacting
+* Nick Galko Ltd. at https://galek.github.io/portfolio/
+*/
+#pragma once
+
+//***************************************************************************
+#include <stdint.h>
+//***************************************************************************
+#include "MathLib.h"
+//***************************************************************************
+
+namespace NGTech
+{
+	class BBox;
+
+	/**
+	Vec3 as three IEEE 754 half floats (round to nearest even, denormals, inf and NaN are kept)
+	*/
+	class Vec3Half
+	{
+	public:
+		uint16_t x, y, z;
+
+		constexpr Vec3Half() : x(0), y(0), z(0) {}
+		explicit Vec3Half(const Vec3& v);
+		Vec3 ToVec3() const;
+
+		static uint16_t FloatToHalf(float f);
+		static float HalfToFloat(uint16_t h);
+	};
+
+	/**
+	Unit vector in octahedral encoding, two snorm16 values.
+	Max angular error is about 0.005 degrees
+	*/
+	class OctNormal
+	{
+	public:
+		int16_t x, y;
+
+		constexpr OctNormal() : x(0), y(0) {}
+		/**
+		n does not have to be normalized, but must not be zero
+		*/
+		explicit OctNormal(const Vec3& n);
+		/**
+		Returns a normalized vector
+		*/
+		Vec3 ToVec3() const;
+	};
+
+	/**
+	Unit quaternion, smallest three: the largest component is dropped (its sign is folded
+	into the others) and the rest is stored as 10 bits each, index of the dropped one in the top 2 bits.
+	Max component error is about 1.5e-3
+	*/
+	class QuatPacked32
+	{
+	public:
+		uint32_t bits;
+
+		constexpr QuatPacked32() : bits(3u << 30 | 511u << 20 | 511u << 10 | 511u) {}
+		explicit QuatPacked32(const Quat& q);
+		Quat ToQuat() const;
+	};
+
+	/**
+	Same with 15 bits per component, the index is in the top bits of v[0] and v[1].
+	Max component error is about 5e-5
+	*/
+	class QuatPacked48
+	{
+	public:
+		uint16_t v[3];
+
+		constexpr QuatPacked48() : v{ 0x8000 | 16383, 0x8000 | 16383, 16383 } {}
+		explicit QuatPacked48(const Quat& q);
+		Quat ToQuat() const;
+	};
+
+	/**
+	Position quantized to 16 bits per axis inside a bounding box, points outside are clamped.
+	The same box has to be used for decoding
+	*/
+	class Vec3Quantized16
+	{
+	public:
+		uint16_t x, y, z;
+
+		constexpr Vec3Quantized16() : x(0), y(0), z(0) {}
+		Vec3Quantized16(const Vec3& p, const BBox& box);
+		Vec3 ToVec3(const BBox& box) const;
+	};
+
+	static_assert(sizeof(Vec3Half) == 6, "Invalid Vec3Half padding!");
+	static_assert(sizeof(OctNormal) == 4, "Invalid OctNormal padding!");
+	static_assert(sizeof(QuatPacked32) == 4, "Invalid QuatPacked32 padding!");
+	static_assert(sizeof(QuatPacked48) == 6, "Invalid QuatPacked48 padding!");
+	static_assert(sizeof(Vec3Quantized16) == 6, "Invalid Vec3Quantized16 padding!");
+
+	namespace Utils
+	{
+		/**
+		Bulk versions of the constructors and ToVec3/ToQuat, same results
+		*/
+		void Pack(const Vec3* in, Vec3Half* out, size_t count);
+		void Unpack(const Vec3Half* in, Vec3* out, size_t count);
+
+		void Pack(const Vec3* in, OctNormal* out, size_t count);
+		void Unpack(const OctNormal* in, Vec3* out, size_t count);
+
+		void Pack(const Quat* in, QuatPacked32* out, size_t count);
+		void Unpack(const QuatPacked32* in, Quat* out, size_t count);
+		void Pack(const Quat* in, QuatPacked48* out, size_t count);
+		void Unpack(const QuatPacked48* in, Quat* out, size_t count);
+
+		void Pack(const Vec3* in, const BBox& box, Vec3Quantized16* out, size_t count);
+		void Unpack(const Vec3Quantized16* in, const BBox& box, Vec3* out, size_t count);
+	}
+}
@@ -0,0 +1,159 @@
+/* Copyright (C) 2009-2020, Nick Galko Ltd. All rights reserved.
+*
+* This file is part of the NGTech (https://galek.github.io/portfolio/).
+*
+* Your use and or redistribution of this software in source and / or
+* binary form, with or without modification, is subject to: (i) your
+* ongoing acceptance of and compliance with the terms and conditions of
+* the NGTech License Agreement; and (ii) your inclusion of this notice
+* in any version of this software that you use or redistribute.
+* A copy of the NGTech License Agreement is available by contacting
+* Nick Galko Ltd. at https://galek.github.io/portfolio/
+*/
+//***************************************************************************
+#include "Parallel.h"
+#include "MathLib.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+//***************************************************************************
+
+namespace NGTech
+{
+	static unsigned int& _ThreadCount()
+	{
+		static unsigned int count = 0;
+		return count;
+	}
+
+	unsigned int Parallel::GetThreadCount()
+	{
+		unsigned int count = _ThreadCount();
+		if (count == 0)
+			count = std::thread::hardware_concurrency();
+		return (count == 0) ? 1 : count;
+	}
+
+	void Parallel::SetThreadCount(unsigned int _count)
+	{
+		_ThreadCount() = _count;
+	}
+
+	size_t Parallel::GetRangeCount(size_t count, size_t minRange)
+	{
+		if (minRange == 0)
+			minRange = 1;
+
+		size_t ranges = count / minRange;
+		size_t threads = GetThreadCount();
+		return (ranges < threads) ? ranges : threads;
+	}
+
+	/*
+	One For() call. Range i is [count * i / ranges, count * (i + 1) / ranges),
+	next and left are guarded by the pool mutex.
+	*/
+	struct _Job
+	{
+		size_t count;
+		size_t ranges;
+		size_t next;		// first range not taken yet
+		size_t left;		// ranges not finished yet
+		void(*call)(const void*, size_t, size_t);
+		const void* func;
+	};
+
+	/*
+	Workers sleep until a job is queued and take its ranges one by one.
+	A job leaves the queue when its last range is taken, the caller waits for the rest to finish.
+	*/
+	class _Pool
+	{
+	public:
+		~_Pool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				m_bQuit = true;
+			}
+			m_Wake.notify_all();
+
+			for (size_t i = 0; i < m_Threads.size(); i++)
+				m_Threads[i].join();
+		}
+
+		void Run(_Job& job)
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+
+			// the caller takes ranges as well, so ranges - 1 workers are enough
+			size_t workers = Math::Min(job.ranges - 1, (size_t)Parallel::GetThreadCount() - 1);
+			while (m_Threads.size() < workers)
+				m_Threads.emplace_back(&_Pool::_Worker, this);
+
+			m_Jobs.push_back(&job);
+			lock.unlock();
+			m_Wake.notify_all();
+			lock.lock();
+
+			while (job.next < job.ranges)
+				_RunRange(job, lock);
+
+			m_Finished.wait(lock, [&job]() { return job.left == 0; });
+		}
+
+	private:
+		/*
+		Called with the mutex locked and a range left in the job
+		*/
+		void _RunRange(_Job& job, std::unique_lock<std::mutex>& lock)
+		{
+			size_t i = job.next++;
+			if (job.next == job.ranges) {
+				for (size_t j = 0; j < m_Jobs.size(); j++) {
+					if (m_Jobs[j] == &job) {
+						m_Jobs.erase(m_Jobs.begin() + j);
+						break;
+					}
+				}
+			}
+
+			lock.unlock();
+			job.call(job.func, job.count * i / job.ranges, job.count * (i + 1) / job.ranges);
+			lock.lock();
+
+			if (--job.left == 0)
+				m_Finished.notify_all();
+		}
+
+		void _Worker()
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			while (true)
+			{
+				m_Wake.wait(lock, [this]() { return m_bQuit || !m_Jobs.empty(); });
+				if (m_bQuit)
+					return;
+
+				_RunRange(*m_Jobs.front(), lock);
+			}
+		}
+
+		std::mutex m_Mutex;
+		std::condition_variable m_Wake;
+		std::condition_variable m_Finished;
+		std::deque<_Job*> m_Jobs;
+		std::vector<std::thread> m_Threads;
+		bool m_bQuit = false;
+	};
+
+	void Parallel::_Run(size_t count, size_t ranges, _RangeFunc call, const void* func)
+	{
+		static _Pool pool;
+
+		_Job job = { count, ranges, 0, ranges, call, func };
+		pool.Run(job);
+	}
+}
@@ -0,0 +1,100 @@
+/* Copyright (C) 2009-2020, Nick Galko Ltd. All rights reserved.
+*
+* This file is part of the NGTech (https://galek.github.io/portfolio/).
+*
+* Your use and or redistribution of this software in source and / or
+* binary form, with or without modification, is subject to: (i) your
+* ongoing acceptance of and compliance with the terms and conditions of
+* the NGTech License Agreement; and (ii) your inclusion of this notice
+* in any version of this software that you use or redistribute.
+* A copy of the NGTech License Agreement is available by contacting
+* Nick Galko Ltd. at https://galek.github.io/portfolio/
+*/
+#pragma once
+
+#include "galekmath_config.h"
+
+//***************************************************************************
+#include <cstddef>
+#include <vector>
+//***************************************************************************
+
+namespace NGTech
+{
+	/**
+	Splitting of the bulk functions over several threads.
+	Worker threads are started on first use and reused by later calls,
+	a call still has to hand over and wait for its ranges, so it only pays off for large arrays.
+	*/
+	struct Parallel
+	{
+		/**
+		Maximum number of threads used by one call. By default std::thread::hardware_concurrency()
+		*/
+		static unsigned int GetThreadCount();
+		/**
+		1 disables threading, 0 restores the default
+		*/
+		static void SetThreadCount(unsigned int _count);
+
+		/**
+		Splits [0, count) in ranges of at least minRange elements and calls func(begin, end)
+		for each of them. The calling thread processes ranges too and returns when all of them are done,
+		so func may call For() again.
+		*/
+		template<typename F>
+		static void For(size_t count, size_t minRange, const F& func)
+		{
+			size_t ranges = GetRangeCount(count, minRange);
+			if (ranges <= 1) {
+				if (count > 0)
+					func((size_t)0, count);
+				return;
+			}
+
+			_Run(count, ranges, &_Call<F>, &func);
+		}
+
+		/**
+		Per-range reduction over [0, count): every range starts from a copy of identity and
+		func(begin, end, state) fills it, then merge(result, state) folds the states in range order,
+		so the result does not depend on which thread finished first.
+		*/
+		template<typename STATE, typename F, typename M>
+		static STATE Reduce(size_t count, size_t minRange, const STATE& identity, const F& func, const M& merge)
+		{
+			size_t ranges = GetRangeCount(count, minRange);
+			if (ranges <= 1) {
+				STATE result = identity;
+				func((size_t)0, count, result);
+				return result;
+			}
+
+			std::vector<STATE> states(ranges, identity);
+			For(ranges, 1, [&](size_t first, size_t last)
+			{
+				for (size_t r = first; r < last; r++)
+					func(count * r / ranges, count * (r + 1) / ranges, states[r]);
+			});
+
+			for (size_t r = 1; r < ranges; r++)
+				merge(states[0], states[r]);
+			return states[0];
+		}
+
+		/**
+		Number of ranges For() would use
+		*/
+		static size_t GetRangeCount(size_t count, size_t minRange);
+
+	private:
+		typedef void(*_RangeFunc)(const void* func, size_t begin, size_t end);
+
+		template<typename F>
+		static void _Call(const void* func, size_t begin, size_t end) {
+			(*static_cast<const F*>(func))(begin, end);
+		}
+
+		static void _Run(size_t count, size_t ranges, _RangeFunc call, const void* func);
+	};
+}
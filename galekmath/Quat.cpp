@@ -18,21 +18,18 @@ namespace NGTech {
 	const Quat Quat::ZERO(0, 0, 0, 0);
 	/*
 	*/
-	Quat::Quat() {
-		Identity();
-	}
-
 	Quat::Quat(float angle, const Vec3 &axis) {
 		Vec3 vdir = axis;
 		float length = vdir.length();
 
 		if (length != 0.0) {
 			length = Math::ONEFLOAT / length;
-			float sinangle = sin(Math::DegreesToRadians(angle / 2.0f));
+			float sinangle, cosangle;
+			Math::SinCos(Math::DegreesToRadians(angle / 2.0f), sinangle, cosangle);
 			x = vdir.x * length * sinangle;
 			y = vdir.y * length * sinangle;
 			z = vdir.z * length * sinangle;
-			w = cos(Math::DegreesToRadians(angle / 2.0f));
+			w = cosangle;
 		}
 		else {
 			x = y = z = 0.0;
@@ -83,35 +80,6 @@ namespace NGTech {
 		}
 	}
 
-	Quat::Quat(float _x, float _y, float _z, float _w)
-		:x(_x), y(_y), z(_z), w(_w)
-	{}
-
-	Quat::operator float*() {
-		return (float*)&x;
-	}
-
-	Quat::operator const float*() const {
-		return (float*)&x;
-	}
-
-	float &Quat::operator[](intptr_t i) {
-		return ((float*)&x)[i];
-	}
-
-	const float Quat::operator[](intptr_t i) const {
-		return ((float*)&x)[i];
-	}
-
-	Quat Quat::operator*(const Quat &q) const {
-		Quat ret;
-		ret.x = w * q.x + x * q.x + y * q.z - z * q.y;
-		ret.y = w * q.y + y * q.w + z * q.x - x * q.z;
-		ret.z = w * q.z + z * q.w + x * q.y - y * q.x;
-		ret.w = w * q.w - x * q.x - y * q.y - z * q.z;
-		return ret;
-	}
-
 	Quat Quat::slerp(const Quat &q0, const Quat &q1, float t) {
 		float k0, k1, cosomega = q0.x * q1.x + q0.y * q1.y + q0.z * q1.z + q0.w * q1.w;
 
@@ -131,10 +99,10 @@ namespace NGTech {
 		}
 
 		if (1.0 - cosomega > 1e-6) {
-			float omega = acos(cosomega);
-			float sinomega = sin(omega);
-			k0 = sin((Math::ONEFLOAT - t) * omega) / sinomega;
-			k1 = sin(t * omega) / sinomega;
+			float omega = Math::ACos(cosomega);
+			float sinomega = Math::Sin(omega);
+			k0 = Math::Sin((Math::ONEFLOAT - t) * omega) / sinomega;
+			k1 = Math::Sin(t * omega) / sinomega;
 		}
 		else {
 			k0 = Math::ONEFLOAT - t;
@@ -168,4 +136,8 @@ namespace NGTech {
 		r[2] = xz - wy;          r[5] = yz + wx;          r[8] = Math::ONEFLOAT - (xx + yy);
 		return r;
 	}
-}
\ No newline at end of file
+}
+
+#if !GALEKMATH_HEADER_ONLY
+#include "Quat.inl"
+#endif
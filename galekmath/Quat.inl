@@ -0,0 +1,45 @@
+/* Copyright (C) 2009-2020, Nick Galko Ltd. All rights reserved.
+*
+* This file is part of the NGTech (https://galek.github.io/portfolio/).
+*
+* Your use and or redistribution of this software in source and / or
+* binary form, with or without modification, is subject to: (i) your
+* ongoing acceptance of and compliance with the terms and conditions of
+* the NGTech License Agreement; and (ii) your inclusion of this notice
+* in any version of this software that you use or redistribute.
+* A copy of the NGTech License Agreement is available by contacting
+* Nick Galko Ltd. at https://galek.github.io/portfolio/
+*/
+//***************************************************************************
+// Included by MathLib.h with GALEKMATH_HEADER_ONLY, by Quat.cpp otherwise.
+//***************************************************************************
+
+namespace NGTech
+{
+	/*
+	*/
+	MATH_HEADER_INLINE Quat::operator float*() {
+		return (float*)&x;
+	}
+
+	MATH_HEADER_INLINE Quat::operator const float*() const {
+		return (float*)&x;
+	}
+
+	MATH_HEADER_INLINE float &Quat::operator[](intptr_t i) {
+		return ((float*)&x)[i];
+	}
+
+	MATH_HEADER_INLINE const float Quat::operator[](intptr_t i) const {
+		return ((float*)&x)[i];
+	}
+
+	MATH_HEADER_INLINE Quat Quat::operator*(const Quat &q) const {
+		Quat ret;
+		ret.x = w * q.x + x * q.x + y * q.z - z * q.y;
+		ret.y = w * q.y + y * q.w + z * q.x - x * q.z;
+		ret.z = w * q.z + z * q.w + x * q.y - y * q.x;
+		ret.w = w * q.w - x * q.x - y * q.y - z * q.z;
+		return ret;
+	}
+}
@@ -0,0 +1,580 @@
+/* Copyright (C) 2009-2020, Nick Galko Ltd. All rights reserved.
+*
+* This file is part of the NGTech (https://galek.github.io/portfolio/).
+*
+* Your use and or redistribution of this software in source and / or
+* binary form, with or without modification, is subject to: (i) your
+* ongoing acceptance of and compliance with the terms and conditions of
+* the NGTech License Agreement; and (ii) your inclusion of this notice
+* in any version of this software that you use or redistribute.
+* A copy of the NGTech License Agreement is available by contacting
+* Nick Galko Ltd. at https://galek.github.io/portfolio/
+*/
+//***************************************************************************
+#include "QuatSoA.h"
+#include "SIMD.h"
+#include "FastMath.h"
+//***************************************************************************
+
+namespace NGTech
+{
+	/*
+	sin(t * angle) / sin(angle) as a polynomial of x - 1, x = cos(angle) (D. Eberly,
+	"A Fast and Accurate Algorithm for Computing SLERP"). The series is cut after 8 terms,
+	the last one is scaled by 1 + mu to balance the error over x in [0, 1].
+	*/
+	static const int SLERP_TERMS = 8;
+	static const float SLERP_ONE_PLUS_MU = 1.85298109240830f;
+	static const float SLERP_U[SLERP_TERMS] = {
+		1.0f / 3.0f, 1.0f / 10.0f, 1.0f / 21.0f, 1.0f / 36.0f,
+		1.0f / 55.0f, 1.0f / 78.0f, 1.0f / 105.0f, SLERP_ONE_PLUS_MU / 136.0f
+	};
+	static const float SLERP_V[SLERP_TERMS] = {
+		1.0f / 3.0f, 2.0f / 5.0f, 3.0f / 7.0f, 4.0f / 9.0f,
+		5.0f / 11.0f, 6.0f / 13.0f, 7.0f / 15.0f, SLERP_ONE_PLUS_MU * 8.0f / 17.0f
+	};
+
+	static ENGINE_INLINE float _SlerpWeight(float t, float xm1)
+	{
+		float t2 = t * t;
+		float c = Math::ONEFLOAT;
+		for (int k = SLERP_TERMS - 1; k >= 0; k--)
+			c = Math::ONEFLOAT + (SLERP_U[k] * t2 - SLERP_V[k]) * xm1 * c;
+		return t * c;
+	}
+
+	/*
+	Remaps t for nlerp by a fit over |cos(angle)| (A. Kapoulkine, "Approximating slerp")
+	*/
+	static ENGINE_INLINE float _NlerpCorrect(float t, float d)
+	{
+		float A = 1.0904f + d * (-3.2452f + d * (3.55645f - d * 1.43519f));
+		float B = 0.848013f + d * (-1.06021f + d * 0.215638f);
+		float k = A * (t - 0.5f) * (t - 0.5f) + B;
+		return t + t * (t - 0.5f) * (t - Math::ONEFLOAT) * k;
+	}
+
+	/*
+	Kernels return how many elements they processed, the rest is done by the scalar loop.
+	t is either one value (tStep = 0) or one per element (tStep = 1).
+	*/
+#if MATH_SIMD_X86
+	/*
+	Dot products sum in the order of the scalar code without fma, and the hemisphere
+	is d < 0 like there, so every level and the tails flip the same elements
+	*/
+	ENGINE_TARGET_SSE41 static ENGINE_INLINE __m128 _DotSSE41(__m128 ax, __m128 ay, __m128 az, __m128 aw, __m128 bx, __m128 by, __m128 bz, __m128 bw)
+	{
+		return _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz)), _mm_mul_ps(aw, bw));
+	}
+
+	ENGINE_TARGET_AVX2 static ENGINE_INLINE __m256 _DotAVX2(__m256 ax, __m256 ay, __m256 az, __m256 aw, __m256 bx, __m256 by, __m256 bz, __m256 bw)
+	{
+		return _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax, bx), _mm256_mul_ps(ay, by)), _mm256_mul_ps(az, bz)), _mm256_mul_ps(aw, bw));
+	}
+
+	ENGINE_TARGET_SSE41 static ENGINE_INLINE __m128 _HemisphereSSE41(__m128 d)
+	{
+		return _mm_and_ps(_mm_cmplt_ps(d, _mm_setzero_ps()), _mm_set1_ps(-0.0f));
+	}
+
+	ENGINE_TARGET_AVX2 static ENGINE_INLINE __m256 _HemisphereAVX2(__m256 d)
+	{
+		return _mm256_and_ps(_mm256_cmp_ps(d, _mm256_setzero_ps(), _CMP_LT_OQ), _mm256_set1_ps(-0.0f));
+	}
+
+	/*
+	Same as the scalar _RcpLength
+	*/
+	ENGINE_TARGET_SSE41 static ENGINE_INLINE __m128 _RcpLengthSSE41(__m128 x, __m128 y, __m128 z, __m128 w)
+	{
+		return FastSIMD::rsqrt(_DotSSE41(x, y, z, w, x, y, z, w));
+	}
+
+	ENGINE_TARGET_AVX2 static ENGINE_INLINE __m256 _RcpLengthAVX2(__m256 x, __m256 y, __m256 z, __m256 w)
+	{
+		return FastSIMD::rsqrt(_DotAVX2(x, y, z, w, x, y, z, w));
+	}
+
+	ENGINE_TARGET_SSE41 static size_t _SlerpSSE41(const QuatSoA& a, const QuatSoA& b, const float* t, size_t tStep, QuatSoA& out, size_t n)
+	{
+		const __m128 one = _mm_set1_ps(1.0f);
+
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4) {
+			__m128 ax = _mm_load_ps(a.x + i), ay = _mm_load_ps(a.y + i), az = _mm_load_ps(a.z + i), aw = _mm_load_ps(a.w + i);
+			__m128 bx = _mm_load_ps(b.x + i), by = _mm_load_ps(b.y + i), bz = _mm_load_ps(b.z + i), bw = _mm_load_ps(b.w + i);
+
+			__m128 d = _DotSSE41(ax, ay, az, aw, bx, by, bz, bw);
+			__m128 sign = _HemisphereSSE41(d);
+			__m128 xm1 = _mm_sub_ps(_mm_xor_ps(d, sign), one);
+
+			__m128 vt = tStep ? _mm_loadu_ps(t + i) : _mm_set1_ps(*t);
+			__m128 vs = _mm_sub_ps(one, vt);
+			__m128 t2 = _mm_mul_ps(vt, vt);
+			__m128 s2 = _mm_mul_ps(vs, vs);
+
+			__m128 ct = one, cs = one;
+			for (int k = SLERP_TERMS - 1; k >= 0; k--) {
+				__m128 u = _mm_set1_ps(SLERP_U[k]);
+				__m128 v = _mm_set1_ps(SLERP_V[k]);
+				ct = _mm_add_ps(one, _mm_mul_ps(_mm_mul_ps(_mm_sub_ps(_mm_mul_ps(u, t2), v), xm1), ct));
+				cs = _mm_add_ps(one, _mm_mul_ps(_mm_mul_ps(_mm_sub_ps(_mm_mul_ps(u, s2), v), xm1), cs));
+			}
+
+			__m128 ka = _mm_mul_ps(vs, cs);
+			__m128 kb = _mm_xor_ps(_mm_mul_ps(vt, ct), sign);
+
+			_mm_store_ps(out.x + i, _mm_add_ps(_mm_mul_ps(ax, ka), _mm_mul_ps(bx, kb)));
+			_mm_store_ps(out.y + i, _mm_add_ps(_mm_mul_ps(ay, ka), _mm_mul_ps(by, kb)));
+			_mm_store_ps(out.z + i, _mm_add_ps(_mm_mul_ps(az, ka), _mm_mul_ps(bz, kb)));
+			_mm_store_ps(out.w + i, _mm_add_ps(_mm_mul_ps(aw, ka), _mm_mul_ps(bw, kb)));
+		}
+		return i;
+	}
+
+	ENGINE_TARGET_AVX2 static size_t _SlerpAVX2(const QuatSoA& a, const QuatSoA& b, const float* t, size_t tStep, QuatSoA& out, size_t n)
+	{
+		const __m256 one = _mm256_set1_ps(1.0f);
+
+		size_t i = 0;
+		for (; i + 8 <= n; i += 8) {
+			__m256 ax = _mm256_load_ps(a.x + i), ay = _mm256_load_ps(a.y + i), az = _mm256_load_ps(a.z + i), aw = _mm256_load_ps(a.w + i);
+			__m256 bx = _mm256_load_ps(b.x + i), by = _mm256_load_ps(b.y + i), bz = _mm256_load_ps(b.z + i), bw = _mm256_load_ps(b.w + i);
+
+			__m256 d = _DotAVX2(ax, ay, az, aw, bx, by, bz, bw);
+			__m256 sign = _HemisphereAVX2(d);
+			__m256 xm1 = _mm256_sub_ps(_mm256_xor_ps(d, sign), one);
+
+			__m256 vt = tStep ? _mm256_loadu_ps(t + i) : _mm256_set1_ps(*t);
+			__m256 vs = _mm256_sub_ps(one, vt);
+			__m256 t2 = _mm256_mul_ps(vt, vt);
+			__m256 s2 = _mm256_mul_ps(vs, vs);
+
+			__m256 ct = one, cs = one;
+			for (int k = SLERP_TERMS - 1; k >= 0; k--) {
+				__m256 u = _mm256_set1_ps(SLERP_U[k]);
+				__m256 v = _mm256_set1_ps(SLERP_V[k]);
+				ct = _mm256_fmadd_ps(_mm256_mul_ps(_mm256_fmsub_ps(u, t2, v), xm1), ct, one);
+				cs = _mm256_fmadd_ps(_mm256_mul_ps(_mm256_fmsub_ps(u, s2, v), xm1), cs, one);
+			}
+
+			__m256 ka = _mm256_mul_ps(vs, cs);
+			__m256 kb = _mm256_xor_ps(_mm256_mul_ps(vt, ct), sign);
+
+			_mm256_store_ps(out.x + i, _mm256_fmadd_ps(ax, ka, _mm256_mul_ps(bx, kb)));
+			_mm256_store_ps(out.y + i, _mm256_fmadd_ps(ay, ka, _mm256_mul_ps(by, kb)));
+			_mm256_store_ps(out.z + i, _mm256_fmadd_ps(az, ka, _mm256_mul_ps(bz, kb)));
+			_mm256_store_ps(out.w + i, _mm256_fmadd_ps(aw, ka, _mm256_mul_ps(bw, kb)));
+		}
+		return i;
+	}
+
+	ENGINE_TARGET_SSE41 static size_t _NlerpSSE41(const QuatSoA& a, const QuatSoA& b, const float* t, size_t tStep, bool corrected, QuatSoA& out, size_t n)
+	{
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 half = _mm_set1_ps(0.5f);
+
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4) {
+			__m128 ax = _mm_load_ps(a.x + i), ay = _mm_load_ps(a.y + i), az = _mm_load_ps(a.z + i), aw = _mm_load_ps(a.w + i);
+			__m128 bx = _mm_load_ps(b.x + i), by = _mm_load_ps(b.y + i), bz = _mm_load_ps(b.z + i), bw = _mm_load_ps(b.w + i);
+
+			__m128 d = _DotSSE41(ax, ay, az, aw, bx, by, bz, bw);
+			__m128 sign = _HemisphereSSE41(d);
+			__m128 vt = tStep ? _mm_loadu_ps(t + i) : _mm_set1_ps(*t);
+
+			if (corrected) {
+				d = _mm_xor_ps(d, sign);
+				__m128 A = _mm_add_ps(_mm_set1_ps(3.55645f), _mm_mul_ps(d, _mm_set1_ps(-1.43519f)));
+				A = _mm_add_ps(_mm_set1_ps(-3.2452f), _mm_mul_ps(d, A));
+				A = _mm_add_ps(_mm_set1_ps(1.0904f), _mm_mul_ps(d, A));
+				__m128 B = _mm_add_ps(_mm_set1_ps(-1.06021f), _mm_mul_ps(d, _mm_set1_ps(0.215638f)));
+				B = _mm_add_ps(_mm_set1_ps(0.848013f), _mm_mul_ps(d, B));
+				__m128 th = _mm_sub_ps(vt, half);
+				__m128 k = _mm_add_ps(_mm_mul_ps(A, _mm_mul_ps(th, th)), B);
+				vt = _mm_add_ps(vt, _mm_mul_ps(_mm_mul_ps(vt, th), _mm_mul_ps(_mm_sub_ps(vt, one), k)));
+			}
+
+			__m128 ka = _mm_sub_ps(one, vt);
+			__m128 kb = _mm_xor_ps(vt, sign);
+
+			__m128 x = _mm_add_ps(_mm_mul_ps(ax, ka), _mm_mul_ps(bx, kb));
+			__m128 y = _mm_add_ps(_mm_mul_ps(ay, ka), _mm_mul_ps(by, kb));
+			__m128 z = _mm_add_ps(_mm_mul_ps(az, ka), _mm_mul_ps(bz, kb));
+			__m128 w = _mm_add_ps(_mm_mul_ps(aw, ka), _mm_mul_ps(bw, kb));
+			__m128 r = _RcpLengthSSE41(x, y, z, w);
+
+			_mm_store_ps(out.x + i, _mm_mul_ps(x, r));
+			_mm_store_ps(out.y + i, _mm_mul_ps(y, r));
+			_mm_store_ps(out.z + i, _mm_mul_ps(z, r));
+			_mm_store_ps(out.w + i, _mm_mul_ps(w, r));
+		}
+		return i;
+	}
+
+	ENGINE_TARGET_AVX2 static size_t _NlerpAVX2(const QuatSoA& a, const QuatSoA& b, const float* t, size_t tStep, bool corrected, QuatSoA& out, size_t n)
+	{
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 half = _mm256_set1_ps(0.5f);
+
+		size_t i = 0;
+		for (; i + 8 <= n; i += 8) {
+			__m256 ax = _mm256_load_ps(a.x + i), ay = _mm256_load_ps(a.y + i), az = _mm256_load_ps(a.z + i), aw = _mm256_load_ps(a.w + i);
+			__m256 bx = _mm256_load_ps(b.x + i), by = _mm256_load_ps(b.y + i), bz = _mm256_load_ps(b.z + i), bw = _mm256_load_ps(b.w + i);
+
+			__m256 d = _DotAVX2(ax, ay, az, aw, bx, by, bz, bw);
+			__m256 sign = _HemisphereAVX2(d);
+			__m256 vt = tStep ? _mm256_loadu_ps(t + i) : _mm256_set1_ps(*t);
+
+			if (corrected) {
+				d = _mm256_xor_ps(d, sign);
+				__m256 A = _mm256_fmadd_ps(d, _mm256_set1_ps(-1.43519f), _mm256_set1_ps(3.55645f));
+				A = _mm256_fmadd_ps(d, A, _mm256_set1_ps(-3.2452f));
+				A = _mm256_fmadd_ps(d, A, _mm256_set1_ps(1.0904f));
+				__m256 B = _mm256_fmadd_ps(d, _mm256_set1_ps(0.215638f), _mm256_set1_ps(-1.06021f));
+				B = _mm256_fmadd_ps(d, B, _mm256_set1_ps(0.848013f));
+				__m256 th = _mm256_sub_ps(vt, half);
+				__m256 k = _mm256_fmadd_ps(A, _mm256_mul_ps(th, th), B);
+				vt = _mm256_fmadd_ps(_mm256_mul_ps(vt, th), _mm256_mul_ps(_mm256_sub_ps(vt, one), k), vt);
+			}
+
+			__m256 ka = _mm256_sub_ps(one, vt);
+			__m256 kb = _mm256_xor_ps(vt, sign);
+
+			__m256 x = _mm256_fmadd_ps(ax, ka, _mm256_mul_ps(bx, kb));
+			__m256 y = _mm256_fmadd_ps(ay, ka, _mm256_mul_ps(by, kb));
+			__m256 z = _mm256_fmadd_ps(az, ka, _mm256_mul_ps(bz, kb));
+			__m256 w = _mm256_fmadd_ps(aw, ka, _mm256_mul_ps(bw, kb));
+			__m256 r = _RcpLengthAVX2(x, y, z, w);
+
+			_mm256_store_ps(out.x + i, _mm256_mul_ps(x, r));
+			_mm256_store_ps(out.y + i, _mm256_mul_ps(y, r));
+			_mm256_store_ps(out.z + i, _mm256_mul_ps(z, r));
+			_mm256_store_ps(out.w + i, _mm256_mul_ps(w, r));
+		}
+		return i;
+	}
+
+	ENGINE_TARGET_SSE41 static size_t _BlendSSE41(const QuatSoA* inputs, const float* weights, size_t count, QuatSoA& out, size_t n)
+	{
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4) {
+			const QuatSoA& q0 = inputs[0];
+			__m128 rx = _mm_load_ps(q0.x + i), ry = _mm_load_ps(q0.y + i), rz = _mm_load_ps(q0.z + i), rw = _mm_load_ps(q0.w + i);
+
+			__m128 w0 = _mm_set1_ps(weights[0]);
+			__m128 x = _mm_mul_ps(rx, w0), y = _mm_mul_ps(ry, w0), z = _mm_mul_ps(rz, w0), w = _mm_mul_ps(rw, w0);
+
+			for (size_t k = 1; k < count; k++) {
+				const QuatSoA& q = inputs[k];
+				__m128 qx = _mm_load_ps(q.x + i), qy = _mm_load_ps(q.y + i), qz = _mm_load_ps(q.z + i), qw = _mm_load_ps(q.w + i);
+				__m128 d = _DotSSE41(rx, ry, rz, rw, qx, qy, qz, qw);
+				__m128 wk = _mm_xor_ps(_mm_set1_ps(weights[k]), _HemisphereSSE41(d));
+				x = _mm_add_ps(x, _mm_mul_ps(qx, wk));
+				y = _mm_add_ps(y, _mm_mul_ps(qy, wk));
+				z = _mm_add_ps(z, _mm_mul_ps(qz, wk));
+				w = _mm_add_ps(w, _mm_mul_ps(qw, wk));
+			}
+
+			__m128 r = _RcpLengthSSE41(x, y, z, w);
+			_mm_store_ps(out.x + i, _mm_mul_ps(x, r));
+			_mm_store_ps(out.y + i, _mm_mul_ps(y, r));
+			_mm_store_ps(out.z + i, _mm_mul_ps(z, r));
+			_mm_store_ps(out.w + i, _mm_mul_ps(w, r));
+		}
+		return i;
+	}
+
+	ENGINE_TARGET_AVX2 static size_t _BlendAVX2(const QuatSoA* inputs, const float* weights, size_t count, QuatSoA& out, size_t n)
+	{
+		size_t i = 0;
+		for (; i + 8 <= n; i += 8) {
+			const QuatSoA& q0 = inputs[0];
+			__m256 rx = _mm256_load_ps(q0.x + i), ry = _mm256_load_ps(q0.y + i), rz = _mm256_load_ps(q0.z + i), rw = _mm256_load_ps(q0.w + i);
+
+			__m256 w0 = _mm256_set1_ps(weights[0]);
+			__m256 x = _mm256_mul_ps(rx, w0), y = _mm256_mul_ps(ry, w0), z = _mm256_mul_ps(rz, w0), w = _mm256_mul_ps(rw, w0);
+
+			for (size_t k = 1; k < count; k++) {
+				const QuatSoA& q = inputs[k];
+				__m256 qx = _mm256_load_ps(q.x + i), qy = _mm256_load_ps(q.y + i), qz = _mm256_load_ps(q.z + i), qw = _mm256_load_ps(q.w + i);
+				__m256 d = _DotAVX2(rx, ry, rz, rw, qx, qy, qz, qw);
+				__m256 wk = _mm256_xor_ps(_mm256_set1_ps(weights[k]), _HemisphereAVX2(d));
+				x = _mm256_fmadd_ps(qx, wk, x);
+				y = _mm256_fmadd_ps(qy, wk, y);
+				z = _mm256_fmadd_ps(qz, wk, z);
+				w = _mm256_fmadd_ps(qw, wk, w);
+			}
+
+			__m256 r = _RcpLengthAVX2(x, y, z, w);
+			_mm256_store_ps(out.x + i, _mm256_mul_ps(x, r));
+			_mm256_store_ps(out.y + i, _mm256_mul_ps(y, r));
+			_mm256_store_ps(out.z + i, _mm256_mul_ps(z, r));
+			_mm256_store_ps(out.w + i, _mm256_mul_ps(w, r));
+		}
+		return i;
+	}
+
+	ENGINE_TARGET_SSE41 static size_t _NormalizeSSE41(const QuatSoA& a, QuatSoA& out, size_t n)
+	{
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4) {
+			__m128 x = _mm_load_ps(a.x + i), y = _mm_load_ps(a.y + i), z = _mm_load_ps(a.z + i), w = _mm_load_ps(a.w + i);
+			__m128 r = _RcpLengthSSE41(x, y, z, w);
+			_mm_store_ps(out.x + i, _mm_mul_ps(x, r));
+			_mm_store_ps(out.y + i, _mm_mul_ps(y, r));
+			_mm_store_ps(out.z + i, _mm_mul_ps(z, r));
+			_mm_store_ps(out.w + i, _mm_mul_ps(w, r));
+		}
+		return i;
+	}
+
+	ENGINE_TARGET_AVX2 static size_t _NormalizeAVX2(const QuatSoA& a, QuatSoA& out, size_t n)
+	{
+		size_t i = 0;
+		for (; i + 8 <= n; i += 8) {
+			__m256 x = _mm256_load_ps(a.x + i), y = _mm256_load_ps(a.y + i), z = _mm256_load_ps(a.z + i), w = _mm256_load_ps(a.w + i);
+			__m256 r = _RcpLengthAVX2(x, y, z, w);
+			_mm256_store_ps(out.x + i, _mm256_mul_ps(x, r));
+			_mm256_store_ps(out.y + i, _mm256_mul_ps(y, r));
+			_mm256_store_ps(out.z + i, _mm256_mul_ps(z, r));
+			_mm256_store_ps(out.w + i, _mm256_mul_ps(w, r));
+		}
+		return i;
+	}
+
+	/*
+	Packed Quat is already x, y, z, w so 4 of them are one transpose
+	*/
+	ENGINE_TARGET_SSE41 static size_t _FromQuatSSE41(const Quat* in, QuatSoA& out, size_t n)
+	{
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4) {
+			__m128 q0 = _mm_loadu_ps(in[i + 0].f), q1 = _mm_loadu_ps(in[i + 1].f);
+			__m128 q2 = _mm_loadu_ps(in[i + 2].f), q3 = _mm_loadu_ps(in[i + 3].f);
+			_MM_TRANSPOSE4_PS(q0, q1, q2, q3);
+			_mm_store_ps(out.x + i, q0);
+			_mm_store_ps(out.y + i, q1);
+			_mm_store_ps(out.z + i, q2);
+			_mm_store_ps(out.w + i, q3);
+		}
+		return i;
+	}
+
+	ENGINE_TARGET_SSE41 static size_t _ToQuatSSE41(const QuatSoA& in, Quat* out, size_t n)
+	{
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4) {
+			__m128 x = _mm_load_ps(in.x + i), y = _mm_load_ps(in.y + i);
+			__m128 z = _mm_load_ps(in.z + i), w = _mm_load_ps(in.w + i);
+			_MM_TRANSPOSE4_PS(x, y, z, w);
+			_mm_storeu_ps(out[i + 0].f, x);
+			_mm_storeu_ps(out[i + 1].f, y);
+			_mm_storeu_ps(out[i + 2].f, z);
+			_mm_storeu_ps(out[i + 3].f, w);
+		}
+		return i;
+	}
+
+#endif
+
+	/*
+	Scalar versions, also used for the tails
+	*/
+	static ENGINE_INLINE void _Store(QuatSoA& out, size_t i, float x, float y, float z, float w, float scale)
+	{
+		out.x[i] = x * scale;
+		out.y[i] = y * scale;
+		out.z[i] = z * scale;
+		out.w[i] = w * scale;
+	}
+
+	static ENGINE_INLINE float _RcpLength(float x, float y, float z, float w)
+	{
+		return Math::Fast::rsqrt(x * x + y * y + z * z + w * w);
+	}
+
+	static void _SlerpArray(const QuatSoA& a, const QuatSoA& b, const float* t, size_t tStep, QuatSoA& out)
+	{
+		ASSERT(a.Size() == b.Size(), "[QuatSoA] SIZE MISMATCH");
+		out.Resize(a.Size());
+
+		size_t i = 0, n = a.Size();
+		SIMD_DISPATCH(i, _Slerp, a, b, t, tStep, out, n);
+		for (; i < n; i++) {
+			float d = a.x[i] * b.x[i] + a.y[i] * b.y[i] + a.z[i] * b.z[i] + a.w[i] * b.w[i];
+			float sign = (d < 0) ? -Math::ONEFLOAT : Math::ONEFLOAT;
+			float ti = t[i * tStep];
+			float xm1 = d * sign - Math::ONEFLOAT;
+			float ka = _SlerpWeight(Math::ONEFLOAT - ti, xm1);
+			float kb = _SlerpWeight(ti, xm1) * sign;
+			_Store(out, i, a.x[i] * ka + b.x[i] * kb, a.y[i] * ka + b.y[i] * kb,
+				a.z[i] * ka + b.z[i] * kb, a.w[i] * ka + b.w[i] * kb, Math::ONEFLOAT);
+		}
+	}
+
+	static void _NlerpArray(const QuatSoA& a, const QuatSoA& b, const float* t, size_t tStep, bool corrected, QuatSoA& out)
+	{
+		ASSERT(a.Size() == b.Size(), "[QuatSoA] SIZE MISMATCH");
+		out.Resize(a.Size());
+
+		size_t i = 0, n = a.Size();
+		SIMD_DISPATCH(i, _Nlerp, a, b, t, tStep, corrected, out, n);
+		for (; i < n; i++) {
+			float d = a.x[i] * b.x[i] + a.y[i] * b.y[i] + a.z[i] * b.z[i] + a.w[i] * b.w[i];
+			float sign = (d < 0) ? -Math::ONEFLOAT : Math::ONEFLOAT;
+			float ti = t[i * tStep];
+			if (corrected)
+				ti = _NlerpCorrect(ti, d * sign);
+
+			float ka = Math::ONEFLOAT - ti;
+			float kb = ti * sign;
+			float x = a.x[i] * ka + b.x[i] * kb;
+			float y = a.y[i] * ka + b.y[i] * kb;
+			float z = a.z[i] * ka + b.z[i] * kb;
+			float w = a.w[i] * ka + b.w[i] * kb;
+			_Store(out, i, x, y, z, w, _RcpLength(x, y, z, w));
+		}
+	}
+
+	/*
+	*/
+	QuatSoA::QuatSoA()
+		:x(nullptr), y(nullptr), z(nullptr), w(nullptr), m_Storage(4)
+	{}
+
+	QuatSoA::QuatSoA(size_t count)
+		:x(nullptr), y(nullptr), z(nullptr), w(nullptr), m_Storage(4)
+	{
+		Resize(count);
+	}
+
+	QuatSoA::QuatSoA(const Quat* in, size_t count)
+		:x(nullptr), y(nullptr), z(nullptr), w(nullptr), m_Storage(4)
+	{
+		FromQuat(in, count);
+	}
+
+	QuatSoA::QuatSoA(const QuatSoA& in)
+		:x(nullptr), y(nullptr), z(nullptr), w(nullptr), m_Storage(in.m_Storage)
+	{
+		_Bind();
+	}
+
+	QuatSoA::~QuatSoA()
+	{}
+
+	QuatSoA& QuatSoA::operator=(const QuatSoA& in)
+	{
+		m_Storage = in.m_Storage;
+		_Bind();
+		return *this;
+	}
+
+	void QuatSoA::_Allocate(size_t count)
+	{
+		m_Storage.Allocate(count);
+		_Bind();
+	}
+
+	void QuatSoA::_Bind()
+	{
+		x = m_Storage.Component(0);
+		y = m_Storage.Component(1);
+		z = m_Storage.Component(2);
+		w = m_Storage.Component(3);
+	}
+
+	void QuatSoA::Resize(size_t count)
+	{
+		size_t keep = Math::Min(count, Size());
+		m_Storage.Resize(count);
+		_Bind();
+
+		for (size_t i = keep; i < count; i++)
+			w[i] = Math::ONEFLOAT;
+	}
+
+	void QuatSoA::FromQuat(const Quat* in, size_t count)
+	{
+		_Allocate(count);
+
+		size_t i = 0;
+		SIMD_DISPATCH_SSE41(i, _FromQuat, in, *this, count);
+		for (; i < count; i++)
+			Set(i, in[i]);
+	}
+
+	void QuatSoA::ToQuat(Quat* out) const
+	{
+		size_t i = 0;
+		SIMD_DISPATCH_SSE41(i, _ToQuat, *this, out, Size());
+		for (; i < Size(); i++)
+			out[i] = Get(i);
+	}
+
+	void QuatSoA::Normalize()
+	{
+		normalize(*this, *this);
+	}
+
+	void QuatSoA::slerp(const QuatSoA& a, const QuatSoA& b, float t, QuatSoA& out)
+	{
+		_SlerpArray(a, b, &t, 0, out);
+	}
+
+	void QuatSoA::slerp(const QuatSoA& a, const QuatSoA& b, const float* t, QuatSoA& out)
+	{
+		_SlerpArray(a, b, t, 1, out);
+	}
+
+	void QuatSoA::nlerp(const QuatSoA& a, const QuatSoA& b, float t, QuatSoA& out, bool corrected)
+	{
+		_NlerpArray(a, b, &t, 0, corrected, out);
+	}
+
+	void QuatSoA::nlerp(const QuatSoA& a, const QuatSoA& b, const float* t, QuatSoA& out, bool corrected)
+	{
+		_NlerpArray(a, b, t, 1, corrected, out);
+	}
+
+	void QuatSoA::blend(const QuatSoA* inputs, const float* weights, size_t count, QuatSoA& out)
+	{
+		ASSERT(count > 0, "[QuatSoA] NOTHING TO BLEND");
+
+		size_t i = 0, n = inputs[0].Size();
+		for (size_t k = 1; k < count; k++)
+			ASSERT(inputs[k].Size() == n, "[QuatSoA] SIZE MISMATCH");
+
+		out.Resize(n);
+
+		SIMD_DISPATCH(i, _Blend, inputs, weights, count, out, n);
+		for (; i < n; i++) {
+			const QuatSoA& q0 = inputs[0];
+			float x = q0.x[i] * weights[0], y = q0.y[i] * weights[0], z = q0.z[i] * weights[0], w = q0.w[i] * weights[0];
+
+			for (size_t k = 1; k < count; k++) {
+				const QuatSoA& q = inputs[k];
+				float d = q0.x[i] * q.x[i] + q0.y[i] * q.y[i] + q0.z[i] * q.z[i] + q0.w[i] * q.w[i];
+				float wk = (d < 0) ? -weights[k] : weights[k];
+				x += q.x[i] * wk;
+				y += q.y[i] * wk;
+				z += q.z[i] * wk;
+				w += q.w[i] * wk;
+			}
+
+			_Store(out, i, x, y, z, w, _RcpLength(x, y, z, w));
+		}
+	}
+
+	void QuatSoA::normalize(const QuatSoA& a, QuatSoA& out)
+	{
+		out.Resize(a.Size());
+
+		size_t i = 0, n = a.Size();
+		SIMD_DISPATCH(i, _Normalize, a, out, n);
+		for (; i < n; i++)
+			_Store(out, i, a.x[i], a.y[i], a.z[i], a.w[i], _RcpLength(a.x[i], a.y[i], a.z[i], a.w[i]));
+	}
+}
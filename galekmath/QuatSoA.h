@@ -0,0 +1,102 @@
+/* Copyright (C) 2009-2020, Nick Galko Ltd. All rights reserved.
+*
+* This file is part of the NGTech (https://galek.github.io/portfolio/).
+*
+* Your use and or redistribution of this software in source and / or
+* binary form, with or without modification, is subject to: (i) your
+* ongoing acceptance of and compliance with the terms and conditions of
+* the NGTech License Agreement; and (ii) your inclusion of this notice
+* in any version of this software that you use or redistribute.
+* A copy of the NGTech License Agreement is available by contacting
+* Nick Galko Ltd. at https://galek.github.io/portfolio/
+*/
+#pragma once
+
+//***************************************************************************
+#include "MathLib.h"
+#include "SoAStorage.h"
+//***************************************************************************
+
+namespace NGTech
+{
+	/**
+	Array of Quat stored as structure of arrays, same layout rules as Vec3SoA.
+	Interpolation works on whole arrays and uses polynomial approximations instead of
+	acos/sin, so the results slightly differ from Quat::slerp.
+	Output may be one of the inputs, sizes of all operands must match.
+	*/
+	class QuatSoA
+	{
+	public:
+		float* x;
+		float* y;
+		float* z;
+		float* w;
+
+		QuatSoA();
+		explicit QuatSoA(size_t count);
+		QuatSoA(const Quat* in, size_t count);
+		QuatSoA(const QuatSoA& in);
+		~QuatSoA();
+
+		QuatSoA& operator=(const QuatSoA& in);
+
+		ENGINE_INLINE size_t Size() const {
+			return m_Storage.Size();
+		}
+
+		/**
+		Keeps the first min(Size(), count) elements, new ones are identity
+		*/
+		void Resize(size_t count);
+
+		ENGINE_INLINE Quat Get(size_t i) const {
+			ASSERT(i < Size(), "[QuatSoA] INDEX OUT OF RANGE");
+			return Quat(x[i], y[i], z[i], w[i]);
+		}
+
+		ENGINE_INLINE void Set(size_t i, const Quat& q) {
+			ASSERT(i < Size(), "[QuatSoA] INDEX OUT OF RANGE");
+			x[i] = q.x;
+			y[i] = q.y;
+			z[i] = q.z;
+			w[i] = q.w;
+		}
+
+		/**
+		Conversion from/to packed Quat arrays. FromQuat resizes the container
+		*/
+		void FromQuat(const Quat* in, size_t count);
+		void ToQuat(Quat* out) const;
+
+		void Normalize();
+
+		/**
+		Shortest path slerp, t is the same for all elements or one per element.
+		Max error against the exact slerp is 3e-5 for unit inputs (at 180 degrees, much less for closer inputs).
+		*/
+		static void slerp(const QuatSoA& a, const QuatSoA& b, float t, QuatSoA& out);
+		static void slerp(const QuatSoA& a, const QuatSoA& b, const float* t, QuatSoA& out);
+
+		/**
+		Shortest path normalized lerp. With corrected = true t is first remapped
+		by a cubic fit, so the angular velocity gets close to slerp (error < 2e-3 rad)
+		*/
+		static void nlerp(const QuatSoA& a, const QuatSoA& b, float t, QuatSoA& out, bool corrected = false);
+		static void nlerp(const QuatSoA& a, const QuatSoA& b, const float* t, QuatSoA& out, bool corrected = false);
+
+		/**
+		Normalized weighted sum of count arrays, every input is flipped to the hemisphere of inputs[0]
+		*/
+		static void blend(const QuatSoA* inputs, const float* weights, size_t count, QuatSoA& out);
+
+		static void normalize(const QuatSoA& a, QuatSoA& out);
+
+	private:
+		void _Allocate(size_t count);
+		void _Bind();
+
+	private:
+		SoAStorage m_Storage;
+	};
+}
@@ -0,0 +1,285 @@
+/* Copyright (C) 2009-2020, Nick Galko Ltd. All rights reserved.
+*
+* This file is part of the NGTech (https://galek.github.io/portfolio/).
+*
+* Your use and or redistribution of this software in source and / or
+* binary form, with or without modification, is subject to: (i) your
+* ongoing acceptance of and compliance with the terms and conditions of
+* the NGTech License Agreement; and (ii) your inclusion of this notice
+* in any version of this software that you use or redistribute.
+* A copy of the NGTech License Agreement is available by contacting
+* Nick Galko Ltd. at https://galek.github.io/portfolio/
+*/
+//***************************************************************************
+#include <math.h>
+//***************************************************************************
+#include "RayPacket.h"
+#include "BBox.h"
+#include "SIMD.h"
+//***************************************************************************
+
+namespace NGTech
+{
+	void RayPacket::Set(int i, const Vec3& src, const Vec3& dst)
+	{
+		ASSERT(i >= 0 && i < SIZE, "[RayPacket] INDEX OUT OF RANGE");
+
+		ox[i] = src.x; oy[i] = src.y; oz[i] = src.z;
+		dx[i] = dst.x - src.x; dy[i] = dst.y - src.y; dz[i] = dst.z - src.z;
+		invDx[i] = Math::ONEFLOAT / dx[i]; invDy[i] = Math::ONEFLOAT / dy[i]; invDz[i] = Math::ONEFLOAT / dz[i];
+		tMax[i] = Math::ONEFLOAT;
+		active |= 1u << i;
+	}
+
+	/*
+	Reference versions for one ray, the SIMD kernels do the same operations per lane.
+	Sphere: |o + d * t - c|^2 = r^2 with b = d.(o - c), the sphere is behind the origin when b >= 0.
+	*/
+	static ENGINE_INLINE bool _SphereScalar(const RayPacket& p, int i, const Vec3& center, float radius, float& t)
+	{
+		float ocx = p.ox[i] - center.x, ocy = p.oy[i] - center.y, ocz = p.oz[i] - center.z;
+		float a = p.dx[i] * p.dx[i] + p.dy[i] * p.dy[i] + p.dz[i] * p.dz[i];
+		float b = p.dx[i] * ocx + p.dy[i] * ocy + p.dz[i] * ocz;
+		float c = ocx * ocx + ocy * ocy + ocz * ocz - radius * radius;
+
+		if (c <= 0) {
+			t = 0;
+			return true;
+		}
+
+		float disc = b * b - a * c;
+		if (!(b < 0 && disc >= 0))
+			return false;
+
+		t = (-b - sqrtf(disc)) / a;
+		return t <= p.tMax[i];
+	}
+
+	static ENGINE_INLINE bool _BoxScalar(const RayPacket& p, int i, const BBox& box, float& t)
+	{
+		Vec3 src(p.ox[i], p.oy[i], p.oz[i]);
+		Vec3 invDir(p.invDx[i], p.invDy[i], p.invDz[i]);
+		return BBox::IntersectsSlabs(box.mins, box.maxes, src, invDir, p.tMax[i], t);
+	}
+
+	static ENGINE_INLINE bool _TriangleScalar(const RayPacket& p, int i, const Vec3& v0, const Vec3& v1, const Vec3& v2, float& t, float& u, float& v)
+	{
+		Vec3 src(p.ox[i], p.oy[i], p.oz[i]);
+		Vec3 dir(p.dx[i], p.dy[i], p.dz[i]);
+		return Math::intersectTriangleBySegment(v0, v1, v2, src, dir, p.tMax[i], t, u, v);
+	}
+
+#if MATH_SIMD_X86
+	/*
+	SSE4.1 kernels test rays [first, first + 4), AVX2 kernels all 8. Results go to
+	full-width temporaries, the callers copy the hit lanes out.
+	*/
+	ENGINE_TARGET_SSE41 static ENGINE_INLINE __m128 _ActiveSSE41(uint32_t bits)
+	{
+		__m128i lanes = _mm_setr_epi32(1, 2, 4, 8);
+		return _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32((int)bits), lanes), lanes));
+	}
+
+	ENGINE_TARGET_AVX2 static ENGINE_INLINE __m256 _ActiveAVX2(uint32_t bits)
+	{
+		__m256i lanes = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+		return _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32((int)bits), lanes), lanes));
+	}
+
+	ENGINE_TARGET_SSE41 static uint32_t _SphereSSE41(const RayPacket& p, int first, const Vec3& center, float radius, float* t)
+	{
+		__m128 dx = _mm_loadu_ps(p.dx + first), dy = _mm_loadu_ps(p.dy + first), dz = _mm_loadu_ps(p.dz + first);
+		__m128 ocx = _mm_sub_ps(_mm_loadu_ps(p.ox + first), _mm_set1_ps(center.x));
+		__m128 ocy = _mm_sub_ps(_mm_loadu_ps(p.oy + first), _mm_set1_ps(center.y));
+		__m128 ocz = _mm_sub_ps(_mm_loadu_ps(p.oz + first), _mm_set1_ps(center.z));
+
+		__m128 a = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+		__m128 b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, ocx), _mm_mul_ps(dy, ocy)), _mm_mul_ps(dz, ocz));
+		__m128 c = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(ocx, ocx), _mm_mul_ps(ocy, ocy)), _mm_mul_ps(ocz, ocz)), _mm_set1_ps(radius * radius));
+		__m128 disc = _mm_sub_ps(_mm_mul_ps(b, b), _mm_mul_ps(a, c));
+
+		__m128 zero = _mm_setzero_ps();
+		__m128 inside = _mm_cmple_ps(c, zero);
+		__m128 tHit = _mm_div_ps(_mm_sub_ps(_mm_sub_ps(zero, b), _mm_sqrt_ps(_mm_max_ps(disc, zero))), a);
+		__m128 hit = _mm_and_ps(_mm_and_ps(_mm_cmplt_ps(b, zero), _mm_cmpge_ps(disc, zero)), _mm_cmple_ps(tHit, _mm_loadu_ps(p.tMax + first)));
+
+		_mm_storeu_ps(t + first, _mm_andnot_ps(inside, tHit));
+		return (uint32_t)_mm_movemask_ps(_mm_and_ps(_mm_or_ps(inside, hit), _ActiveSSE41(p.active >> first))) << first;
+	}
+
+	ENGINE_TARGET_AVX2 static uint32_t _SphereAVX2(const RayPacket& p, const Vec3& center, float radius, float* t)
+	{
+		__m256 dx = _mm256_loadu_ps(p.dx), dy = _mm256_loadu_ps(p.dy), dz = _mm256_loadu_ps(p.dz);
+		__m256 ocx = _mm256_sub_ps(_mm256_loadu_ps(p.ox), _mm256_set1_ps(center.x));
+		__m256 ocy = _mm256_sub_ps(_mm256_loadu_ps(p.oy), _mm256_set1_ps(center.y));
+		__m256 ocz = _mm256_sub_ps(_mm256_loadu_ps(p.oz), _mm256_set1_ps(center.z));
+
+		__m256 a = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+		__m256 b = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, ocx), _mm256_mul_ps(dy, ocy)), _mm256_mul_ps(dz, ocz));
+		__m256 c = _mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ocx, ocx), _mm256_mul_ps(ocy, ocy)), _mm256_mul_ps(ocz, ocz)), _mm256_set1_ps(radius * radius));
+		__m256 disc = _mm256_sub_ps(_mm256_mul_ps(b, b), _mm256_mul_ps(a, c));
+
+		__m256 zero = _mm256_setzero_ps();
+		__m256 inside = _mm256_cmp_ps(c, zero, _CMP_LE_OQ);
+		__m256 tHit = _mm256_div_ps(_mm256_sub_ps(_mm256_sub_ps(zero, b), _mm256_sqrt_ps(_mm256_max_ps(disc, zero))), a);
+		__m256 hit = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(b, zero, _CMP_LT_OQ), _mm256_cmp_ps(disc, zero, _CMP_GE_OQ)),
+			_mm256_cmp_ps(tHit, _mm256_loadu_ps(p.tMax), _CMP_LE_OQ));
+
+		_mm256_storeu_ps(t, _mm256_andnot_ps(inside, tHit));
+		return (uint32_t)_mm256_movemask_ps(_mm256_and_ps(_mm256_or_ps(inside, hit), _ActiveAVX2(p.active)));
+	}
+
+	ENGINE_TARGET_SSE41 static uint32_t _BoxSSE41(const RayPacket& p, int first, const BBox& box, float* t)
+	{
+		__m128 ox = _mm_loadu_ps(p.ox + first), oy = _mm_loadu_ps(p.oy + first), oz = _mm_loadu_ps(p.oz + first);
+		__m128 ix = _mm_loadu_ps(p.invDx + first), iy = _mm_loadu_ps(p.invDy + first), iz = _mm_loadu_ps(p.invDz + first);
+
+		__m128 tx0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.mins.x), ox), ix), tx1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.maxes.x), ox), ix);
+		__m128 ty0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.mins.y), oy), iy), ty1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.maxes.y), oy), iy);
+		__m128 tz0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.mins.z), oz), iz), tz1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.maxes.z), oz), iz);
+
+		__m128 tNear = _mm_max_ps(_mm_max_ps(_mm_min_ps(tx0, tx1), _mm_min_ps(ty0, ty1)), _mm_max_ps(_mm_min_ps(tz0, tz1), _mm_setzero_ps()));
+		__m128 tFar = _mm_min_ps(_mm_min_ps(_mm_max_ps(tx0, tx1), _mm_max_ps(ty0, ty1)), _mm_min_ps(_mm_max_ps(tz0, tz1), _mm_loadu_ps(p.tMax + first)));
+
+		_mm_storeu_ps(t + first, tNear);
+		return (uint32_t)_mm_movemask_ps(_mm_and_ps(_mm_cmple_ps(tNear, tFar), _ActiveSSE41(p.active >> first))) << first;
+	}
+
+	ENGINE_TARGET_AVX2 static uint32_t _BoxAVX2(const RayPacket& p, const BBox& box, float* t)
+	{
+		__m256 ox = _mm256_loadu_ps(p.ox), oy = _mm256_loadu_ps(p.oy), oz = _mm256_loadu_ps(p.oz);
+		__m256 ix = _mm256_loadu_ps(p.invDx), iy = _mm256_loadu_ps(p.invDy), iz = _mm256_loadu_ps(p.invDz);
+
+		__m256 tx0 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(box.mins.x), ox), ix), tx1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(box.maxes.x), ox), ix);
+		__m256 ty0 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(box.mins.y), oy), iy), ty1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(box.maxes.y), oy), iy);
+		__m256 tz0 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(box.mins.z), oz), iz), tz1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(box.maxes.z), oz), iz);
+
+		__m256 tNear = _mm256_max_ps(_mm256_max_ps(_mm256_min_ps(tx0, tx1), _mm256_min_ps(ty0, ty1)), _mm256_max_ps(_mm256_min_ps(tz0, tz1), _mm256_setzero_ps()));
+		__m256 tFar = _mm256_min_ps(_mm256_min_ps(_mm256_max_ps(tx0, tx1), _mm256_max_ps(ty0, ty1)), _mm256_min_ps(_mm256_max_ps(tz0, tz1), _mm256_loadu_ps(p.tMax)));
+
+		_mm256_storeu_ps(t, tNear);
+		return (uint32_t)_mm256_movemask_ps(_mm256_and_ps(_mm256_cmp_ps(tNear, tFar, _CMP_LE_OQ), _ActiveAVX2(p.active)));
+	}
+
+	ENGINE_TARGET_SSE41 static uint32_t _TriangleSSE41(const RayPacket& p, int first, const Vec3& v0, const Vec3& v1, const Vec3& v2, float* tOut, float* uOut, float* vOut)
+	{
+		__m128 o[3] = { _mm_loadu_ps(p.ox + first), _mm_loadu_ps(p.oy + first), _mm_loadu_ps(p.oz + first) };
+		__m128 d[3] = { _mm_loadu_ps(p.dx + first), _mm_loadu_ps(p.dy + first), _mm_loadu_ps(p.dz + first) };
+		__m128 a[3] = { _mm_set1_ps(v0.x), _mm_set1_ps(v0.y), _mm_set1_ps(v0.z) };
+		__m128 b[3] = { _mm_set1_ps(v1.x), _mm_set1_ps(v1.y), _mm_set1_ps(v1.z) };
+		__m128 c[3] = { _mm_set1_ps(v2.x), _mm_set1_ps(v2.y), _mm_set1_ps(v2.z) };
+
+		__m128 t, u, v;
+		__m128 mask = SIMD::IntersectTriangles(o, d, a, b, c, _mm_loadu_ps(p.tMax + first), t, u, v);
+
+		_mm_storeu_ps(tOut + first, t);
+		_mm_storeu_ps(uOut + first, u);
+		_mm_storeu_ps(vOut + first, v);
+		return (uint32_t)_mm_movemask_ps(_mm_and_ps(mask, _ActiveSSE41(p.active >> first))) << first;
+	}
+
+	ENGINE_TARGET_AVX2 static uint32_t _TriangleAVX2(const RayPacket& p, const Vec3& v0, const Vec3& v1, const Vec3& v2, float* tOut, float* uOut, float* vOut)
+	{
+		__m256 o[3] = { _mm256_loadu_ps(p.ox), _mm256_loadu_ps(p.oy), _mm256_loadu_ps(p.oz) };
+		__m256 d[3] = { _mm256_loadu_ps(p.dx), _mm256_loadu_ps(p.dy), _mm256_loadu_ps(p.dz) };
+		__m256 a[3] = { _mm256_set1_ps(v0.x), _mm256_set1_ps(v0.y), _mm256_set1_ps(v0.z) };
+		__m256 b[3] = { _mm256_set1_ps(v1.x), _mm256_set1_ps(v1.y), _mm256_set1_ps(v1.z) };
+		__m256 c[3] = { _mm256_set1_ps(v2.x), _mm256_set1_ps(v2.y), _mm256_set1_ps(v2.z) };
+
+		__m256 t, u, v;
+		__m256 mask = SIMD::IntersectTriangles(o, d, a, b, c, _mm256_loadu_ps(p.tMax), t, u, v);
+
+		_mm256_storeu_ps(tOut, t);
+		_mm256_storeu_ps(uOut, u);
+		_mm256_storeu_ps(vOut, v);
+		return (uint32_t)_mm256_movemask_ps(_mm256_and_ps(mask, _ActiveAVX2(p.active)));
+	}
+#endif
+
+	/*
+	Copies the hit lanes of a temporary
+	*/
+	static ENGINE_INLINE void _CopyHits(uint32_t hits, const float* from, float* to)
+	{
+		for (int i = 0; i < RayPacket::SIZE; i++)
+			if (hits & (1u << i))
+				to[i] = from[i];
+	}
+
+	uint32_t RayPacket::IntersectSphere(const Vec3& center, float radius, float* t) const
+	{
+		float tHit[SIZE];
+		uint32_t hits = 0;
+
+		switch (SIMD::GetLevel())
+		{
+#if MATH_SIMD_X86
+		case SIMD::LEVEL_AVX2: hits = _SphereAVX2(*this, center, radius, tHit); break;
+		case SIMD::LEVEL_SSE41:
+			if (active & 0x0f) hits |= _SphereSSE41(*this, 0, center, radius, tHit);
+			if (active & 0xf0) hits |= _SphereSSE41(*this, 4, center, radius, tHit);
+			break;
+#endif
+		default:
+			for (int i = 0; i < SIZE; i++)
+				if ((active & (1u << i)) && _SphereScalar(*this, i, center, radius, tHit[i]))
+					hits |= 1u << i;
+			break;
+		}
+
+		_CopyHits(hits, tHit, t);
+		return hits;
+	}
+
+	uint32_t RayPacket::IntersectBox(const BBox& box, float* t) const
+	{
+		float tHit[SIZE];
+		uint32_t hits = 0;
+
+		switch (SIMD::GetLevel())
+		{
+#if MATH_SIMD_X86
+		case SIMD::LEVEL_AVX2: hits = _BoxAVX2(*this, box, tHit); break;
+		case SIMD::LEVEL_SSE41:
+			if (active & 0x0f) hits |= _BoxSSE41(*this, 0, box, tHit);
+			if (active & 0xf0) hits |= _BoxSSE41(*this, 4, box, tHit);
+			break;
+#endif
+		default:
+			for (int i = 0; i < SIZE; i++)
+				if ((active & (1u << i)) && _BoxScalar(*this, i, box, tHit[i]))
+					hits |= 1u << i;
+			break;
+		}
+
+		_CopyHits(hits, tHit, t);
+		return hits;
+	}
+
+	uint32_t RayPacket::IntersectTriangle(const Vec3& v0, const Vec3& v1, const Vec3& v2, float* t, float* u, float* v) const
+	{
+		float tHit[SIZE], uHit[SIZE], vHit[SIZE];
+		uint32_t hits = 0;
+
+		switch (SIMD::GetLevel())
+		{
+#if MATH_SIMD_X86
+		case SIMD::LEVEL_AVX2: hits = _TriangleAVX2(*this, v0, v1, v2, tHit, uHit, vHit); break;
+		case SIMD::LEVEL_SSE41:
+			if (active & 0x0f) hits |= _TriangleSSE41(*this, 0, v0, v1, v2, tHit, uHit, vHit);
+			if (active & 0xf0) hits |= _TriangleSSE41(*this, 4, v0, v1, v2, tHit, uHit, vHit);
+			break;
+#endif
+		default:
+			for (int i = 0; i < SIZE; i++)
+				if ((active & (1u << i)) && _TriangleScalar(*this, i, v0, v1, v2, tHit[i], uHit[i], vHit[i]))
+					hits |= 1u << i;
+			break;
+		}
+
+		_CopyHits(hits, tHit, t);
+		_CopyHits(hits, uHit, u);
+		_CopyHits(hits, vHit, v);
+		return hits;
+	}
+}
@@ -0,0 +1,65 @@
+/* Copyright (C) 2009-2020, Nick Galko Ltd. All rights reserved.
+*
+* This file is part of the NGTech (https://galek.github.io/portfolio/).
+*
+* Your use and or redistribution of this software in source and / or
+* binary form, with or without modification, is subject to: (i) your
+* ongoing acceptance of and compliance with the terms and conditions of
+* the NGTech License Agreement; and (ii) your inclusion of this notice
+* in any version of this software that you use or redistribute.
+* A copy of the NGTech License Agreement is available by contacting
+* Nick Galko Ltd. at https://galek.github.io/portfolio/
+*/
+#pragma once
+
+//***************************************************************************
+#include "MathLib.h"
+//***************************************************************************
+
+namespace NGTech
+{
+	class BBox;
+
+	/**
+	Up to 8 coherent rays (e.g. from one camera) in SoA form. Ray i is the segment
+	o + d * t, t in [0, tMax[i]], and takes part in the tests when bit i of active is set.
+	The tests run 4 (SSE4.1) or 8 (AVX2) rays per instruction.
+	*/
+	class RayPacket
+	{
+	public:
+		static const int SIZE = 8;
+
+		float ox[SIZE], oy[SIZE], oz[SIZE];
+		float dx[SIZE], dy[SIZE], dz[SIZE];
+		/**
+		1 / d for the slab tests, filled by Set
+		*/
+		float invDx[SIZE], invDy[SIZE], invDz[SIZE];
+		float tMax[SIZE];
+		uint32_t active;
+
+		RayPacket() : active(0) {}
+
+		/**
+		Ray i from src to dst with tMax 1, the ray is activated
+		*/
+		void Set(int i, const Vec3& src, const Vec3& dst);
+
+		ENGINE_INLINE Vec3 GetPoint(int i, float t) const {
+			return Vec3(ox[i] + dx[i] * t, oy[i] + dy[i] * t, oz[i] + dz[i] * t);
+		}
+
+		/**
+		Return the mask of active rays that hit the shape closer than their tMax, and write
+		the hit t (0 when the origin is inside) of those rays only. tMax is not changed,
+		so closest hit searches lower it themselves.
+		*/
+		uint32_t IntersectSphere(const Vec3& center, float radius, float* t) const;
+		uint32_t IntersectBox(const BBox& box, float* t) const;
+		/**
+		Same test as Math::intersectTriangleByRay, also writes the barycentrics
+		*/
+		uint32_t IntersectTriangle(const Vec3& v0, const Vec3& v1, const Vec3& v2, float* t, float* u, float* v) const;
+	};
+}
@@ -0,0 +1,92 @@
+/* Copyright (C) 2009-2020, Nick Galko Ltd. All rights reserved.
+*
+* This file is part of the NGTech (https://galek.github.io/portfolio/).
+*
+* Your use and or redistribution of this software in source and / or
+* binary form, with or without modification, is subject to: (i) your
+* ongoing acceptance of and compliance with the terms and conditions of
+* the NGTech License Agreement; and (ii) your inclusion of this notice
+* in any version of this software that you use or redistribute.
+* A copy of the NGTech License Agreement is available by contacting
+* Nick Galko Ltd. at https://galek.github.io/portfolio/
+*/
+//***************************************************************************
+#include "SIMD.h"
+//***************************************************************************
+#if MATH_SIMD_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+//***************************************************************************
+
+namespace NGTech
+{
+#if MATH_SIMD_X86
+	static void _CpuId(unsigned int leaf, unsigned int subleaf, unsigned int regs[4])
+	{
+#if defined(_MSC_VER)
+		int r[4];
+		__cpuidex(r, (int)leaf, (int)subleaf);
+		regs[0] = r[0]; regs[1] = r[1]; regs[2] = r[2]; regs[3] = r[3];
+#else
+		__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+	}
+
+	/*
+	XCR0, tells which register files OS saves on context switch
+	*/
+	static unsigned long long _XGetBV()
+	{
+#if defined(_MSC_VER)
+		return _xgetbv(0);
+#else
+		unsigned int lo, hi;
+		__asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+		return ((unsigned long long)hi << 32) | lo;
+#endif
+	}
+
+	static SIMD::Level _DetectLevel()
+	{
+		unsigned int regs[4];
+		_CpuId(0, 0, regs);
+		unsigned int maxLeaf = regs[0];
+		if (maxLeaf < 1)
+			return SIMD::LEVEL_SCALAR;
+
+		_CpuId(1, 0, regs);
+		bool sse41 = (regs[2] & (1u << 19)) != 0;
+		bool fma = (regs[2] & (1u << 12)) != 0;
+		bool osxsave = (regs[2] & (1u << 27)) != 0;
+		bool avx = (regs[2] & (1u << 28)) != 0;
+
+		if (!sse41)
+			return SIMD::LEVEL_SCALAR;
+
+		// XMM and YMM state must be enabled by OS
+		bool osavx = osxsave && ((_XGetBV() & 0x6) == 0x6);
+		if (!(avx && fma && osavx) || maxLeaf < 7)
+			return SIMD::LEVEL_SSE41;
+
+		_CpuId(7, 0, regs);
+		bool avx2 = (regs[1] & (1u << 5)) != 0;
+
+		return avx2 ? SIMD::LEVEL_AVX2 : SIMD::LEVEL_SSE41;
+	}
+#else
+	static SIMD::Level _DetectLevel()
+	{
+		return SIMD::LEVEL_SCALAR;
+	}
+#endif
+
+	SIMD::Level SIMD::GetSupportedLevel()
+	{
+		static const Level supported = _DetectLevel();
+		return supported;
+	}
+}
@@ -0,0 +1,338 @@
+/* Copyright (C) 2009-2020, Nick Galko Ltd. All rights reserved.
+*
+* This file is part of the NGTech (https://galek.github.io/portfolio/).
+*
+* Your use and or redistribution of this software in source and / or
+* binary form, with or without modification, is subject to: (i) your
+* ongoing acceptance of and compliance with the terms and conditions of
+* the NGTech License Agreement; and (ii) your inclusion of this notice
+* in any version of this software that you use or redistribute.
+* A copy of the NGTech License Agreement is available by contacting
+* Nick Galko Ltd. at https://galek.github.io/portfolio/
+*/
+#pragma once
+
+#include "galekmath_config.h"
+
+//***************************************************************************
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define MATH_SIMD_X86 1
+#include <immintrin.h>
+#endif
+//***************************************************************************
+
+/*
+Kernels for the newer instruction sets are compiled next to the scalar code
+and are only called after SIMD::GetLevel() said the CPU supports them.
+GCC and Clang need the target attribute for it, MSVC allows the intrinsics anywhere.
+The build turns off implicit multiply-add contraction (-ffp-contract=off), so AVX2 kernels
+only fuse where they call the FMA intrinsics and otherwise match the scalar code bit for bit.
+*/
+#if MATH_SIMD_X86 && (defined(__GNUC__) || defined(__clang__))
+#define ENGINE_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define ENGINE_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define ENGINE_TARGET_SSE41
+#define ENGINE_TARGET_AVX2
+#endif
+
+namespace NGTech
+{
+	/**
+	Runtime selection of the instruction set used by the math kernels
+	*/
+	struct SIMD
+	{
+		enum Level
+		{
+			LEVEL_SCALAR = 0,
+			LEVEL_SSE41,
+			LEVEL_AVX2		// AVX2 + FMA3
+		};
+
+		/**
+		Highest level supported by CPU and OS. Detected once.
+		*/
+		static Level GetSupportedLevel();
+
+		/**
+		Level used by the dispatched kernels. By default it is GetSupportedLevel()
+		*/
+		static ENGINE_INLINE Level GetLevel() {
+			return _Active();
+		}
+
+		/**
+		Forces the kernels to a lower level (LEVEL_SCALAR gives the reference code).
+		Levels above the supported one are clamped.
+		*/
+		static ENGINE_INLINE void SetLevel(Level _level) {
+			Level supported = GetSupportedLevel();
+			_Active() = (_level < supported) ? _level : supported;
+		}
+
+		/**
+		Merge of per-lane results after a SIMD loop: the lane with the smallest value
+		(largest with greater) among the lanes with index >= 0, ties go to the lower index.
+		-1 when no lane has a result.
+		*/
+		static ENGINE_INLINE int BestLane(const float* value, const int* index, int lanes, bool greater = false)
+		{
+			int best = -1;
+			for (int l = 0; l < lanes; l++) {
+				if (index[l] < 0)
+					continue;
+				if (best < 0 || (greater ? value[l] > value[best] : value[l] < value[best]) || (value[l] == value[best] && index[l] < index[best]))
+					best = l;
+			}
+			return best;
+		}
+
+#if MATH_SIMD_X86
+		/**
+		Splits 4 packed Vec3 (12 floats) to x, y, z registers
+		*/
+		ENGINE_TARGET_SSE41 static ENGINE_INLINE void LoadVec3x4(const float* p, __m128& x, __m128& y, __m128& z)
+		{
+			__m128 a = _mm_loadu_ps(p + 0);	// x0 y0 z0 x1
+			__m128 b = _mm_loadu_ps(p + 4);	// y1 z1 x2 y2
+			__m128 c = _mm_loadu_ps(p + 8);	// z2 x3 y3 z3
+			_Deinterleave(a, b, c, x, y, z);
+		}
+
+		/**
+		Packs x, y, z registers back to 4 Vec3
+		*/
+		ENGINE_TARGET_SSE41 static ENGINE_INLINE void StoreVec3x4(float* p, __m128 x, __m128 y, __m128 z)
+		{
+			__m128 a, b, c;
+			_Interleave(x, y, z, a, b, c);
+			_mm_storeu_ps(p + 0, a);
+			_mm_storeu_ps(p + 4, b);
+			_mm_storeu_ps(p + 8, c);
+		}
+
+		/**
+		Two unaligned float4 loads, lo to the low 128-bit lane and hi to the high one
+		*/
+		ENGINE_TARGET_AVX2 static ENGINE_INLINE __m256 Load2(const float* lo, const float* hi)
+		{
+			return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(lo)), _mm_loadu_ps(hi), 1);
+		}
+
+		/**
+		Same for 8 Vec3 (24 floats), lane 0 holds points 0-3, lane 1 points 4-7
+		*/
+		ENGINE_TARGET_AVX2 static ENGINE_INLINE void LoadVec3x8(const float* p, __m256& x, __m256& y, __m256& z)
+		{
+			__m256 a = Load2(p + 0, p + 12);
+			__m256 b = Load2(p + 4, p + 16);
+			__m256 c = Load2(p + 8, p + 20);
+			_Deinterleave(a, b, c, x, y, z);
+		}
+
+		ENGINE_TARGET_AVX2 static ENGINE_INLINE void StoreVec3x8(float* p, __m256 x, __m256 y, __m256 z)
+		{
+			__m256 a, b, c;
+			_Interleave(x, y, z, a, b, c);
+			_mm_storeu_ps(p + 0, _mm256_castps256_ps128(a));
+			_mm_storeu_ps(p + 4, _mm256_castps256_ps128(b));
+			_mm_storeu_ps(p + 8, _mm256_castps256_ps128(c));
+			_mm_storeu_ps(p + 12, _mm256_extractf128_ps(a, 1));
+			_mm_storeu_ps(p + 16, _mm256_extractf128_ps(b, 1));
+			_mm_storeu_ps(p + 20, _mm256_extractf128_ps(c, 1));
+		}
+
+		/**
+		Cross product of the xyz parts, w of the result is 0 for finite input
+		*/
+		ENGINE_TARGET_SSE41 static ENGINE_INLINE __m128 Cross3(__m128 a, __m128 b)
+		{
+			__m128 ayzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+			__m128 bzxy = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 1, 0, 2));
+			__m128 azxy = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 1, 0, 2));
+			__m128 byzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+			return _mm_sub_ps(_mm_mul_ps(ayzx, bzxy), _mm_mul_ps(azxy, byzx));
+		}
+
+		/**
+		_MM_TRANSPOSE4_PS done in both 128-bit lanes
+		*/
+		ENGINE_TARGET_AVX2 static ENGINE_INLINE void Transpose4x4(__m256& r0, __m256& r1, __m256& r2, __m256& r3)
+		{
+			__m256 t0 = _mm256_unpacklo_ps(r0, r1);
+			__m256 t1 = _mm256_unpacklo_ps(r2, r3);
+			__m256 t2 = _mm256_unpackhi_ps(r0, r1);
+			__m256 t3 = _mm256_unpackhi_ps(r2, r3);
+			r0 = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+			r1 = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+			r2 = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+			r3 = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2));
+		}
+
+		/**
+		Math::intersectTriangleBySegment per lane: segments o + d * t against triangles a, b, c,
+		all given as x, y, z registers. Returns the hit mask, t, u and v are written for every lane.
+		*/
+		ENGINE_TARGET_SSE41 static ENGINE_INLINE __m128 IntersectTriangles(const __m128* o, const __m128* d, const __m128* a, const __m128* b, const __m128* c,
+			__m128 tMax, __m128& t, __m128& u, __m128& v)
+		{
+			__m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+			__m128 e1x = _mm_sub_ps(b[0], a[0]), e1y = _mm_sub_ps(b[1], a[1]), e1z = _mm_sub_ps(b[2], a[2]);
+			__m128 e2x = _mm_sub_ps(c[0], a[0]), e2y = _mm_sub_ps(c[1], a[1]), e2z = _mm_sub_ps(c[2], a[2]);
+
+			__m128 px = _mm_sub_ps(_mm_mul_ps(d[1], e2z), _mm_mul_ps(d[2], e2y));
+			__m128 py = _mm_sub_ps(_mm_mul_ps(d[2], e2x), _mm_mul_ps(d[0], e2z));
+			__m128 pz = _mm_sub_ps(_mm_mul_ps(d[0], e2y), _mm_mul_ps(d[1], e2x));
+			__m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+			__m128 invDet = _mm_div_ps(one, det);
+
+			__m128 sx = _mm_sub_ps(o[0], a[0]), sy = _mm_sub_ps(o[1], a[1]), sz = _mm_sub_ps(o[2], a[2]);
+			u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), invDet);
+
+			__m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+			__m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+			__m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+			v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(d[0], qx), _mm_mul_ps(d[1], qy)), _mm_mul_ps(d[2], qz)), invDet);
+			t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), invDet);
+
+			__m128 mask = _mm_and_ps(_mm_cmpneq_ps(det, zero), _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmple_ps(u, one)));
+			mask = _mm_and_ps(mask, _mm_and_ps(_mm_cmpge_ps(v, zero), _mm_cmple_ps(_mm_add_ps(u, v), one)));
+			return _mm_and_ps(mask, _mm_and_ps(_mm_cmpge_ps(t, zero), _mm_cmple_ps(t, tMax)));
+		}
+
+		ENGINE_TARGET_AVX2 static ENGINE_INLINE __m256 IntersectTriangles(const __m256* o, const __m256* d, const __m256* a, const __m256* b, const __m256* c,
+			__m256 tMax, __m256& t, __m256& u, __m256& v)
+		{
+			__m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+			__m256 e1x = _mm256_sub_ps(b[0], a[0]), e1y = _mm256_sub_ps(b[1], a[1]), e1z = _mm256_sub_ps(b[2], a[2]);
+			__m256 e2x = _mm256_sub_ps(c[0], a[0]), e2y = _mm256_sub_ps(c[1], a[1]), e2z = _mm256_sub_ps(c[2], a[2]);
+
+			__m256 px = _mm256_sub_ps(_mm256_mul_ps(d[1], e2z), _mm256_mul_ps(d[2], e2y));
+			__m256 py = _mm256_sub_ps(_mm256_mul_ps(d[2], e2x), _mm256_mul_ps(d[0], e2z));
+			__m256 pz = _mm256_sub_ps(_mm256_mul_ps(d[0], e2y), _mm256_mul_ps(d[1], e2x));
+			__m256 det = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e1x, px), _mm256_mul_ps(e1y, py)), _mm256_mul_ps(e1z, pz));
+			__m256 invDet = _mm256_div_ps(one, det);
+
+			__m256 sx = _mm256_sub_ps(o[0], a[0]), sy = _mm256_sub_ps(o[1], a[1]), sz = _mm256_sub_ps(o[2], a[2]);
+			u = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(sx, px), _mm256_mul_ps(sy, py)), _mm256_mul_ps(sz, pz)), invDet);
+
+			__m256 qx = _mm256_sub_ps(_mm256_mul_ps(sy, e1z), _mm256_mul_ps(sz, e1y));
+			__m256 qy = _mm256_sub_ps(_mm256_mul_ps(sz, e1x), _mm256_mul_ps(sx, e1z));
+			__m256 qz = _mm256_sub_ps(_mm256_mul_ps(sx, e1y), _mm256_mul_ps(sy, e1x));
+			v = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(d[0], qx), _mm256_mul_ps(d[1], qy)), _mm256_mul_ps(d[2], qz)), invDet);
+			t = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e2x, qx), _mm256_mul_ps(e2y, qy)), _mm256_mul_ps(e2z, qz)), invDet);
+
+			__m256 mask = _mm256_and_ps(_mm256_cmp_ps(det, zero, _CMP_NEQ_OQ), _mm256_and_ps(_mm256_cmp_ps(u, zero, _CMP_GE_OQ), _mm256_cmp_ps(u, one, _CMP_LE_OQ)));
+			mask = _mm256_and_ps(mask, _mm256_and_ps(_mm256_cmp_ps(v, zero, _CMP_GE_OQ), _mm256_cmp_ps(_mm256_add_ps(u, v), one, _CMP_LE_OQ)));
+			return _mm256_and_ps(mask, _mm256_and_ps(_mm256_cmp_ps(t, zero, _CMP_GE_OQ), _mm256_cmp_ps(t, tMax, _CMP_LE_OQ)));
+		}
+
+		/**
+		Column-major 4x4 product r = a * b. r may be the same memory as a or b.
+		Every result column is a linear combination of the columns of A
+		*/
+		ENGINE_TARGET_SSE41 static ENGINE_INLINE void MulMat4SSE41(float* r, const float* a, const float* b)
+		{
+			__m128 a0 = _mm_loadu_ps(a + 0);
+			__m128 a1 = _mm_loadu_ps(a + 4);
+			__m128 a2 = _mm_loadu_ps(a + 8);
+			__m128 a3 = _mm_loadu_ps(a + 12);
+
+			for (int c = 0; c < 16; c += 4) {
+				__m128 bc = _mm_loadu_ps(b + c);
+				__m128 col = _mm_mul_ps(a0, _mm_shuffle_ps(bc, bc, _MM_SHUFFLE(0, 0, 0, 0)));
+				col = _mm_add_ps(col, _mm_mul_ps(a1, _mm_shuffle_ps(bc, bc, _MM_SHUFFLE(1, 1, 1, 1))));
+				col = _mm_add_ps(col, _mm_mul_ps(a2, _mm_shuffle_ps(bc, bc, _MM_SHUFFLE(2, 2, 2, 2))));
+				col = _mm_add_ps(col, _mm_mul_ps(a3, _mm_shuffle_ps(bc, bc, _MM_SHUFFLE(3, 3, 3, 3))));
+				_mm_storeu_ps(r + c, col);
+			}
+		}
+
+		/**
+		Two result columns per iteration: columns of A are duplicated in both 128-bit lanes,
+		the B elements are broadcast inside each lane.
+		*/
+		ENGINE_TARGET_AVX2 static ENGINE_INLINE void MulMat4AVX2(float* r, const float* a, const float* b)
+		{
+			__m256 a0 = _mm256_broadcast_ps((const __m128*)(a + 0));
+			__m256 a1 = _mm256_broadcast_ps((const __m128*)(a + 4));
+			__m256 a2 = _mm256_broadcast_ps((const __m128*)(a + 8));
+			__m256 a3 = _mm256_broadcast_ps((const __m128*)(a + 12));
+
+			for (int c = 0; c < 16; c += 8) {
+				__m256 bc = _mm256_loadu_ps(b + c);
+				__m256 col = _mm256_mul_ps(a0, _mm256_permute_ps(bc, _MM_SHUFFLE(0, 0, 0, 0)));
+				col = _mm256_fmadd_ps(a1, _mm256_permute_ps(bc, _MM_SHUFFLE(1, 1, 1, 1)), col);
+				col = _mm256_fmadd_ps(a2, _mm256_permute_ps(bc, _MM_SHUFFLE(2, 2, 2, 2)), col);
+				col = _mm256_fmadd_ps(a3, _mm256_permute_ps(bc, _MM_SHUFFLE(3, 3, 3, 3)), col);
+				_mm256_storeu_ps(r + c, col);
+			}
+		}
+#endif
+
+	private:
+#if MATH_SIMD_X86
+		ENGINE_TARGET_SSE41 static ENGINE_INLINE void _Deinterleave(__m128 a, __m128 b, __m128 c, __m128& x, __m128& y, __m128& z)
+		{
+			__m128 bc = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2));
+			x = _mm_shuffle_ps(a, bc, _MM_SHUFFLE(2, 0, 3, 0));
+			y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+			z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), c, _MM_SHUFFLE(3, 0, 2, 0));
+		}
+
+		ENGINE_TARGET_SSE41 static ENGINE_INLINE void _Interleave(__m128 x, __m128 y, __m128 z, __m128& a, __m128& b, __m128& c)
+		{
+			a = _mm_shuffle_ps(_mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 0, 0, 0)), _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+			b = _mm_shuffle_ps(_mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1)), _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 2, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0));
+			c = _mm_shuffle_ps(_mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2)), _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+		}
+
+		/*
+		_mm256_shuffle_ps works inside 128-bit lanes, so it is the same permutation twice
+		*/
+		ENGINE_TARGET_AVX2 static ENGINE_INLINE void _Deinterleave(__m256 a, __m256 b, __m256 c, __m256& x, __m256& y, __m256& z)
+		{
+			__m256 bc = _mm256_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2));
+			x = _mm256_shuffle_ps(a, bc, _MM_SHUFFLE(2, 0, 3, 0));
+			y = _mm256_shuffle_ps(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm256_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+			z = _mm256_shuffle_ps(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), c, _MM_SHUFFLE(3, 0, 2, 0));
+		}
+
+		ENGINE_TARGET_AVX2 static ENGINE_INLINE void _Interleave(__m256 x, __m256 y, __m256 z, __m256& a, __m256& b, __m256& c)
+		{
+			a = _mm256_shuffle_ps(_mm256_shuffle_ps(x, y, _MM_SHUFFLE(0, 0, 0, 0)), _mm256_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+			b = _mm256_shuffle_ps(_mm256_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1)), _mm256_shuffle_ps(x, y, _MM_SHUFFLE(2, 2, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0));
+			c = _mm256_shuffle_ps(_mm256_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2)), _mm256_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+		}
+#endif
+
+	private:
+		static ENGINE_INLINE Level& _Active() {
+			static Level level = GetSupportedLevel();
+			return level;
+		}
+	};
+}
+
+//***************************************************************************
+/*
+Calls kernel##AVX2 or kernel##SSE41 with the arguments for the active level. The kernels
+process a prefix of the input and return where the scalar tail continues, result is left
+untouched on the scalar level. SIMD_DISPATCH_SSE41 is the same for kernels without an AVX2 version.
+*/
+#if MATH_SIMD_X86
+#define SIMD_DISPATCH(result, kernel, ...) \
+	switch (NGTech::SIMD::GetLevel()) \
+	{ \
+	case NGTech::SIMD::LEVEL_AVX2: result = kernel##AVX2(__VA_ARGS__); break; \
+	case NGTech::SIMD::LEVEL_SSE41: result = kernel##SSE41(__VA_ARGS__); break; \
+	default: break; \
+	}
+#define SIMD_DISPATCH_SSE41(result, kernel, ...) \
+	result = (NGTech::SIMD::GetLevel() >= NGTech::SIMD::LEVEL_SSE41) ? kernel##SSE41(__VA_ARGS__) : result
+#else
+#define SIMD_DISPATCH(result, kernel, ...)
+#define SIMD_DISPATCH_SSE41(result, kernel, ...)
+#endif
+//***************************************************************************
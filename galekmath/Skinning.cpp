@@ -0,0 +1,629 @@
+/* Copyright (C) 2009-2020, Nick Galko Ltd. All rights reserved.
+*
+* This file is part of the NGTech (https://galek.github.io/portfolio/).
+*
+* Your use and or redistribution of this software in source and / or
+* binary form, with or without modification, is subject to: (i) your
+* ongoing acceptance of and compliance with the terms and conditions of
+* the NGTech License Agreement; and (ii) your inclusion of this notice
+* in any version of this software that you use or redistribute.
+* A copy of the NGTech License Agreement is available by contacting
+* Nick Galko Ltd. at https://galek.github.io/portfolio/
+*/
+//***************************************************************************
+#include "Skinning.h"
+#include "Affine3x4.h"
+#include "DualQuat.h"
+#include "Vec3SoA.h"
+#include "FastMath.h"
+#include "Parallel.h"
+//***************************************************************************
+
+namespace NGTech
+{
+	/*
+	Driver shared by SkinLinear and SkinDualQuat. KERNEL has SkinScalar(begin, end) and on x86
+	SkinSSE41(begin, end), SkinAVX2(begin, end), the SIMD ones return the first vertex they did not
+	process. Vertices go in blocks of SKIN_BLOCK to keep the SoA loads aligned.
+	*/
+	static const size_t MIN_VERTICES_PER_THREAD = 8192;
+	static const size_t SKIN_BLOCK = 8;
+
+	template<typename KERNEL>
+	static void _RunSkinning(size_t count, const KERNEL& kernel)
+	{
+		size_t blocks = (count + SKIN_BLOCK - 1) / SKIN_BLOCK;
+		Parallel::For(blocks, MIN_VERTICES_PER_THREAD / SKIN_BLOCK, [&](size_t first, size_t last)
+		{
+			size_t begin = first * SKIN_BLOCK;
+			size_t end = Math::Min(last * SKIN_BLOCK, count);
+			size_t i = begin;
+
+			SIMD_DISPATCH(i, kernel.Skin, begin, end);
+
+			kernel.SkinScalar(i, end);
+		});
+	}
+
+	/*
+	Linear blend skinning. The palette is read as VECTORS float4 per bone:
+	3 rows for Affine3x4, 4 columns for Mat4. The blended matrix is kept as 3x4 rows (r * 4 + c).
+	*/
+	struct _SkinStreams
+	{
+		const Vec3SoA& positions;
+		Vec3SoA& outPositions;
+		const Vec3SoA* normals;
+		Vec3SoA* outNormals;
+		const Vec3SoA* tangents;
+		Vec3SoA* outTangents;
+	};
+
+	template<int VECTORS>
+	static ENGINE_INLINE float _Element(const float* bone, int row, int col) {
+		return (VECTORS == 3) ? bone[row * 4 + col] : bone[col * 4 + row];
+	}
+
+	template<int VECTORS>
+	static void _SkinLinearScalar(const float* palette, const int* indices, const float* weights,
+		const _SkinStreams& s, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			const int* idx = indices + i * 4;
+			const float* w = weights + i * 4;
+
+			float m[12] = { 0 };
+			for (int k = 0; k < 4; k++)
+			{
+				if (k > 0 && w[k] == 0)
+					continue;
+
+				const float* bone = palette + idx[k] * VECTORS * 4;
+				for (int r = 0; r < 3; r++)
+					for (int c = 0; c < 4; c++)
+						m[r * 4 + c] += _Element<VECTORS>(bone, r, c) * w[k];
+			}
+
+			Vec3 p = s.positions.Get(i);
+			s.outPositions.Set(i, Vec3(m[0] * p.x + m[1] * p.y + m[2] * p.z + m[3],
+				m[4] * p.x + m[5] * p.y + m[6] * p.z + m[7],
+				m[8] * p.x + m[9] * p.y + m[10] * p.z + m[11]));
+
+			if (s.normals) {
+				Vec3 n = s.normals->Get(i);
+				s.outNormals->Set(i, Vec3(m[0] * n.x + m[1] * n.y + m[2] * n.z,
+					m[4] * n.x + m[5] * n.y + m[6] * n.z,
+					m[8] * n.x + m[9] * n.y + m[10] * n.z));
+			}
+
+			if (s.tangents) {
+				Vec3 t = s.tangents->Get(i);
+				s.outTangents->Set(i, Vec3(m[0] * t.x + m[1] * t.y + m[2] * t.z,
+					m[4] * t.x + m[5] * t.y + m[6] * t.z,
+					m[8] * t.x + m[9] * t.y + m[10] * t.z));
+			}
+		}
+	}
+
+#if MATH_SIMD_X86
+	/*
+	Every vertex is blended as VECTORS float4, then 4 vertices are transposed into
+	one register per matrix element
+	*/
+	template<int VECTORS>
+	ENGINE_TARGET_SSE41 static ENGINE_INLINE void _BlendSSE41(const float* palette, const int* idx, const float* w, __m128 m[12])
+	{
+		__m128 v[4][4];
+		for (int j = 0; j < 4; j++)
+		{
+			const int* vi = idx + j * 4;
+			const float* vw = w + j * 4;
+
+			__m128 w0 = _mm_set1_ps(vw[0]);
+			const float* bone = palette + vi[0] * VECTORS * 4;
+			for (int c = 0; c < VECTORS; c++)
+				v[j][c] = _mm_mul_ps(_mm_loadu_ps(bone + c * 4), w0);
+
+			for (int k = 1; k < 4; k++)
+			{
+				if (vw[k] == 0)
+					continue;
+
+				__m128 wk = _mm_set1_ps(vw[k]);
+				bone = palette + vi[k] * VECTORS * 4;
+				for (int c = 0; c < VECTORS; c++)
+					v[j][c] = _mm_add_ps(v[j][c], _mm_mul_ps(_mm_loadu_ps(bone + c * 4), wk));
+			}
+		}
+
+		for (int c = 0; c < VECTORS; c++)
+		{
+			__m128 a = v[0][c], b = v[1][c], d = v[2][c], e = v[3][c];
+			_MM_TRANSPOSE4_PS(a, b, d, e);
+			__m128 t[4] = { a, b, d, e };
+
+			// rows give the elements of one row, columns the elements of one column
+			for (int r = 0; r < 4; r++)
+			{
+				if (VECTORS == 3)
+					m[c * 4 + r] = t[r];
+				else if (r < 3)
+					m[r * 4 + c] = t[r];
+			}
+		}
+	}
+
+	ENGINE_TARGET_SSE41 static ENGINE_INLINE void _TransformSSE41(const __m128 m[12], const Vec3SoA& in, Vec3SoA& out, size_t i, bool point)
+	{
+		__m128 x = _mm_load_ps(in.x + i), y = _mm_load_ps(in.y + i), z = _mm_load_ps(in.z + i);
+		__m128 rx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[0], x), _mm_mul_ps(m[1], y)), _mm_mul_ps(m[2], z));
+		__m128 ry = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[4], x), _mm_mul_ps(m[5], y)), _mm_mul_ps(m[6], z));
+		__m128 rz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[8], x), _mm_mul_ps(m[9], y)), _mm_mul_ps(m[10], z));
+
+		if (point) {
+			rx = _mm_add_ps(rx, m[3]);
+			ry = _mm_add_ps(ry, m[7]);
+			rz = _mm_add_ps(rz, m[11]);
+		}
+
+		_mm_store_ps(out.x + i, rx);
+		_mm_store_ps(out.y + i, ry);
+		_mm_store_ps(out.z + i, rz);
+	}
+
+	template<int VECTORS>
+	ENGINE_TARGET_SSE41 static size_t _SkinLinearSSE41(const float* palette, const int* indices, const float* weights,
+		const _SkinStreams& s, size_t begin, size_t end)
+	{
+		size_t i = begin;
+		for (; i + 4 <= end; i += 4)
+		{
+			__m128 m[12];
+			_BlendSSE41<VECTORS>(palette, indices + i * 4, weights + i * 4, m);
+
+			_TransformSSE41(m, s.positions, s.outPositions, i, true);
+			if (s.normals)
+				_TransformSSE41(m, *s.normals, *s.outNormals, i, false);
+			if (s.tangents)
+				_TransformSSE41(m, *s.tangents, *s.outTangents, i, false);
+		}
+		return i;
+	}
+
+	/*
+	Vertices j and j + 4 share a register (one per 128-bit lane), so after
+	SIMD::Transpose4x4 the lanes match the Vec3SoA loads of 8 vertices
+	*/
+	template<int VECTORS>
+	ENGINE_TARGET_AVX2 static ENGINE_INLINE void _BlendAVX2(const float* palette, const int* idx, const float* w, __m256 m[12])
+	{
+		__m256 v[4][4];
+		for (int j = 0; j < 4; j++)
+		{
+			const int* lo = idx + j * 4;
+			const int* hi = idx + (j + 4) * 4;
+			const float* wlo = w + j * 4;
+			const float* whi = w + (j + 4) * 4;
+
+			__m256 w0 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(wlo[0])), _mm_set1_ps(whi[0]), 1);
+			const float* blo = palette + lo[0] * VECTORS * 4;
+			const float* bhi = palette + hi[0] * VECTORS * 4;
+			for (int c = 0; c < VECTORS; c++)
+				v[j][c] = _mm256_mul_ps(SIMD::Load2(blo + c * 4, bhi + c * 4), w0);
+
+			// zero weight bones are skipped like in the scalar code: the lane reads the other
+			// vertex's bone and keeps its sum, so unused indices are never dereferenced
+			for (int k = 1; k < 4; k++)
+			{
+				bool skipLo = (wlo[k] == 0), skipHi = (whi[k] == 0);
+				if (skipLo && skipHi)
+					continue;
+
+				__m256 wk = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(wlo[k])), _mm_set1_ps(whi[k]), 1);
+				__m256 keep = _mm256_cmp_ps(wk, _mm256_setzero_ps(), _CMP_EQ_OQ);
+				blo = palette + (skipLo ? hi[k] : lo[k]) * VECTORS * 4;
+				bhi = palette + (skipHi ? lo[k] : hi[k]) * VECTORS * 4;
+
+				for (int c = 0; c < VECTORS; c++)
+				{
+					__m256 b = SIMD::Load2(blo + c * 4, bhi + c * 4);
+					v[j][c] = _mm256_blendv_ps(_mm256_fmadd_ps(b, wk, v[j][c]), v[j][c], keep);
+				}
+			}
+		}
+
+		for (int c = 0; c < VECTORS; c++)
+		{
+			__m256 t[4] = { v[0][c], v[1][c], v[2][c], v[3][c] };
+			SIMD::Transpose4x4(t[0], t[1], t[2], t[3]);
+
+			for (int r = 0; r < 4; r++)
+			{
+				if (VECTORS == 3)
+					m[c * 4 + r] = t[r];
+				else if (r < 3)
+					m[r * 4 + c] = t[r];
+			}
+		}
+	}
+
+	ENGINE_TARGET_AVX2 static ENGINE_INLINE void _TransformAVX2(const __m256 m[12], const Vec3SoA& in, Vec3SoA& out, size_t i, bool point)
+	{
+		__m256 x = _mm256_load_ps(in.x + i), y = _mm256_load_ps(in.y + i), z = _mm256_load_ps(in.z + i);
+		__m256 rx = _mm256_mul_ps(m[2], z);
+		__m256 ry = _mm256_mul_ps(m[6], z);
+		__m256 rz = _mm256_mul_ps(m[10], z);
+
+		if (point) {
+			rx = _mm256_add_ps(rx, m[3]);
+			ry = _mm256_add_ps(ry, m[7]);
+			rz = _mm256_add_ps(rz, m[11]);
+		}
+
+		_mm256_store_ps(out.x + i, _mm256_fmadd_ps(m[0], x, _mm256_fmadd_ps(m[1], y, rx)));
+		_mm256_store_ps(out.y + i, _mm256_fmadd_ps(m[4], x, _mm256_fmadd_ps(m[5], y, ry)));
+		_mm256_store_ps(out.z + i, _mm256_fmadd_ps(m[8], x, _mm256_fmadd_ps(m[9], y, rz)));
+	}
+
+	template<int VECTORS>
+	ENGINE_TARGET_AVX2 static size_t _SkinLinearAVX2(const float* palette, const int* indices, const float* weights,
+		const _SkinStreams& s, size_t begin, size_t end)
+	{
+		size_t i = begin;
+		for (; i + 8 <= end; i += 8)
+		{
+			__m256 m[12];
+			_BlendAVX2<VECTORS>(palette, indices + i * 4, weights + i * 4, m);
+
+			_TransformAVX2(m, s.positions, s.outPositions, i, true);
+			if (s.normals)
+				_TransformAVX2(m, *s.normals, *s.outNormals, i, false);
+			if (s.tangents)
+				_TransformAVX2(m, *s.tangents, *s.outTangents, i, false);
+		}
+
+		return _SkinLinearSSE41<VECTORS>(palette, indices, weights, s, i, end);
+	}
+#endif
+
+	template<int VECTORS>
+	struct _SkinLinearKernel
+	{
+		const float* palette;
+		const int* indices;
+		const float* weights;
+		const _SkinStreams& s;
+
+		void SkinScalar(size_t begin, size_t end) const {
+			_SkinLinearScalar<VECTORS>(palette, indices, weights, s, begin, end);
+		}
+#if MATH_SIMD_X86
+		size_t SkinSSE41(size_t begin, size_t end) const {
+			return _SkinLinearSSE41<VECTORS>(palette, indices, weights, s, begin, end);
+		}
+		size_t SkinAVX2(size_t begin, size_t end) const {
+			return _SkinLinearAVX2<VECTORS>(palette, indices, weights, s, begin, end);
+		}
+#endif
+	};
+
+	template<int VECTORS>
+	static void _SkinLinear(const float* palette, const int* indices, const float* weights, const _SkinStreams& s)
+	{
+		size_t count = s.positions.Size();
+		ASSERT(!s.normals || (s.outNormals && s.normals->Size() == count), "[Skinning] INVALID NORMALS");
+		ASSERT(!s.tangents || (s.outTangents && s.tangents->Size() == count), "[Skinning] INVALID TANGENTS");
+
+		s.outPositions.Resize(count);
+		if (s.normals)
+			s.outNormals->Resize(count);
+		if (s.tangents)
+			s.outTangents->Resize(count);
+
+		_SkinLinearKernel<VECTORS> kernel = { palette, indices, weights, s };
+		_RunSkinning(count, kernel);
+	}
+
+	/*
+	Dual quaternion skinning. Bones with weight 0 are not read, the others are flipped to the
+	hemisphere of the first used one before blending. The blend is normalized and applied to
+	the position (and normal).
+	*/
+	static void _SkinDualQuatScalar(const DualQuat* palette, const int* indices, const float* weights,
+		const Vec3SoA& pos, Vec3SoA& outPos, const Vec3SoA* nrm, Vec3SoA* outNrm, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			const int* idx = indices + i * 4;
+			const float* w = weights + i * 4;
+
+			const Quat* first = nullptr;
+			DualQuat dq(Quat::ZERO, Quat::ZERO);
+
+			for (int k = 0; k < 4; k++)
+			{
+				if (w[k] == 0)
+					continue;
+
+				const DualQuat& b = palette[idx[k]];
+				if (!first)
+					first = &b.real;
+
+				float d = first->x * b.real.x + first->y * b.real.y + first->z * b.real.z + first->w * b.real.w;
+				float wk = (d < 0) ? -w[k] : w[k];
+				for (int j = 0; j < 4; j++) {
+					dq.real.f[j] += b.real.f[j] * wk;
+					dq.dual.f[j] += b.dual.f[j] * wk;
+				}
+			}
+
+			dq.Normalize();
+
+			outPos.Set(i, dq.TransformPoint(pos.Get(i)));
+			if (nrm)
+				outNrm->Set(i, dq.TransformVector(nrm->Get(i)));
+		}
+	}
+
+#if MATH_SIMD_X86
+	/*
+	Real and dual parts of bone k of 4 vertices as component registers, b[0..3] real xyzw, b[4..7] dual xyzw.
+	Bones with weight 0 are read from palette[0] instead, their index may be anything.
+	*/
+	ENGINE_TARGET_SSE41 static ENGINE_INLINE void _LoadDualQuatsSSE41(const DualQuat* palette, const int* idx, const float* w, int k, __m128 b[8])
+	{
+		const float* b0 = palette[w[k + 0] != 0 ? idx[k + 0] : 0].real.f;
+		const float* b1 = palette[w[k + 4] != 0 ? idx[k + 4] : 0].real.f;
+		const float* b2 = palette[w[k + 8] != 0 ? idx[k + 8] : 0].real.f;
+		const float* b3 = palette[w[k + 12] != 0 ? idx[k + 12] : 0].real.f;
+
+		b[0] = _mm_loadu_ps(b0), b[1] = _mm_loadu_ps(b1), b[2] = _mm_loadu_ps(b2), b[3] = _mm_loadu_ps(b3);
+		b[4] = _mm_loadu_ps(b0 + 4), b[5] = _mm_loadu_ps(b1 + 4), b[6] = _mm_loadu_ps(b2 + 4), b[7] = _mm_loadu_ps(b3 + 4);
+		_MM_TRANSPOSE4_PS(b[0], b[1], b[2], b[3]);
+		_MM_TRANSPOSE4_PS(b[4], b[5], b[6], b[7]);
+	}
+
+	/*
+	Blended and normalized dual quaternion of 4 vertices, c[0..3] real xyzw, c[4..7] dual xyzw.
+	first is the first bone with a weight, d sums in the same order as _SkinDualQuatScalar so the
+	hemisphere choice is the same. A zero blend stays zero like in DualQuat::Normalize,
+	so the vertex passes through.
+	*/
+	ENGINE_TARGET_SSE41 static ENGINE_INLINE void _BlendDualQuatsSSE41(const DualQuat* palette, const int* idx, const float* w, __m128 c[8])
+	{
+		__m128 w0 = _mm_loadu_ps(w + 0), w1 = _mm_loadu_ps(w + 4), w2 = _mm_loadu_ps(w + 8), w3 = _mm_loadu_ps(w + 12);
+		_MM_TRANSPOSE4_PS(w0, w1, w2, w3);
+		__m128 wk[4] = { w0, w1, w2, w3 };
+
+		__m128 zero = _mm_setzero_ps();
+		__m128 b[8];
+		_LoadDualQuatsSSE41(palette, idx, w, 0, b);
+		__m128 first[4] = { b[0], b[1], b[2], b[3] };
+		__m128 found = _mm_cmpneq_ps(wk[0], zero);
+		for (int j = 0; j < 8; j++)
+			c[j] = _mm_mul_ps(b[j], wk[0]);
+
+		for (int k = 1; k < 4; k++)
+		{
+			_LoadDualQuatsSSE41(palette, idx, w, k, b);
+
+			__m128 pick = _mm_andnot_ps(found, _mm_cmpneq_ps(wk[k], zero));
+			for (int j = 0; j < 4; j++)
+				first[j] = _mm_blendv_ps(first[j], b[j], pick);
+			found = _mm_or_ps(found, pick);
+
+			__m128 d = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(first[0], b[0]), _mm_mul_ps(first[1], b[1])), _mm_mul_ps(first[2], b[2])), _mm_mul_ps(first[3], b[3]));
+			__m128 weight = _mm_xor_ps(wk[k], _mm_and_ps(_mm_cmplt_ps(d, zero), _mm_set1_ps(-0.0f)));
+			for (int j = 0; j < 8; j++)
+				c[j] = _mm_add_ps(c[j], _mm_mul_ps(b[j], weight));
+		}
+
+		__m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c[0], c[0]), _mm_mul_ps(c[1], c[1])), _mm_add_ps(_mm_mul_ps(c[2], c[2]), _mm_mul_ps(c[3], c[3])));
+		__m128 inv = _mm_andnot_ps(_mm_cmpeq_ps(len2, _mm_setzero_ps()), FastSIMD::rsqrt(len2));
+		for (int j = 0; j < 8; j++)
+			c[j] = _mm_mul_ps(c[j], inv);
+	}
+
+	/*
+	v + w * t + cross(r, t), t = 2 * cross(r, v)
+	*/
+	ENGINE_TARGET_SSE41 static ENGINE_INLINE void _RotateDualQuatSSE41(const __m128 c[8], __m128& x, __m128& y, __m128& z)
+	{
+		__m128 two = _mm_set1_ps(2.0f);
+		__m128 tx = _mm_mul_ps(two, _mm_sub_ps(_mm_mul_ps(c[1], z), _mm_mul_ps(c[2], y)));
+		__m128 ty = _mm_mul_ps(two, _mm_sub_ps(_mm_mul_ps(c[2], x), _mm_mul_ps(c[0], z)));
+		__m128 tz = _mm_mul_ps(two, _mm_sub_ps(_mm_mul_ps(c[0], y), _mm_mul_ps(c[1], x)));
+		x = _mm_add_ps(_mm_add_ps(x, _mm_mul_ps(c[3], tx)), _mm_sub_ps(_mm_mul_ps(c[1], tz), _mm_mul_ps(c[2], ty)));
+		y = _mm_add_ps(_mm_add_ps(y, _mm_mul_ps(c[3], ty)), _mm_sub_ps(_mm_mul_ps(c[2], tx), _mm_mul_ps(c[0], tz)));
+		z = _mm_add_ps(_mm_add_ps(z, _mm_mul_ps(c[3], tz)), _mm_sub_ps(_mm_mul_ps(c[0], ty), _mm_mul_ps(c[1], tx)));
+	}
+
+	ENGINE_TARGET_SSE41 static size_t _SkinDualQuatSSE41(const DualQuat* palette, const int* indices, const float* weights,
+		const Vec3SoA& pos, Vec3SoA& outPos, const Vec3SoA* nrm, Vec3SoA* outNrm, size_t begin, size_t end)
+	{
+		__m128 two = _mm_set1_ps(2.0f);
+
+		size_t i = begin;
+		for (; i + 4 <= end; i += 4)
+		{
+			__m128 c[8];
+			_BlendDualQuatsSSE41(palette, indices + i * 4, weights + i * 4, c);
+
+			// translation 2 * (rw * d - dw * r + cross(r, d))
+			__m128 tx = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(c[3], c[4]), _mm_mul_ps(c[7], c[0])), _mm_sub_ps(_mm_mul_ps(c[1], c[6]), _mm_mul_ps(c[2], c[5])));
+			__m128 ty = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(c[3], c[5]), _mm_mul_ps(c[7], c[1])), _mm_sub_ps(_mm_mul_ps(c[2], c[4]), _mm_mul_ps(c[0], c[6])));
+			__m128 tz = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(c[3], c[6]), _mm_mul_ps(c[7], c[2])), _mm_sub_ps(_mm_mul_ps(c[0], c[5]), _mm_mul_ps(c[1], c[4])));
+
+			__m128 x = _mm_load_ps(pos.x + i), y = _mm_load_ps(pos.y + i), z = _mm_load_ps(pos.z + i);
+			_RotateDualQuatSSE41(c, x, y, z);
+			_mm_store_ps(outPos.x + i, _mm_add_ps(x, _mm_mul_ps(two, tx)));
+			_mm_store_ps(outPos.y + i, _mm_add_ps(y, _mm_mul_ps(two, ty)));
+			_mm_store_ps(outPos.z + i, _mm_add_ps(z, _mm_mul_ps(two, tz)));
+
+			if (nrm) {
+				x = _mm_load_ps(nrm->x + i), y = _mm_load_ps(nrm->y + i), z = _mm_load_ps(nrm->z + i);
+				_RotateDualQuatSSE41(c, x, y, z);
+				_mm_store_ps(outNrm->x + i, x);
+				_mm_store_ps(outNrm->y + i, y);
+				_mm_store_ps(outNrm->z + i, z);
+			}
+		}
+		return i;
+	}
+
+	/*
+	Bone k of 8 vertices with weights weight, the data is gathered straight into component registers.
+	Lanes with weight 0 gather palette[0].
+	*/
+	ENGINE_TARGET_AVX2 static ENGINE_INLINE void _LoadDualQuatsAVX2(const DualQuat* palette, const int* idx, int k, __m256 weight, __m256 b[8])
+	{
+		const float* base = reinterpret_cast<const float*>(palette);
+		const __m256i stride = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+
+		__m256i used = _mm256_castps_si256(_mm256_cmp_ps(weight, _mm256_setzero_ps(), _CMP_NEQ_UQ));
+		__m256i offset = _mm256_slli_epi32(_mm256_and_si256(_mm256_i32gather_epi32(idx + k, stride, 4), used), 3);
+		for (int j = 0; j < 8; j++)
+			b[j] = _mm256_i32gather_ps(base + j, offset, 4);
+	}
+
+	ENGINE_TARGET_AVX2 static ENGINE_INLINE void _BlendDualQuatsAVX2(const DualQuat* palette, const int* idx, const float* w, __m256 c[8])
+	{
+		const __m256i stride = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+
+		__m256 zero = _mm256_setzero_ps();
+		__m256 b[8];
+		__m256 weight = _mm256_i32gather_ps(w, stride, 4);
+		_LoadDualQuatsAVX2(palette, idx, 0, weight, b);
+		__m256 first[4] = { b[0], b[1], b[2], b[3] };
+		__m256 found = _mm256_cmp_ps(weight, zero, _CMP_NEQ_UQ);
+		for (int j = 0; j < 8; j++)
+			c[j] = _mm256_mul_ps(b[j], weight);
+
+		for (int k = 1; k < 4; k++)
+		{
+			weight = _mm256_i32gather_ps(w + k, stride, 4);
+			_LoadDualQuatsAVX2(palette, idx, k, weight, b);
+
+			__m256 pick = _mm256_andnot_ps(found, _mm256_cmp_ps(weight, zero, _CMP_NEQ_UQ));
+			for (int j = 0; j < 4; j++)
+				first[j] = _mm256_blendv_ps(first[j], b[j], pick);
+			found = _mm256_or_ps(found, pick);
+
+			// no fmadd here, the sign has to match _SkinDualQuatScalar
+			__m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(first[0], b[0]), _mm256_mul_ps(first[1], b[1])), _mm256_mul_ps(first[2], b[2])), _mm256_mul_ps(first[3], b[3]));
+			weight = _mm256_xor_ps(weight, _mm256_and_ps(_mm256_cmp_ps(d, zero, _CMP_LT_OQ), _mm256_set1_ps(-0.0f)));
+			for (int j = 0; j < 8; j++)
+				c[j] = _mm256_fmadd_ps(b[j], weight, c[j]);
+		}
+
+		__m256 len2 = _mm256_fmadd_ps(c[0], c[0], _mm256_fmadd_ps(c[1], c[1], _mm256_fmadd_ps(c[2], c[2], _mm256_mul_ps(c[3], c[3]))));
+		__m256 inv = _mm256_andnot_ps(_mm256_cmp_ps(len2, _mm256_setzero_ps(), _CMP_EQ_OQ), FastSIMD::rsqrt(len2));
+		for (int j = 0; j < 8; j++)
+			c[j] = _mm256_mul_ps(c[j], inv);
+	}
+
+	ENGINE_TARGET_AVX2 static ENGINE_INLINE void _RotateDualQuatAVX2(const __m256 c[8], __m256& x, __m256& y, __m256& z)
+	{
+		__m256 two = _mm256_set1_ps(2.0f);
+		__m256 tx = _mm256_mul_ps(two, _mm256_fmsub_ps(c[1], z, _mm256_mul_ps(c[2], y)));
+		__m256 ty = _mm256_mul_ps(two, _mm256_fmsub_ps(c[2], x, _mm256_mul_ps(c[0], z)));
+		__m256 tz = _mm256_mul_ps(two, _mm256_fmsub_ps(c[0], y, _mm256_mul_ps(c[1], x)));
+		x = _mm256_fmadd_ps(c[3], tx, _mm256_add_ps(x, _mm256_fmsub_ps(c[1], tz, _mm256_mul_ps(c[2], ty))));
+		y = _mm256_fmadd_ps(c[3], ty, _mm256_add_ps(y, _mm256_fmsub_ps(c[2], tx, _mm256_mul_ps(c[0], tz))));
+		z = _mm256_fmadd_ps(c[3], tz, _mm256_add_ps(z, _mm256_fmsub_ps(c[0], ty, _mm256_mul_ps(c[1], tx))));
+	}
+
+	ENGINE_TARGET_AVX2 static size_t _SkinDualQuatAVX2(const DualQuat* palette, const int* indices, const float* weights,
+		const Vec3SoA& pos, Vec3SoA& outPos, const Vec3SoA* nrm, Vec3SoA* outNrm, size_t begin, size_t end)
+	{
+		__m256 two = _mm256_set1_ps(2.0f);
+
+		size_t i = begin;
+		for (; i + 8 <= end; i += 8)
+		{
+			__m256 c[8];
+			_BlendDualQuatsAVX2(palette, indices + i * 4, weights + i * 4, c);
+
+			__m256 tx = _mm256_add_ps(_mm256_fmsub_ps(c[3], c[4], _mm256_mul_ps(c[7], c[0])), _mm256_fmsub_ps(c[1], c[6], _mm256_mul_ps(c[2], c[5])));
+			__m256 ty = _mm256_add_ps(_mm256_fmsub_ps(c[3], c[5], _mm256_mul_ps(c[7], c[1])), _mm256_fmsub_ps(c[2], c[4], _mm256_mul_ps(c[0], c[6])));
+			__m256 tz = _mm256_add_ps(_mm256_fmsub_ps(c[3], c[6], _mm256_mul_ps(c[7], c[2])), _mm256_fmsub_ps(c[0], c[5], _mm256_mul_ps(c[1], c[4])));
+
+			__m256 x = _mm256_load_ps(pos.x + i), y = _mm256_load_ps(pos.y + i), z = _mm256_load_ps(pos.z + i);
+			_RotateDualQuatAVX2(c, x, y, z);
+			_mm256_store_ps(outPos.x + i, _mm256_fmadd_ps(two, tx, x));
+			_mm256_store_ps(outPos.y + i, _mm256_fmadd_ps(two, ty, y));
+			_mm256_store_ps(outPos.z + i, _mm256_fmadd_ps(two, tz, z));
+
+			if (nrm) {
+				x = _mm256_load_ps(nrm->x + i), y = _mm256_load_ps(nrm->y + i), z = _mm256_load_ps(nrm->z + i);
+				_RotateDualQuatAVX2(c, x, y, z);
+				_mm256_store_ps(outNrm->x + i, x);
+				_mm256_store_ps(outNrm->y + i, y);
+				_mm256_store_ps(outNrm->z + i, z);
+			}
+		}
+
+		return _SkinDualQuatSSE41(palette, indices, weights, pos, outPos, nrm, outNrm, i, end);
+	}
+#endif
+
+	struct _SkinDualQuatKernel
+	{
+		const DualQuat* palette;
+		const int* indices;
+		const float* weights;
+		const Vec3SoA& pos;
+		Vec3SoA& outPos;
+		const Vec3SoA* nrm;
+		Vec3SoA* outNrm;
+
+		void SkinScalar(size_t begin, size_t end) const {
+			_SkinDualQuatScalar(palette, indices, weights, pos, outPos, nrm, outNrm, begin, end);
+		}
+#if MATH_SIMD_X86
+		size_t SkinSSE41(size_t begin, size_t end) const {
+			return _SkinDualQuatSSE41(palette, indices, weights, pos, outPos, nrm, outNrm, begin, end);
+		}
+		size_t SkinAVX2(size_t begin, size_t end) const {
+			return _SkinDualQuatAVX2(palette, indices, weights, pos, outPos, nrm, outNrm, begin, end);
+		}
+#endif
+	};
+
+	namespace Utils
+	{
+		void SkinLinear(const Affine3x4* palette, const int* boneIndices, const float* boneWeights,
+			const Vec3SoA& positions, Vec3SoA& outPositions,
+			const Vec3SoA* normals, Vec3SoA* outNormals,
+			const Vec3SoA* tangents, Vec3SoA* outTangents)
+		{
+			_SkinStreams s = { positions, outPositions, normals, outNormals, tangents, outTangents };
+			_SkinLinear<3>(reinterpret_cast<const float*>(palette), boneIndices, boneWeights, s);
+		}
+
+		void SkinLinear(const Mat4* palette, const int* boneIndices, const float* boneWeights,
+			const Vec3SoA& positions, Vec3SoA& outPositions,
+			const Vec3SoA* normals, Vec3SoA* outNormals,
+			const Vec3SoA* tangents, Vec3SoA* outTangents)
+		{
+			_SkinStreams s = { positions, outPositions, normals, outNormals, tangents, outTangents };
+			_SkinLinear<4>(reinterpret_cast<const float*>(palette), boneIndices, boneWeights, s);
+		}
+
+		void SkinDualQuat(const DualQuat* palette, const int* boneIndices, const float* boneWeights,
+			const Vec3SoA& positions, Vec3SoA& outPositions,
+			const Vec3SoA* normals, Vec3SoA* outNormals)
+		{
+			size_t count = positions.Size();
+			ASSERT(!normals || (outNormals && normals->Size() == count), "[Skinning] INVALID NORMALS");
+
+			outPositions.Resize(count);
+			if (normals)
+				outNormals->Resize(count);
+
+			_SkinDualQuatKernel kernel = { palette, boneIndices, boneWeights, positions, outPositions, normals, outNormals };
+			_RunSkinning(count, kernel);
+		}
+	}
+}
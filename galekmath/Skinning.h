@@ -0,0 +1,55 @@
+/* Copyright (C) 2009-2020, Nick Galko Ltd. All rights reserved.
+*
+* This file is part of the NGTech (https://galek.github.io/portfolio/).
+*
+* Your use and or redistribution of this software in source and / or
+* binary form, with or without modification, is subject to: (i) your
+* ongoing acceptance of and compliance with the terms and conditions of
+* the NGTech License Agreement; and (ii) your inclusion of this notice
+* in any version of this software that you use or redistribute.
+* A copy of the NGTech License Agreement is available by contacting
+* Nick Galko Ltd. at https://galek.github.io/portfolio/
+*/
+#pragma once
+
+//***************************************************************************
+#include "MathLib.h"
+//***************************************************************************
+
+namespace NGTech
+{
+	class Affine3x4;
+	class DualQuat;
+	class Vec3SoA;
+
+	namespace Utils
+	{
+		/**
+		Linear blend skinning over SoA vertex streams. Every vertex has 4 bone indices and
+		4 weights (sum 1, unused ones 0) stored one vertex after another. The first index must
+		be valid, the others are not read when their weight is 0. Normals and tangents are optional
+		(nullptr) and transformed by the blended 3x3 part without renormalization.
+		Outputs may be the same containers as inputs.
+		Big meshes are split over the Parallel threads.
+		*/
+		void SkinLinear(const Affine3x4* palette, const int* boneIndices, const float* boneWeights,
+			const Vec3SoA& positions, Vec3SoA& outPositions,
+			const Vec3SoA* normals = nullptr, Vec3SoA* outNormals = nullptr,
+			const Vec3SoA* tangents = nullptr, Vec3SoA* outTangents = nullptr);
+		/**
+		Same with a Mat4 palette, the bottom row is ignored
+		*/
+		void SkinLinear(const Mat4* palette, const int* boneIndices, const float* boneWeights,
+			const Vec3SoA& positions, Vec3SoA& outPositions,
+			const Vec3SoA* normals = nullptr, Vec3SoA* outNormals = nullptr,
+			const Vec3SoA* tangents = nullptr, Vec3SoA* outTangents = nullptr);
+
+		/**
+		Dual quaternion skinning, same vertex layout and threading as SkinLinear, but no index
+		with weight 0 is read, including the first one. Normals are optional (nullptr).
+		*/
+		void SkinDualQuat(const DualQuat* palette, const int* boneIndices, const float* boneWeights,
+			const Vec3SoA& positions, Vec3SoA& outPositions,
+			const Vec3SoA* normals = nullptr, Vec3SoA* outNormals = nullptr);
+	}
+}
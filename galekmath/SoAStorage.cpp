@@ -0,0 +1,93 @@
+/* Copyright (C) 2009-2020, Nick Galko Ltd. All rights reserved.
+*
+* This file is part of the NGTech (https://galek.github.io/portfolio/).
+*
+* Your use and or redistribution of this software in source and / or
+* binary form, with or without modification, is subject to: (i) your
+* ongoing acceptance of and compliance with the terms and conditions of
+* the NGTech License Agreement; and (ii) your inclusion of this notice
+* in any version of this software that you use or redistribute.
+* A copy of the NGTech License Agreement is available by contacting
+* Nick Galko Ltd. at https://galek.github.io/portfolio/
+*/
+//***************************************************************************
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+//***************************************************************************
+#include "SoAStorage.h"
+//***************************************************************************
+
+namespace NGTech
+{
+	static const size_t SOA_ALIGN = 32;				// bytes, one AVX register
+	static const size_t SOA_LANES = SOA_ALIGN / sizeof(float);
+
+	SoAStorage::SoAStorage(size_t components)
+		:m_pMemory(nullptr), m_pData(nullptr), m_Components(components), m_Size(0), m_Stride(0)
+	{}
+
+	SoAStorage::SoAStorage(const SoAStorage& in)
+		:m_pMemory(nullptr), m_pData(nullptr), m_Components(in.m_Components), m_Size(0), m_Stride(0)
+	{
+		*this = in;
+	}
+
+	SoAStorage::~SoAStorage()
+	{
+		free(m_pMemory);
+	}
+
+	SoAStorage& SoAStorage::operator=(const SoAStorage& in)
+	{
+		if (this != &in)
+		{
+			ASSERT(m_Components == in.m_Components, "[SoAStorage] COMPONENT COUNT MISMATCH");
+			Allocate(in.m_Size);
+			for (size_t k = 0; k < m_Components; k++)
+				memcpy(Component(k), in.Component(k), sizeof(float) * m_Size);
+		}
+		return *this;
+	}
+
+	/*
+	One block for all components, every array starts on SOA_ALIGN boundary
+	*/
+	void SoAStorage::Allocate(size_t count)
+	{
+		size_t stride = (count + SOA_LANES - 1) & ~(SOA_LANES - 1);
+		if (stride != m_Stride || !m_pMemory)
+		{
+			free(m_pMemory);
+			m_pMemory = malloc(m_Components * stride * sizeof(float) + SOA_ALIGN);
+			ASSERT(m_pMemory, "[SoAStorage] OUT OF MEMORY");
+			m_Stride = stride;
+		}
+
+		m_pData = (float*)(((uintptr_t)m_pMemory + SOA_ALIGN - 1) & ~(uintptr_t)(SOA_ALIGN - 1));
+		m_Size = count;
+	}
+
+	void SoAStorage::Resize(size_t count)
+	{
+		if (count == m_Size && m_pMemory)
+			return;
+
+		SoAStorage old(m_Components);
+		old.m_pMemory = m_pMemory;
+		old.m_pData = m_pData;
+		old.m_Size = m_Size;
+		old.m_Stride = m_Stride;
+		m_pMemory = nullptr;
+
+		Allocate(count);
+		memset(m_pMemory, 0, m_Components * m_Stride * sizeof(float) + SOA_ALIGN);
+
+		size_t keep = Math::Min(count, old.m_Size);
+		if (keep)
+		{
+			for (size_t k = 0; k < m_Components; k++)
+				memcpy(Component(k), old.Component(k), sizeof(float) * keep);
+		}
+	}
+}
@@ -0,0 +1,60 @@
+/* Copyright (C) 2009-2020, Nick Galko Ltd. All rights reserved.
+*
+* This file is part of the NGTech (https://galek.github.io/portfolio/).
+*
+* Your use and or redistribution of this software in source and / or
+* binary form, with or without modification, is subject to: (i) your
+* ongoing acceptance of and compliance with the terms and conditions of
+* the NGTech License Agreement; and (ii) your inclusion of this notice
+* in any version of this software that you use or redistribute.
+* A copy of the NGTech License Agreement is available by contacting
+* Nick Galko Ltd. at https://galek.github.io/portfolio/
+*/
+#pragma once
+
+//***************************************************************************
+#include "MathLib.h"
+//***************************************************************************
+
+namespace NGTech
+{
+	/**
+	Memory of the structure of arrays containers (Vec3SoA, QuatSoA).
+	One block holds a float array per component, every array starts on a 32-byte boundary
+	and the arrays are padded to a multiple of 8 elements.
+	*/
+	class SoAStorage
+	{
+	public:
+		explicit SoAStorage(size_t components);
+		SoAStorage(const SoAStorage& in);
+		~SoAStorage();
+
+		SoAStorage& operator=(const SoAStorage& in);
+
+		ENGINE_INLINE size_t Size() const {
+			return m_Size;
+		}
+
+		ENGINE_INLINE float* Component(size_t k) const {
+			return m_pData + k * m_Stride;
+		}
+
+		/**
+		Sets the size, contents are undefined
+		*/
+		void Allocate(size_t count);
+
+		/**
+		Keeps the first min(Size(), count) elements, new ones are zero
+		*/
+		void Resize(size_t count);
+
+	private:
+		void* m_pMemory;
+		float* m_pData;
+		size_t m_Components;
+		size_t m_Size;
+		size_t m_Stride;
+	};
+}
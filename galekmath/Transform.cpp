@@ -0,0 +1,438 @@
+/* Copyright (C) 2009-2020, Nick Galko Ltd. All rights reserved.
+*
+* This file is part of the NGTech (https://galek.github.io/portfolio/).
+*
+* Your use and or redistribution of this software in source and / or
+* binary form, with or without modification, is subject to: (i) your
+* ongoing acceptance of and compliance with the terms and conditions of
+* the NGTech License Agreement; and (ii) your inclusion of this notice
+* in any version of this software that you use or redistribute.
+* A copy of the NGTech License Agreement is available by contacting
+* Nick Galko Ltd. at https://galek.github.io/portfolio/
+*/
+//***************************************************************************
+#include "MathLib.h"
+#include "SIMD.h"
+//***************************************************************************
+
+namespace NGTech
+{
+	/*
+	What happens with the 4th component
+	*/
+	enum TransformMode
+	{
+		TRANSFORM_POINT,	// w = 1
+		TRANSFORM_VECTOR,	// w = 0
+		TRANSFORM_COORD		// w = 1, then divided by w
+	};
+
+	template<int MODE>
+	static void _TransformScalar(const float* m, const Vec3* in, Vec3* out, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			float x = in[i].x, y = in[i].y, z = in[i].z;
+
+			float rx = m[0] * x + m[4] * y + m[8] * z;
+			float ry = m[1] * x + m[5] * y + m[9] * z;
+			float rz = m[2] * x + m[6] * y + m[10] * z;
+
+			if (MODE != TRANSFORM_VECTOR) {
+				rx += m[12];
+				ry += m[13];
+				rz += m[14];
+			}
+
+			if (MODE == TRANSFORM_COORD) {
+				float rw = m[3] * x + m[7] * y + m[11] * z + m[15];
+				rx /= rw;
+				ry /= rw;
+				rz /= rw;
+			}
+
+			out[i].x = rx;
+			out[i].y = ry;
+			out[i].z = rz;
+		}
+	}
+
+#if MATH_SIMD_X86
+	/*
+	4 points per iteration, the tail goes to the scalar code
+	*/
+	template<int MODE>
+	ENGINE_TARGET_SSE41 static void _TransformSSE41(const float* m, const Vec3* in, Vec3* out, size_t count)
+	{
+		__m128 m0 = _mm_set1_ps(m[0]), m1 = _mm_set1_ps(m[1]), m2 = _mm_set1_ps(m[2]), m3 = _mm_set1_ps(m[3]);
+		__m128 m4 = _mm_set1_ps(m[4]), m5 = _mm_set1_ps(m[5]), m6 = _mm_set1_ps(m[6]), m7 = _mm_set1_ps(m[7]);
+		__m128 m8 = _mm_set1_ps(m[8]), m9 = _mm_set1_ps(m[9]), m10 = _mm_set1_ps(m[10]), m11 = _mm_set1_ps(m[11]);
+		__m128 m12 = _mm_set1_ps(m[12]), m13 = _mm_set1_ps(m[13]), m14 = _mm_set1_ps(m[14]), m15 = _mm_set1_ps(m[15]);
+
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 x, y, z;
+			SIMD::LoadVec3x4(in[i].f, x, y, z);
+
+			__m128 rx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m0, x), _mm_mul_ps(m4, y)), _mm_mul_ps(m8, z));
+			__m128 ry = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m1, x), _mm_mul_ps(m5, y)), _mm_mul_ps(m9, z));
+			__m128 rz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m2, x), _mm_mul_ps(m6, y)), _mm_mul_ps(m10, z));
+
+			if (MODE != TRANSFORM_VECTOR) {
+				rx = _mm_add_ps(rx, m12);
+				ry = _mm_add_ps(ry, m13);
+				rz = _mm_add_ps(rz, m14);
+			}
+
+			if (MODE == TRANSFORM_COORD) {
+				__m128 rw = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m3, x), _mm_mul_ps(m7, y)), _mm_mul_ps(m11, z)), m15);
+				rx = _mm_div_ps(rx, rw);
+				ry = _mm_div_ps(ry, rw);
+				rz = _mm_div_ps(rz, rw);
+			}
+
+			SIMD::StoreVec3x4(out[i].f, rx, ry, rz);
+		}
+
+		_TransformScalar<MODE>(m, in + i, out + i, count - i);
+	}
+
+	template<int MODE>
+	ENGINE_TARGET_AVX2 static void _TransformAVX2(const float* m, const Vec3* in, Vec3* out, size_t count)
+	{
+		__m256 m0 = _mm256_set1_ps(m[0]), m1 = _mm256_set1_ps(m[1]), m2 = _mm256_set1_ps(m[2]), m3 = _mm256_set1_ps(m[3]);
+		__m256 m4 = _mm256_set1_ps(m[4]), m5 = _mm256_set1_ps(m[5]), m6 = _mm256_set1_ps(m[6]), m7 = _mm256_set1_ps(m[7]);
+		__m256 m8 = _mm256_set1_ps(m[8]), m9 = _mm256_set1_ps(m[9]), m10 = _mm256_set1_ps(m[10]), m11 = _mm256_set1_ps(m[11]);
+		__m256 m12 = _mm256_set1_ps(m[12]), m13 = _mm256_set1_ps(m[13]), m14 = _mm256_set1_ps(m[14]), m15 = _mm256_set1_ps(m[15]);
+
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 x, y, z;
+			SIMD::LoadVec3x8(in[i].f, x, y, z);
+
+			__m256 rx = _mm256_mul_ps(m8, z);
+			__m256 ry = _mm256_mul_ps(m9, z);
+			__m256 rz = _mm256_mul_ps(m10, z);
+
+			if (MODE != TRANSFORM_VECTOR) {
+				rx = _mm256_add_ps(rx, m12);
+				ry = _mm256_add_ps(ry, m13);
+				rz = _mm256_add_ps(rz, m14);
+			}
+
+			rx = _mm256_fmadd_ps(m0, x, _mm256_fmadd_ps(m4, y, rx));
+			ry = _mm256_fmadd_ps(m1, x, _mm256_fmadd_ps(m5, y, ry));
+			rz = _mm256_fmadd_ps(m2, x, _mm256_fmadd_ps(m6, y, rz));
+
+			if (MODE == TRANSFORM_COORD) {
+				__m256 rw = _mm256_fmadd_ps(m3, x, _mm256_fmadd_ps(m7, y, _mm256_fmadd_ps(m11, z, m15)));
+				rx = _mm256_div_ps(rx, rw);
+				ry = _mm256_div_ps(ry, rw);
+				rz = _mm256_div_ps(rz, rw);
+			}
+
+			SIMD::StoreVec3x8(out[i].f, rx, ry, rz);
+		}
+
+		_TransformSSE41<MODE>(m, in + i, out + i, count - i);
+	}
+#endif
+
+	template<int MODE>
+	static void _Transform(const Mat4& m, const Vec3* in, Vec3* out, size_t count)
+	{
+		switch (SIMD::GetLevel())
+		{
+#if MATH_SIMD_X86
+		case SIMD::LEVEL_AVX2: _TransformAVX2<MODE>(m.e, in, out, count); break;
+		case SIMD::LEVEL_SSE41: _TransformSSE41<MODE>(m.e, in, out, count); break;
+#endif
+		default: _TransformScalar<MODE>(m.e, in, out, count); break;
+		}
+	}
+
+	/*
+	Same result as q.toMatrix() * v: t = 2 * cross(q.xyz, v), v' = v + w * t + cross(q.xyz, t)
+	*/
+	static void _RotateScalar(const Quat& q, const Vec3* in, Vec3* out, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			float vx = in[i].x, vy = in[i].y, vz = in[i].z;
+
+			float tx = 2.0f * (q.y * vz - q.z * vy);
+			float ty = 2.0f * (q.z * vx - q.x * vz);
+			float tz = 2.0f * (q.x * vy - q.y * vx);
+
+			out[i].x = vx + q.w * tx + (q.y * tz - q.z * ty);
+			out[i].y = vy + q.w * ty + (q.z * tx - q.x * tz);
+			out[i].z = vz + q.w * tz + (q.x * ty - q.y * tx);
+		}
+	}
+
+	/*
+	translate(t) * R(q) * scale(s), t and s may be nullptr
+	*/
+	static void _QuatTRSScalar(const Vec3* t, const Quat* q, const Vec3* s, Mat4* out, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			float x2 = q[i].x + q[i].x;
+			float y2 = q[i].y + q[i].y;
+			float z2 = q[i].z + q[i].z;
+			float xx = q[i].x * x2;
+			float yy = q[i].y * y2;
+			float zz = q[i].z * z2;
+			float xy = q[i].x * y2;
+			float yz = q[i].y * z2;
+			float xz = q[i].z * x2;
+			float wx = q[i].w * x2;
+			float wy = q[i].w * y2;
+			float wz = q[i].w * z2;
+
+			float sx = s ? s[i].x : Math::ONEFLOAT;
+			float sy = s ? s[i].y : Math::ONEFLOAT;
+			float sz = s ? s[i].z : Math::ONEFLOAT;
+
+			float* r = out[i].e;
+			r[0] = (Math::ONEFLOAT - (yy + zz)) * sx;	r[4] = (xy - wz) * sy;	r[8] = (xz + wy) * sz;
+			r[1] = (xy + wz) * sx;	r[5] = (Math::ONEFLOAT - (xx + zz)) * sy;	r[9] = (yz - wx) * sz;
+			r[2] = (xz - wy) * sx;	r[6] = (yz + wx) * sy;	r[10] = (Math::ONEFLOAT - (xx + yy)) * sz;
+			r[3] = 0;	r[7] = 0;	r[11] = 0;
+
+			r[12] = t ? t[i].x : 0;
+			r[13] = t ? t[i].y : 0;
+			r[14] = t ? t[i].z : 0;
+			r[15] = Math::ONEFLOAT;
+		}
+	}
+
+#if MATH_SIMD_X86
+	ENGINE_TARGET_SSE41 static void _RotateSSE41(const Quat& q, const Vec3* in, Vec3* out, size_t count)
+	{
+		__m128 qx = _mm_set1_ps(q.x), qy = _mm_set1_ps(q.y), qz = _mm_set1_ps(q.z), qw = _mm_set1_ps(q.w);
+		__m128 two = _mm_set1_ps(2.0f);
+
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 vx, vy, vz;
+			SIMD::LoadVec3x4(in[i].f, vx, vy, vz);
+
+			__m128 tx = _mm_mul_ps(two, _mm_sub_ps(_mm_mul_ps(qy, vz), _mm_mul_ps(qz, vy)));
+			__m128 ty = _mm_mul_ps(two, _mm_sub_ps(_mm_mul_ps(qz, vx), _mm_mul_ps(qx, vz)));
+			__m128 tz = _mm_mul_ps(two, _mm_sub_ps(_mm_mul_ps(qx, vy), _mm_mul_ps(qy, vx)));
+
+			__m128 rx = _mm_add_ps(_mm_add_ps(vx, _mm_mul_ps(qw, tx)), _mm_sub_ps(_mm_mul_ps(qy, tz), _mm_mul_ps(qz, ty)));
+			__m128 ry = _mm_add_ps(_mm_add_ps(vy, _mm_mul_ps(qw, ty)), _mm_sub_ps(_mm_mul_ps(qz, tx), _mm_mul_ps(qx, tz)));
+			__m128 rz = _mm_add_ps(_mm_add_ps(vz, _mm_mul_ps(qw, tz)), _mm_sub_ps(_mm_mul_ps(qx, ty), _mm_mul_ps(qy, tx)));
+
+			SIMD::StoreVec3x4(out[i].f, rx, ry, rz);
+		}
+
+		_RotateScalar(q, in + i, out + i, count - i);
+	}
+
+	ENGINE_TARGET_AVX2 static void _RotateAVX2(const Quat& q, const Vec3* in, Vec3* out, size_t count)
+	{
+		__m256 qx = _mm256_set1_ps(q.x), qy = _mm256_set1_ps(q.y), qz = _mm256_set1_ps(q.z), qw = _mm256_set1_ps(q.w);
+		__m256 two = _mm256_set1_ps(2.0f);
+
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 vx, vy, vz;
+			SIMD::LoadVec3x8(in[i].f, vx, vy, vz);
+
+			__m256 tx = _mm256_mul_ps(two, _mm256_fmsub_ps(qy, vz, _mm256_mul_ps(qz, vy)));
+			__m256 ty = _mm256_mul_ps(two, _mm256_fmsub_ps(qz, vx, _mm256_mul_ps(qx, vz)));
+			__m256 tz = _mm256_mul_ps(two, _mm256_fmsub_ps(qx, vy, _mm256_mul_ps(qy, vx)));
+
+			__m256 rx = _mm256_fmadd_ps(qw, tx, _mm256_add_ps(vx, _mm256_fmsub_ps(qy, tz, _mm256_mul_ps(qz, ty))));
+			__m256 ry = _mm256_fmadd_ps(qw, ty, _mm256_add_ps(vy, _mm256_fmsub_ps(qz, tx, _mm256_mul_ps(qx, tz))));
+			__m256 rz = _mm256_fmadd_ps(qw, tz, _mm256_add_ps(vz, _mm256_fmsub_ps(qx, ty, _mm256_mul_ps(qy, tx))));
+
+			SIMD::StoreVec3x8(out[i].f, rx, ry, rz);
+		}
+
+		_RotateSSE41(q, in + i, out + i, count - i);
+	}
+
+	/*
+	4 quaternions are transposed to x, y, z, w registers, the matrix elements
+	are computed for all of them and transposed back column by column
+	*/
+	ENGINE_TARGET_SSE41 static void _QuatTRSSSE41(const Vec3* t, const Quat* q, const Vec3* s, Mat4* out, size_t count)
+	{
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 zero = _mm_setzero_ps();
+
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 x = _mm_loadu_ps(q[i + 0].f), y = _mm_loadu_ps(q[i + 1].f);
+			__m128 z = _mm_loadu_ps(q[i + 2].f), w = _mm_loadu_ps(q[i + 3].f);
+			_MM_TRANSPOSE4_PS(x, y, z, w);
+
+			__m128 x2 = _mm_add_ps(x, x), y2 = _mm_add_ps(y, y), z2 = _mm_add_ps(z, z);
+			__m128 xx = _mm_mul_ps(x, x2), yy = _mm_mul_ps(y, y2), zz = _mm_mul_ps(z, z2);
+			__m128 xy = _mm_mul_ps(x, y2), yz = _mm_mul_ps(y, z2), xz = _mm_mul_ps(z, x2);
+			__m128 wx = _mm_mul_ps(w, x2), wy = _mm_mul_ps(w, y2), wz = _mm_mul_ps(w, z2);
+
+			__m128 c0x = _mm_sub_ps(one, _mm_add_ps(yy, zz)), c0y = _mm_add_ps(xy, wz), c0z = _mm_sub_ps(xz, wy), c0w = zero;
+			__m128 c1x = _mm_sub_ps(xy, wz), c1y = _mm_sub_ps(one, _mm_add_ps(xx, zz)), c1z = _mm_add_ps(yz, wx), c1w = zero;
+			__m128 c2x = _mm_add_ps(xz, wy), c2y = _mm_sub_ps(yz, wx), c2z = _mm_sub_ps(one, _mm_add_ps(xx, yy)), c2w = zero;
+			__m128 c3x = zero, c3y = zero, c3z = zero, c3w = one;
+
+			if (s) {
+				__m128 sx, sy, sz;
+				SIMD::LoadVec3x4(s[i].f, sx, sy, sz);
+				c0x = _mm_mul_ps(c0x, sx); c0y = _mm_mul_ps(c0y, sx); c0z = _mm_mul_ps(c0z, sx);
+				c1x = _mm_mul_ps(c1x, sy); c1y = _mm_mul_ps(c1y, sy); c1z = _mm_mul_ps(c1z, sy);
+				c2x = _mm_mul_ps(c2x, sz); c2y = _mm_mul_ps(c2y, sz); c2z = _mm_mul_ps(c2z, sz);
+			}
+
+			if (t)
+				SIMD::LoadVec3x4(t[i].f, c3x, c3y, c3z);
+
+			_MM_TRANSPOSE4_PS(c0x, c0y, c0z, c0w);
+			_MM_TRANSPOSE4_PS(c1x, c1y, c1z, c1w);
+			_MM_TRANSPOSE4_PS(c2x, c2y, c2z, c2w);
+			_MM_TRANSPOSE4_PS(c3x, c3y, c3z, c3w);
+
+			// after the transpose cN[k] is column N of matrix k
+			__m128 cols[4][4] = {
+				{ c0x, c1x, c2x, c3x },
+				{ c0y, c1y, c2y, c3y },
+				{ c0z, c1z, c2z, c3z },
+				{ c0w, c1w, c2w, c3w }
+			};
+			for (int k = 0; k < 4; k++) {
+				float* r = out[i + k].e;
+				_mm_storeu_ps(r + 0, cols[k][0]);
+				_mm_storeu_ps(r + 4, cols[k][1]);
+				_mm_storeu_ps(r + 8, cols[k][2]);
+				_mm_storeu_ps(r + 12, cols[k][3]);
+			}
+		}
+
+		_QuatTRSScalar(t ? t + i : nullptr, q + i, s ? s + i : nullptr, out + i, count - i);
+	}
+
+	/*
+	Lane 0 holds quaternions 0-3, lane 1 quaternions 4-7
+	*/
+	ENGINE_TARGET_AVX2 static void _QuatTRSAVX2(const Vec3* t, const Quat* q, const Vec3* s, Mat4* out, size_t count)
+	{
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 zero = _mm256_setzero_ps();
+
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 x = SIMD::Load2(q[i + 0].f, q[i + 4].f);
+			__m256 y = SIMD::Load2(q[i + 1].f, q[i + 5].f);
+			__m256 z = SIMD::Load2(q[i + 2].f, q[i + 6].f);
+			__m256 w = SIMD::Load2(q[i + 3].f, q[i + 7].f);
+			SIMD::Transpose4x4(x, y, z, w);
+
+			__m256 x2 = _mm256_add_ps(x, x), y2 = _mm256_add_ps(y, y), z2 = _mm256_add_ps(z, z);
+			__m256 xx = _mm256_mul_ps(x, x2), yy = _mm256_mul_ps(y, y2), zz = _mm256_mul_ps(z, z2);
+			__m256 xy = _mm256_mul_ps(x, y2), yz = _mm256_mul_ps(y, z2), xz = _mm256_mul_ps(z, x2);
+			__m256 wx = _mm256_mul_ps(w, x2), wy = _mm256_mul_ps(w, y2), wz = _mm256_mul_ps(w, z2);
+
+			__m256 c0x = _mm256_sub_ps(one, _mm256_add_ps(yy, zz)), c0y = _mm256_add_ps(xy, wz), c0z = _mm256_sub_ps(xz, wy), c0w = zero;
+			__m256 c1x = _mm256_sub_ps(xy, wz), c1y = _mm256_sub_ps(one, _mm256_add_ps(xx, zz)), c1z = _mm256_add_ps(yz, wx), c1w = zero;
+			__m256 c2x = _mm256_add_ps(xz, wy), c2y = _mm256_sub_ps(yz, wx), c2z = _mm256_sub_ps(one, _mm256_add_ps(xx, yy)), c2w = zero;
+			__m256 c3x = zero, c3y = zero, c3z = zero, c3w = one;
+
+			if (s) {
+				__m256 sx, sy, sz;
+				SIMD::LoadVec3x8(s[i].f, sx, sy, sz);
+				c0x = _mm256_mul_ps(c0x, sx); c0y = _mm256_mul_ps(c0y, sx); c0z = _mm256_mul_ps(c0z, sx);
+				c1x = _mm256_mul_ps(c1x, sy); c1y = _mm256_mul_ps(c1y, sy); c1z = _mm256_mul_ps(c1z, sy);
+				c2x = _mm256_mul_ps(c2x, sz); c2y = _mm256_mul_ps(c2y, sz); c2z = _mm256_mul_ps(c2z, sz);
+			}
+
+			if (t)
+				SIMD::LoadVec3x8(t[i].f, c3x, c3y, c3z);
+
+			SIMD::Transpose4x4(c0x, c0y, c0z, c0w);
+			SIMD::Transpose4x4(c1x, c1y, c1z, c1w);
+			SIMD::Transpose4x4(c2x, c2y, c2z, c2w);
+			SIMD::Transpose4x4(c3x, c3y, c3z, c3w);
+
+			__m256 cols[4][4] = {
+				{ c0x, c1x, c2x, c3x },
+				{ c0y, c1y, c2y, c3y },
+				{ c0z, c1z, c2z, c3z },
+				{ c0w, c1w, c2w, c3w }
+			};
+			for (int k = 0; k < 4; k++) {
+				float* lo = out[i + k].e;
+				float* hi = out[i + k + 4].e;
+				for (int c = 0; c < 4; c++) {
+					_mm_storeu_ps(lo + c * 4, _mm256_castps256_ps128(cols[k][c]));
+					_mm_storeu_ps(hi + c * 4, _mm256_extractf128_ps(cols[k][c], 1));
+				}
+			}
+		}
+
+		_QuatTRSSSE41(t ? t + i : nullptr, q + i, s ? s + i : nullptr, out + i, count - i);
+	}
+#endif
+
+	static void _QuatTRS(const Vec3* t, const Quat* q, const Vec3* s, Mat4* out, size_t count)
+	{
+		switch (SIMD::GetLevel())
+		{
+#if MATH_SIMD_X86
+		case SIMD::LEVEL_AVX2: _QuatTRSAVX2(t, q, s, out, count); break;
+		case SIMD::LEVEL_SSE41: _QuatTRSSSE41(t, q, s, out, count); break;
+#endif
+		default: _QuatTRSScalar(t, q, s, out, count); break;
+		}
+	}
+
+	namespace Utils
+	{
+		void TransformPoints(const Mat4& m, const Vec3* in, Vec3* out, size_t count)
+		{
+			_Transform<TRANSFORM_POINT>(m, in, out, count);
+		}
+
+		void TransformVectors(const Mat4& m, const Vec3* in, Vec3* out, size_t count)
+		{
+			_Transform<TRANSFORM_VECTOR>(m, in, out, count);
+		}
+
+		void TransformCoords(const Mat4& m, const Vec3* in, Vec3* out, size_t count)
+		{
+			_Transform<TRANSFORM_COORD>(m, in, out, count);
+		}
+
+		void RotateVectors(const Quat& q, const Vec3* in, Vec3* out, size_t count)
+		{
+			switch (SIMD::GetLevel())
+			{
+#if MATH_SIMD_X86
+			case SIMD::LEVEL_AVX2: _RotateAVX2(q, in, out, count); break;
+			case SIMD::LEVEL_SSE41: _RotateSSE41(q, in, out, count); break;
+#endif
+			default: _RotateScalar(q, in, out, count); break;
+			}
+		}
+
+		void QuatToMat4(const Quat* in, Mat4* out, size_t count)
+		{
+			_QuatTRS(nullptr, in, nullptr, out, count);
+		}
+
+		void QuatTRSToMat4(const Vec3* translations, const Quat* rotations, const Vec3* scales, Mat4* out, size_t count)
+		{
+			_QuatTRS(translations, rotations, scales, out, count);
+		}
+	}
+}
@@ -0,0 +1,142 @@
+/* Copyright (C) 2009-2020, Nick Galko Ltd. All rights reserved.
+*
+* This file is part of the NGTech (https://galek.github.io/portfolio/).
+*
+* Your use and or redistribution of this software in source and / or
+* binary form, with or without modification, is subject to: (i) your
+* ongoing acceptance of and compliance with the terms and conditions of
+* the NGTech License Agreement; and (ii) your inclusion of this notice
+* in any version of this software that you use or redistribute.
+* A copy of the NGTech License Agreement is available by contacting
+* Nick Galko Ltd. at https://galek.github.io/portfolio/
+*/
+//***************************************************************************
+// Included by MathLib.h with GALEKMATH_HEADER_ONLY, by Vec2.cpp otherwise.
+//***************************************************************************
+
+namespace NGTech
+{
+	//---------------------------------------------------------------------------
+	//Desc: 2D Vector class
+	//---------------------------------------------------------------------------
+	MATH_HEADER_INLINE Vec2::Vec2(const Vec3 &in) {
+		x = in.x;
+		y = in.y;
+	}
+
+	MATH_HEADER_INLINE Vec2::Vec2(const Vec4 &in) {
+		x = in.x;
+		y = in.y;
+	}
+
+	MATH_HEADER_INLINE float &Vec2::operator[](intptr_t index) {
+		return *(index + &x);
+	}
+
+	MATH_HEADER_INLINE float Vec2::operator[](intptr_t index) const {
+		return *(index + &x);
+	}
+
+	MATH_HEADER_INLINE Vec2::operator float*() {
+		return &x;
+	}
+
+	MATH_HEADER_INLINE Vec2::operator const float*() const {
+		return &x;
+	}
+
+	MATH_HEADER_INLINE Vec2 Vec2::operator-() const {
+		return Vec2(-x, -y);
+	}
+
+	MATH_HEADER_INLINE Vec2 Vec2::operator+() const {
+		return *this;
+	}
+
+	MATH_HEADER_INLINE Vec2 &Vec2::operator+=(const Vec2 &v) {
+		x += v.x;
+		y += v.y;
+		return *this;
+	}
+
+	MATH_HEADER_INLINE Vec2 &Vec2::operator-=(const Vec2 &v) {
+		x -= v.x;
+		y -= v.y;
+		return *this;
+	}
+
+	MATH_HEADER_INLINE Vec2 &Vec2::operator*=(const Vec2 &v) {
+		x *= v.x;
+		y *= v.y;
+		return *this;
+	}
+
+	MATH_HEADER_INLINE Vec2 &Vec2::operator/=(const Vec2 &v) {
+		x /= v.x;
+		y /= v.y;
+		return *this;
+	}
+
+	MATH_HEADER_INLINE Vec2 & Vec2::operator*=(const float & v)
+	{
+		x *= v;
+		y *= v;
+		return *this;
+	}
+
+	MATH_HEADER_INLINE bool Vec2::operator==(const Vec2 &v) const {
+		return (x == v.x && y == v.y);
+	}
+
+	MATH_HEADER_INLINE bool Vec2::operator!=(const Vec2 &v) const {
+		return (x != v.x || y != v.y);
+	}
+
+	MATH_HEADER_INLINE Vec2 operator+(const Vec2 &a, const Vec2 &b) {
+		return Vec2(a.x + b.x, a.y + b.y);
+	}
+
+	MATH_HEADER_INLINE Vec2 operator+(const Vec2 &a, float b) {
+		return Vec2(a.x + b, a.y + b);
+	}
+
+	MATH_HEADER_INLINE Vec2 operator-(const Vec2 &a, const Vec2 &b) {
+		return Vec2(a.x - b.x, a.y - b.y);
+	}
+
+	MATH_HEADER_INLINE Vec2 operator*(const Vec2 &a, const Vec2 &b) {
+		return Vec2(a.x * b.x, a.y * b.y);
+	}
+
+	MATH_HEADER_INLINE Vec2 operator*(const Vec2 &v, float c) {
+		return Vec2(v.x * c, v.y * c);
+	}
+
+	MATH_HEADER_INLINE Vec2 operator*(float c, const Vec2 &v) {
+		return Vec2(v.x * c, v.y * c);
+	}
+
+	MATH_HEADER_INLINE Vec2 operator/(const Vec2 &a, const Vec2 &b) {
+		return Vec2(a.x / b.x, a.y / b.y);
+	}
+
+	MATH_HEADER_INLINE Vec2 operator/(const Vec2 &v, float c) {
+		return Vec2(v.x / c, v.y / c);
+	}
+
+	MATH_HEADER_INLINE Vec2 operator/(float c, const Vec2 &v) {
+		return Vec2(v.x / c, v.y / c);
+	}
+
+	MATH_HEADER_INLINE float Vec2::length() {
+		return sqrt(x*x + y * y);
+	}
+
+	MATH_HEADER_INLINE Vec2 Vec2::normalize(const Vec2 &_vec) {
+		Vec2 vec = _vec;
+		auto _length = vec.length();
+		vec.x /= _length;
+		vec.y /= _length;
+		return vec;
+	}
+}
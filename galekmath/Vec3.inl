@@ -0,0 +1,155 @@
+/* Copyright (C) 2009-2020, Nick Galko Ltd. All rights reserved.
+*
+* This file is part of the NGTech (https://galek.github.io/portfolio/).
+*
+* Your use and or redistribution of this software in source and / or
+* binary form, with or without modification, is subject to: (i) your
+* ongoing acceptance of and compliance with the terms and conditions of
+* the NGTech License Agreement; and (ii) your inclusion of this notice
+* in any version of this software that you use or redistribute.
+* A copy of the NGTech License Agreement is available by contacting
+* Nick Galko Ltd. at https://galek.github.io/portfolio/
+*/
+//***************************************************************************
+// Included by MathLib.h with GALEKMATH_HEADER_ONLY, by Vec3.cpp otherwise.
+//***************************************************************************
+
+namespace NGTech
+{
+	/*
+	*/
+	MATH_HEADER_INLINE Vec3::Vec3(const Vec2 &in) {
+		x = in.x;
+		y = in.y;
+		z = 0;
+	}
+
+	MATH_HEADER_INLINE Vec3::Vec3(const Vec4 &in) {
+		x = in.x;
+		y = in.y;
+		z = in.z;
+	}
+
+	MATH_HEADER_INLINE float& Vec3::operator[](intptr_t index) {
+		assert(index < 3);
+		return ((float*)this)[index];
+	}
+
+	MATH_HEADER_INLINE float Vec3::operator[](intptr_t index) const {
+		assert(index < 3);
+		return ((float*)this)[index];
+	}
+
+	MATH_HEADER_INLINE Vec3::operator float*() {
+		return &x;
+	}
+
+	MATH_HEADER_INLINE Vec3::operator const float*() const {
+		return &x;
+	}
+
+	MATH_HEADER_INLINE Vec3 Vec3::operator-() const {
+		return Vec3(-x, -y, -z);
+	}
+
+	MATH_HEADER_INLINE Vec3 Vec3::operator+() const {
+		return *this;
+	}
+
+	MATH_HEADER_INLINE Vec3 &Vec3::operator+=(const Vec3 &v) {
+		x += v.x;
+		y += v.y;
+		z += v.z;
+		return *this;
+	}
+
+	MATH_HEADER_INLINE Vec3 &Vec3::operator-=(const Vec3 &v) {
+		x -= v.x;
+		y -= v.y;
+		z -= v.z;
+		return *this;
+	}
+
+	MATH_HEADER_INLINE Vec3 &Vec3::operator*=(const Vec3 &v) {
+		x *= v.x;
+		y *= v.y;
+		z *= v.z;
+		return *this;
+	}
+
+	MATH_HEADER_INLINE Vec3 &Vec3::operator/=(const Vec3 &v) {
+		x /= v.x;
+		y /= v.y;
+		z /= v.z;
+		return *this;
+	}
+
+	MATH_HEADER_INLINE Vec3 & Vec3::operator*=(const float & v)
+	{
+		x *= v;
+		y *= v;
+		z *= v;
+		return *this;
+	}
+
+	MATH_HEADER_INLINE bool Vec3::operator==(const Vec3 &v) const {
+		return (x == v.x && y == v.y && z == v.z);
+	}
+
+	MATH_HEADER_INLINE bool Vec3::operator!=(const Vec3 &v) const {
+		return (x != v.x || y != v.y || z != v.z);
+	}
+
+	MATH_HEADER_INLINE Vec3 operator+(const Vec3 &a, const Vec3 &b) {
+		return Vec3(a.x + b.x, a.y + b.y, a.z + b.z);
+	}
+
+	MATH_HEADER_INLINE Vec3 operator+(const Vec3 &a, float b) {
+		return Vec3(a.x + b, a.y + b, a.z + b);
+	}
+
+	MATH_HEADER_INLINE Vec3 operator-(const Vec3 &a, const Vec3 &b) {
+		return Vec3(a.x - b.x, a.y - b.y, a.z - b.z);
+	}
+
+	MATH_HEADER_INLINE Vec3 operator*(const Vec3 &a, const Vec3 &b) {
+		return Vec3(a.x * b.x, a.y * b.y, a.z * b.z);
+	}
+
+	MATH_HEADER_INLINE Vec3 operator*(const Vec3 &v, float c) {
+		return Vec3(v.x * c, v.y * c, v.z * c);
+	}
+
+	MATH_HEADER_INLINE Vec3 operator*(float c, const Vec3 &v) {
+		return Vec3(v.x * c, v.y * c, v.z * c);
+	}
+
+	MATH_HEADER_INLINE Vec3 operator/(const Vec3 &a, const Vec3 &b) {
+		return Vec3(a.x / b.x, a.y / b.y, a.z / b.z);
+	}
+
+	MATH_HEADER_INLINE Vec3 operator/(const Vec3 &v, float c) {
+		return Vec3(v.x / c, v.y / c, v.z / c);
+	}
+
+	MATH_HEADER_INLINE Vec3 operator/(float c, const Vec3 &v) {
+		return Vec3(v.x / c, v.y / c, v.z / c);
+	}
+
+	MATH_HEADER_INLINE float Vec3::length() {
+		return sqrt(x*x + y * y + z * z);
+	}
+
+	MATH_HEADER_INLINE Vec3 Vec3::normalize(const Vec3 &_vec) {
+		Vec3 vec = _vec;
+		auto _length = vec.length();
+		vec.x /= _length;
+		vec.y /= _length;
+		vec.z /= _length;
+		return vec;
+	}
+
+	MATH_HEADER_INLINE Vec3 Vec3::cross(const Vec3 &a, const Vec3 &b) {
+		return Vec3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+	}
+}
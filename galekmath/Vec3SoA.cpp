@@ -0,0 +1,425 @@
+/* Copyright (C) 2009-2020, Nick Galko Ltd. All rights reserved.
+*
+* This file is part of the NGTech (https://galek.github.io/portfolio/).
+*
+* Your use and or redistribution of this software in source and / or
+* binary form, with or without modification, is subject to: (i) your
+* ongoing acceptance of and compliance with the terms and conditions of
+* the NGTech License Agreement; and (ii) your inclusion of this notice
+* in any version of this software that you use or redistribute.
+* A copy of the NGTech License Agreement is available by contacting
+* Nick Galko Ltd. at https://galek.github.io/portfolio/
+*/
+//***************************************************************************
+#include "Vec3SoA.h"
+#include "SIMD.h"
+//***************************************************************************
+
+namespace NGTech
+{
+	/*
+	Kernels return how many elements they processed, the rest is done by the scalar loop.
+	Arrays of Vec3SoA are aligned, float* outputs of the user are not.
+	*/
+#if MATH_SIMD_X86
+#define SOA_ARRAY_OP(_name, _sse, _avx) \
+	ENGINE_TARGET_SSE41 static size_t _name##SSE41(const float* a, const float* b, float* out, size_t n) { \
+		size_t i = 0; \
+		for (; i + 4 <= n; i += 4) \
+			_mm_store_ps(out + i, _sse(_mm_load_ps(a + i), _mm_load_ps(b + i))); \
+		return i; \
+	} \
+	ENGINE_TARGET_AVX2 static size_t _name##AVX2(const float* a, const float* b, float* out, size_t n) { \
+		size_t i = 0; \
+		for (; i + 8 <= n; i += 8) \
+			_mm256_store_ps(out + i, _avx(_mm256_load_ps(a + i), _mm256_load_ps(b + i))); \
+		return i; \
+	}
+
+	SOA_ARRAY_OP(_Add, _mm_add_ps, _mm256_add_ps)
+	SOA_ARRAY_OP(_Sub, _mm_sub_ps, _mm256_sub_ps)
+	SOA_ARRAY_OP(_Mul, _mm_mul_ps, _mm256_mul_ps)
+#undef SOA_ARRAY_OP
+
+	ENGINE_TARGET_SSE41 static size_t _MulScalarSSE41(const float* a, float c, float* out, size_t n) {
+		__m128 vc = _mm_set1_ps(c);
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4)
+			_mm_store_ps(out + i, _mm_mul_ps(_mm_load_ps(a + i), vc));
+		return i;
+	}
+
+	ENGINE_TARGET_AVX2 static size_t _MulScalarAVX2(const float* a, float c, float* out, size_t n) {
+		__m256 vc = _mm256_set1_ps(c);
+		size_t i = 0;
+		for (; i + 8 <= n; i += 8)
+			_mm256_store_ps(out + i, _mm256_mul_ps(_mm256_load_ps(a + i), vc));
+		return i;
+	}
+
+	ENGINE_TARGET_SSE41 static size_t _FmaSSE41(const float* a, const float* b, const float* c, float* out, size_t n) {
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4)
+			_mm_store_ps(out + i, _mm_add_ps(_mm_mul_ps(_mm_load_ps(a + i), _mm_load_ps(b + i)), _mm_load_ps(c + i)));
+		return i;
+	}
+
+	ENGINE_TARGET_AVX2 static size_t _FmaAVX2(const float* a, const float* b, const float* c, float* out, size_t n) {
+		size_t i = 0;
+		for (; i + 8 <= n; i += 8)
+			_mm256_store_ps(out + i, _mm256_fmadd_ps(_mm256_load_ps(a + i), _mm256_load_ps(b + i), _mm256_load_ps(c + i)));
+		return i;
+	}
+
+	ENGINE_TARGET_SSE41 static size_t _DotSSE41(const Vec3SoA& a, const Vec3SoA& b, float* out, size_t n) {
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4) {
+			__m128 d = _mm_mul_ps(_mm_load_ps(a.x + i), _mm_load_ps(b.x + i));
+			d = _mm_add_ps(d, _mm_mul_ps(_mm_load_ps(a.y + i), _mm_load_ps(b.y + i)));
+			d = _mm_add_ps(d, _mm_mul_ps(_mm_load_ps(a.z + i), _mm_load_ps(b.z + i)));
+			_mm_storeu_ps(out + i, d);
+		}
+		return i;
+	}
+
+	ENGINE_TARGET_AVX2 static size_t _DotAVX2(const Vec3SoA& a, const Vec3SoA& b, float* out, size_t n) {
+		size_t i = 0;
+		for (; i + 8 <= n; i += 8) {
+			__m256 d = _mm256_mul_ps(_mm256_load_ps(a.x + i), _mm256_load_ps(b.x + i));
+			d = _mm256_fmadd_ps(_mm256_load_ps(a.y + i), _mm256_load_ps(b.y + i), d);
+			d = _mm256_fmadd_ps(_mm256_load_ps(a.z + i), _mm256_load_ps(b.z + i), d);
+			_mm256_storeu_ps(out + i, d);
+		}
+		return i;
+	}
+
+	ENGINE_TARGET_SSE41 static size_t _CrossSSE41(const Vec3SoA& a, const Vec3SoA& b, Vec3SoA& out, size_t n) {
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4) {
+			__m128 ax = _mm_load_ps(a.x + i), ay = _mm_load_ps(a.y + i), az = _mm_load_ps(a.z + i);
+			__m128 bx = _mm_load_ps(b.x + i), by = _mm_load_ps(b.y + i), bz = _mm_load_ps(b.z + i);
+			_mm_store_ps(out.x + i, _mm_sub_ps(_mm_mul_ps(ay, bz), _mm_mul_ps(az, by)));
+			_mm_store_ps(out.y + i, _mm_sub_ps(_mm_mul_ps(az, bx), _mm_mul_ps(ax, bz)));
+			_mm_store_ps(out.z + i, _mm_sub_ps(_mm_mul_ps(ax, by), _mm_mul_ps(ay, bx)));
+		}
+		return i;
+	}
+
+	ENGINE_TARGET_AVX2 static size_t _CrossAVX2(const Vec3SoA& a, const Vec3SoA& b, Vec3SoA& out, size_t n) {
+		size_t i = 0;
+		for (; i + 8 <= n; i += 8) {
+			__m256 ax = _mm256_load_ps(a.x + i), ay = _mm256_load_ps(a.y + i), az = _mm256_load_ps(a.z + i);
+			__m256 bx = _mm256_load_ps(b.x + i), by = _mm256_load_ps(b.y + i), bz = _mm256_load_ps(b.z + i);
+			_mm256_store_ps(out.x + i, _mm256_fmsub_ps(ay, bz, _mm256_mul_ps(az, by)));
+			_mm256_store_ps(out.y + i, _mm256_fmsub_ps(az, bx, _mm256_mul_ps(ax, bz)));
+			_mm256_store_ps(out.z + i, _mm256_fmsub_ps(ax, by, _mm256_mul_ps(ay, bx)));
+		}
+		return i;
+	}
+
+	ENGINE_TARGET_SSE41 static size_t _LengthSSE41(const Vec3SoA& a, float* out, size_t n) {
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4) {
+			__m128 x = _mm_load_ps(a.x + i), y = _mm_load_ps(a.y + i), z = _mm_load_ps(a.z + i);
+			__m128 sq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+			_mm_storeu_ps(out + i, _mm_sqrt_ps(sq));
+		}
+		return i;
+	}
+
+	ENGINE_TARGET_AVX2 static size_t _LengthAVX2(const Vec3SoA& a, float* out, size_t n) {
+		size_t i = 0;
+		for (; i + 8 <= n; i += 8) {
+			__m256 x = _mm256_load_ps(a.x + i), y = _mm256_load_ps(a.y + i), z = _mm256_load_ps(a.z + i);
+			__m256 sq = _mm256_fmadd_ps(x, x, _mm256_fmadd_ps(y, y, _mm256_mul_ps(z, z)));
+			_mm256_storeu_ps(out + i, _mm256_sqrt_ps(sq));
+		}
+		return i;
+	}
+
+	/*
+	Full precision sqrt and divide without fma, same results as Vec3::normalize
+	*/
+	ENGINE_TARGET_SSE41 static size_t _NormalizeSSE41(const Vec3SoA& a, Vec3SoA& out, size_t n) {
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4) {
+			__m128 x = _mm_load_ps(a.x + i), y = _mm_load_ps(a.y + i), z = _mm_load_ps(a.z + i);
+			__m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+			_mm_store_ps(out.x + i, _mm_div_ps(x, len));
+			_mm_store_ps(out.y + i, _mm_div_ps(y, len));
+			_mm_store_ps(out.z + i, _mm_div_ps(z, len));
+		}
+		return i;
+	}
+
+	ENGINE_TARGET_AVX2 static size_t _NormalizeAVX2(const Vec3SoA& a, Vec3SoA& out, size_t n) {
+		size_t i = 0;
+		for (; i + 8 <= n; i += 8) {
+			__m256 x = _mm256_load_ps(a.x + i), y = _mm256_load_ps(a.y + i), z = _mm256_load_ps(a.z + i);
+			__m256 len = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z)));
+			_mm256_store_ps(out.x + i, _mm256_div_ps(x, len));
+			_mm256_store_ps(out.y + i, _mm256_div_ps(y, len));
+			_mm256_store_ps(out.z + i, _mm256_div_ps(z, len));
+		}
+		return i;
+	}
+
+	ENGINE_TARGET_SSE41 static size_t _FromVec3SSE41(const Vec3* in, Vec3SoA& out, size_t n) {
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4) {
+			__m128 x, y, z;
+			SIMD::LoadVec3x4(in[i].f, x, y, z);
+			_mm_store_ps(out.x + i, x);
+			_mm_store_ps(out.y + i, y);
+			_mm_store_ps(out.z + i, z);
+		}
+		return i;
+	}
+
+	ENGINE_TARGET_AVX2 static size_t _FromVec3AVX2(const Vec3* in, Vec3SoA& out, size_t n) {
+		size_t i = 0;
+		for (; i + 8 <= n; i += 8) {
+			__m256 x, y, z;
+			SIMD::LoadVec3x8(in[i].f, x, y, z);
+			_mm256_store_ps(out.x + i, x);
+			_mm256_store_ps(out.y + i, y);
+			_mm256_store_ps(out.z + i, z);
+		}
+		return i;
+	}
+
+	ENGINE_TARGET_SSE41 static size_t _ToVec3SSE41(const Vec3SoA& in, Vec3* out, size_t n) {
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4)
+			SIMD::StoreVec3x4(out[i].f, _mm_load_ps(in.x + i), _mm_load_ps(in.y + i), _mm_load_ps(in.z + i));
+		return i;
+	}
+
+	ENGINE_TARGET_AVX2 static size_t _ToVec3AVX2(const Vec3SoA& in, Vec3* out, size_t n) {
+		size_t i = 0;
+		for (; i + 8 <= n; i += 8)
+			SIMD::StoreVec3x8(out[i].f, _mm256_load_ps(in.x + i), _mm256_load_ps(in.y + i), _mm256_load_ps(in.z + i));
+		return i;
+	}
+
+#endif
+
+	/*
+	*/
+	static void _AddArray(const float* a, const float* b, float* out, size_t n) {
+		size_t i = 0;
+		SIMD_DISPATCH(i, _Add, a, b, out, n);
+		for (; i < n; i++) out[i] = a[i] + b[i];
+	}
+
+	static void _SubArray(const float* a, const float* b, float* out, size_t n) {
+		size_t i = 0;
+		SIMD_DISPATCH(i, _Sub, a, b, out, n);
+		for (; i < n; i++) out[i] = a[i] - b[i];
+	}
+
+	static void _MulArray(const float* a, const float* b, float* out, size_t n) {
+		size_t i = 0;
+		SIMD_DISPATCH(i, _Mul, a, b, out, n);
+		for (; i < n; i++) out[i] = a[i] * b[i];
+	}
+
+	static void _MulArray(const float* a, float c, float* out, size_t n) {
+		size_t i = 0;
+		SIMD_DISPATCH(i, _MulScalar, a, c, out, n);
+		for (; i < n; i++) out[i] = a[i] * c;
+	}
+
+	static void _FmaArray(const float* a, const float* b, const float* c, float* out, size_t n) {
+		size_t i = 0;
+		SIMD_DISPATCH(i, _Fma, a, b, c, out, n);
+		for (; i < n; i++) out[i] = a[i] * b[i] + c[i];
+	}
+
+	/*
+	*/
+	Vec3SoA::Vec3SoA()
+		:x(nullptr), y(nullptr), z(nullptr), m_Storage(3)
+	{}
+
+	Vec3SoA::Vec3SoA(size_t count)
+		:x(nullptr), y(nullptr), z(nullptr), m_Storage(3)
+	{
+		Resize(count);
+	}
+
+	Vec3SoA::Vec3SoA(const Vec3* in, size_t count)
+		:x(nullptr), y(nullptr), z(nullptr), m_Storage(3)
+	{
+		FromVec3(in, count);
+	}
+
+	Vec3SoA::Vec3SoA(const Vec3SoA& in)
+		:x(nullptr), y(nullptr), z(nullptr), m_Storage(in.m_Storage)
+	{
+		_Bind();
+	}
+
+	Vec3SoA::~Vec3SoA()
+	{}
+
+	Vec3SoA& Vec3SoA::operator=(const Vec3SoA& in)
+	{
+		m_Storage = in.m_Storage;
+		_Bind();
+		return *this;
+	}
+
+	void Vec3SoA::_Allocate(size_t count)
+	{
+		m_Storage.Allocate(count);
+		_Bind();
+	}
+
+	void Vec3SoA::_Bind()
+	{
+		x = m_Storage.Component(0);
+		y = m_Storage.Component(1);
+		z = m_Storage.Component(2);
+	}
+
+	void Vec3SoA::Resize(size_t count)
+	{
+		m_Storage.Resize(count);
+		_Bind();
+	}
+
+	void Vec3SoA::FromVec3(const Vec3* in, size_t count)
+	{
+		_Allocate(count);
+
+		size_t i = 0;
+		SIMD_DISPATCH(i, _FromVec3, in, *this, count);
+		for (; i < count; i++) {
+			x[i] = in[i].x;
+			y[i] = in[i].y;
+			z[i] = in[i].z;
+		}
+	}
+
+	void Vec3SoA::ToVec3(Vec3* out) const
+	{
+		size_t i = 0;
+		SIMD_DISPATCH(i, _ToVec3, *this, out, Size());
+		for (; i < Size(); i++)
+			out[i].Set(x[i], y[i], z[i]);
+	}
+
+	Vec3SoA& Vec3SoA::operator+=(const Vec3SoA& v) {
+		add(*this, v, *this);
+		return *this;
+	}
+
+	Vec3SoA& Vec3SoA::operator-=(const Vec3SoA& v) {
+		sub(*this, v, *this);
+		return *this;
+	}
+
+	Vec3SoA& Vec3SoA::operator*=(const Vec3SoA& v) {
+		mul(*this, v, *this);
+		return *this;
+	}
+
+	Vec3SoA& Vec3SoA::operator*=(float v) {
+		mul(*this, v, *this);
+		return *this;
+	}
+
+	void Vec3SoA::length(float* out) const
+	{
+		size_t i = 0;
+		SIMD_DISPATCH(i, _Length, *this, out, Size());
+		for (; i < Size(); i++)
+			out[i] = sqrt(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+	}
+
+	void Vec3SoA::Normalize()
+	{
+		normalize(*this, *this);
+	}
+
+	void Vec3SoA::add(const Vec3SoA& a, const Vec3SoA& b, Vec3SoA& out)
+	{
+		ASSERT(a.Size() == b.Size(), "[Vec3SoA] SIZE MISMATCH");
+		out.Resize(a.Size());
+		_AddArray(a.x, b.x, out.x, a.Size());
+		_AddArray(a.y, b.y, out.y, a.Size());
+		_AddArray(a.z, b.z, out.z, a.Size());
+	}
+
+	void Vec3SoA::sub(const Vec3SoA& a, const Vec3SoA& b, Vec3SoA& out)
+	{
+		ASSERT(a.Size() == b.Size(), "[Vec3SoA] SIZE MISMATCH");
+		out.Resize(a.Size());
+		_SubArray(a.x, b.x, out.x, a.Size());
+		_SubArray(a.y, b.y, out.y, a.Size());
+		_SubArray(a.z, b.z, out.z, a.Size());
+	}
+
+	void Vec3SoA::mul(const Vec3SoA& a, const Vec3SoA& b, Vec3SoA& out)
+	{
+		ASSERT(a.Size() == b.Size(), "[Vec3SoA] SIZE MISMATCH");
+		out.Resize(a.Size());
+		_MulArray(a.x, b.x, out.x, a.Size());
+		_MulArray(a.y, b.y, out.y, a.Size());
+		_MulArray(a.z, b.z, out.z, a.Size());
+	}
+
+	void Vec3SoA::mul(const Vec3SoA& a, float c, Vec3SoA& out)
+	{
+		out.Resize(a.Size());
+		_MulArray(a.x, c, out.x, a.Size());
+		_MulArray(a.y, c, out.y, a.Size());
+		_MulArray(a.z, c, out.z, a.Size());
+	}
+
+	void Vec3SoA::fma(const Vec3SoA& a, const Vec3SoA& b, const Vec3SoA& c, Vec3SoA& out)
+	{
+		ASSERT(a.Size() == b.Size() && a.Size() == c.Size(), "[Vec3SoA] SIZE MISMATCH");
+		out.Resize(a.Size());
+		_FmaArray(a.x, b.x, c.x, out.x, a.Size());
+		_FmaArray(a.y, b.y, c.y, out.y, a.Size());
+		_FmaArray(a.z, b.z, c.z, out.z, a.Size());
+	}
+
+	void Vec3SoA::dot(const Vec3SoA& a, const Vec3SoA& b, float* out)
+	{
+		ASSERT(a.Size() == b.Size(), "[Vec3SoA] SIZE MISMATCH");
+		size_t i = 0, n = a.Size();
+		SIMD_DISPATCH(i, _Dot, a, b, out, n);
+		for (; i < n; i++)
+			out[i] = a.x[i] * b.x[i] + a.y[i] * b.y[i] + a.z[i] * b.z[i];
+	}
+
+	void Vec3SoA::cross(const Vec3SoA& a, const Vec3SoA& b, Vec3SoA& out)
+	{
+		ASSERT(a.Size() == b.Size(), "[Vec3SoA] SIZE MISMATCH");
+		out.Resize(a.Size());
+
+		size_t i = 0, n = a.Size();
+		SIMD_DISPATCH(i, _Cross, a, b, out, n);
+		for (; i < n; i++) {
+			Vec3 c = Vec3::cross(a.Get(i), b.Get(i));
+			out.Set(i, c);
+		}
+	}
+
+	void Vec3SoA::normalize(const Vec3SoA& a, Vec3SoA& out)
+	{
+		out.Resize(a.Size());
+
+		size_t i = 0, n = a.Size();
+		SIMD_DISPATCH(i, _Normalize, a, out, n);
+		for (; i < n; i++) {
+			float len = sqrt(a.x[i] * a.x[i] + a.y[i] * a.y[i] + a.z[i] * a.z[i]);
+			out.x[i] = a.x[i] / len;
+			out.y[i] = a.y[i] / len;
+			out.z[i] = a.z[i] / len;
+		}
+	}
+}
@@ -0,0 +1,101 @@
+/* Copyright (C) 2009-2020, Nick Galko Ltd. All rights reserved.
+*
+* This file is part of the NGTech (https://galek.github.io/portfolio/).
+*
+* Your use and or redistribution of this software in source and / or
+* binary form, with or without modification, is subject to: (i) your
+* ongoing acceptance of and compliance with the terms and conditions of
+* the NGTech License Agreement; and (ii) your inclusion of this notice
+* in any version of this software that you use or redistribute.
+* A copy of the NGTech License Agreement is available by contacting
+* Nick Galko Ltd. at https://galek.github.io/portfolio/
+*/
+#pragma once
+
+//***************************************************************************
+#include "MathLib.h"
+#include "SoAStorage.h"
+//***************************************************************************
+
+namespace NGTech
+{
+	/**
+	Array of Vec3 stored as structure of arrays.
+	x, y, z are separate 32-byte aligned arrays, so the bulk operations
+	process 4 (SSE4.1) or 8 (AVX2) vectors per instruction.
+	Output may be one of the inputs, sizes of all operands must match.
+	*/
+	class Vec3SoA
+	{
+	public:
+		float* x;
+		float* y;
+		float* z;
+
+		Vec3SoA();
+		explicit Vec3SoA(size_t count);
+		Vec3SoA(const Vec3* in, size_t count);
+		Vec3SoA(const Vec3SoA& in);
+		~Vec3SoA();
+
+		Vec3SoA& operator=(const Vec3SoA& in);
+
+		ENGINE_INLINE size_t Size() const {
+			return m_Storage.Size();
+		}
+
+		/**
+		Keeps the first min(Size(), count) elements, new ones are zero
+		*/
+		void Resize(size_t count);
+
+		ENGINE_INLINE Vec3 Get(size_t i) const {
+			ASSERT(i < Size(), "[Vec3SoA] INDEX OUT OF RANGE");
+			return Vec3(x[i], y[i], z[i]);
+		}
+
+		ENGINE_INLINE void Set(size_t i, const Vec3& v) {
+			ASSERT(i < Size(), "[Vec3SoA] INDEX OUT OF RANGE");
+			x[i] = v.x;
+			y[i] = v.y;
+			z[i] = v.z;
+		}
+
+		/**
+		Conversion from/to packed Vec3 arrays. FromVec3 resizes the container
+		*/
+		void FromVec3(const Vec3* in, size_t count);
+		void ToVec3(Vec3* out) const;
+
+		Vec3SoA& operator+=(const Vec3SoA& v);
+		Vec3SoA& operator-=(const Vec3SoA& v);
+		Vec3SoA& operator*=(const Vec3SoA& v);
+		Vec3SoA& operator*=(float v);
+
+		/**
+		Writes Size() lengths to out
+		*/
+		void length(float* out) const;
+		void Normalize();
+
+		static void add(const Vec3SoA& a, const Vec3SoA& b, Vec3SoA& out);
+		static void sub(const Vec3SoA& a, const Vec3SoA& b, Vec3SoA& out);
+		static void mul(const Vec3SoA& a, const Vec3SoA& b, Vec3SoA& out);
+		static void mul(const Vec3SoA& a, float c, Vec3SoA& out);
+		/**
+		out = a * b + c
+		*/
+		static void fma(const Vec3SoA& a, const Vec3SoA& b, const Vec3SoA& c, Vec3SoA& out);
+
+		static void dot(const Vec3SoA& a, const Vec3SoA& b, float* out);
+		static void cross(const Vec3SoA& a, const Vec3SoA& b, Vec3SoA& out);
+		static void normalize(const Vec3SoA& a, Vec3SoA& out);
+
+	private:
+		void _Allocate(size_t count);
+		void _Bind();
+
+	private:
+		SoAStorage m_Storage;
+	};
+}